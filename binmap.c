@@ -0,0 +1,85 @@
+// binmap.c
+// precomputed FFT bin → display column / octave band maps
+
+#include "binmap.h"
+#include <math.h>
+
+// bin k covers [(k - 0.5) * bin_hz, (k + 0.5) * bin_hz), the spans start at bin 1 (DC is not a band)
+static void set_span(binmap *m, int i, float f_lo, float f_hi, float bin_hz, int nbins, int average) {
+    float a = f_lo / bin_hz + 0.5f;
+    float b = f_hi / bin_hz + 0.5f;
+    float top = (float)nbins;
+
+    if (a < 1.0f)
+        a = 1.0f;
+    if (b > top)
+        b = top;
+    if (b <= a)
+        b = a + 1e-3f; // keep at least a sliver of one bin
+
+    int first = (int)floorf(a);
+    int last = (int)ceilf(b) - 1;
+    if (last < first)
+        last = first;
+
+    binmap_entry *e = &m->entry[i];
+    e->start = (uint16_t)first;
+    e->count = (uint16_t)(last - first + 1);
+    if (first == last) {
+        e->w_first = (uint16_t)lrintf((b - a) * 4096.0f);
+        e->w_last = e->w_first;
+    } else {
+        e->w_first = (uint16_t)lrintf((first + 1 - a) * 4096.0f);
+        e->w_last = (uint16_t)lrintf((b - last) * 4096.0f);
+    }
+    m->gain[i] = average ? 1.0f / (b - a) : 1.0f;
+    m->freq[i] = sqrtf(f_lo * f_hi);
+}
+
+void binmap_log(binmap *m, int cols, float f_min, float f_max, float bin_hz, int nbins) {
+    if (cols > BINMAP_MAX_ENTRIES)
+        cols = BINMAP_MAX_ENTRIES;
+
+    float ratio = powf(f_max / f_min, 1.0f / cols);
+    float f_lo = f_min;
+    for (int i = 0; i < cols; i++) {
+        float f_hi = f_lo * ratio;
+        set_span(m, i, f_lo, f_hi, bin_hz, nbins, 1);
+        f_lo = f_hi;
+    }
+    m->count = cols;
+}
+
+void binmap_octave(binmap *m, int fraction, float f_min, float f_max, float bin_hz, int nbins) {
+    float half = powf(2.0f, 0.5f / fraction); // band edge / center
+    int n = 0;
+
+    // band index k : center = 1kHz * 2^(k / fraction)
+    int k = (int)floorf(fraction * log2f(f_min / 1000.0f));
+    for (;; k++) {
+        float fc = 1000.0f * powf(2.0f, (float)k / fraction);
+        if (fc * half <= f_min)
+            continue;
+        if (fc > f_max || n >= BINMAP_MAX_ENTRIES)
+            break;
+        set_span(m, n++, fc / half, fc * half, bin_hz, nbins, 0);
+        m->freq[n - 1] = fc;
+    }
+    m->count = n;
+}
+
+void binmap_apply(const binmap *m, const float *power, float *out) {
+    const binmap_entry *e = m->entry;
+
+    for (int i = 0; i < m->count; i++, e++) {
+        const float *p = power + e->start;
+        float sum = p[0] * e->w_first;
+        if (e->count > 1) {
+            float mid = 0.0f;
+            for (int k = 1; k < e->count - 1; k++)
+                mid += p[k];
+            sum += mid * 4096.0f + p[e->count - 1] * e->w_last;
+        }
+        out[i] = sum * (m->gain[i] * (1.0f / 4096.0f));
+    }
+}
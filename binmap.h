@@ -0,0 +1,46 @@
+// binmap.h
+// precomputed FFT bin → display column / octave band maps
+// Each entry covers a run of bins, only the first & last bins are partially weighted,
+// so one frame costs one linear sweep over the power spectrum
+
+#ifndef BINMAP_H
+#define BINMAP_H
+
+#include <stdint.h>
+
+#define BINMAP_MAX_ENTRIES 256
+
+// One column / band : power = gain * (w_first * p[start] + p[start+1] + ... + w_last * p[start+count-1])
+typedef struct {
+    uint16_t start;     // first bin
+    uint16_t count;     // number of bins (1 or more)
+    uint16_t w_first;   // weight of the first bin, 4096 = 1.0
+    uint16_t w_last;    // weight of the last bin (count > 1), 4096 = 1.0
+} binmap_entry;
+
+typedef struct {
+    binmap_entry entry[BINMAP_MAX_ENTRIES];
+    float gain[BINMAP_MAX_ENTRIES]; // per entry gain (1 / width for an average, 1 for a band power)
+    float freq[BINMAP_MAX_ENTRIES]; // center frequency of each entry [Hz]
+    int count;          // number of entries
+} binmap;
+
+// Function to build a logarithmic frequency axis
+// cols: number of display columns (up to BINMAP_MAX_ENTRIES)
+// f_min, f_max: frequency range [Hz]
+// bin_hz: FFT bin width [Hz]
+// nbins: number of bins in the power spectrum
+// Each column shows the average power of its frequency span
+void binmap_log(binmap *m, int cols, float f_min, float f_max, float bin_hz, int nbins);
+
+// Function to build a fractional octave band map (base 2, centered on 1kHz)
+// fraction: 1, 3 or 6 for 1/1, 1/3 and 1/6 octave bands
+// Each band shows the total power of the bins inside the band
+void binmap_octave(binmap *m, int fraction, float f_min, float f_max, float bin_hz, int nbins);
+
+// Function to aggregate a power spectrum with a map
+// power: power spectrum (linear, not dB)
+// out: m->count aggregated powers
+void binmap_apply(const binmap *m, const float *power, float *out);
+
+#endif // BINMAP_H
@@ -0,0 +1,134 @@
+// capcodec.c
+// lossless compression of 12bit ADC captures
+// stream : first sample (16bit LE), then per group a 4bit width w and the group's zigzag deltas in w bits each
+
+#include "capcodec.h"
+
+#define CAPCODEC_MASK 0x0FFF
+#define CAPCODEC_MAX_WIDTH 13   // zigzag of a 12bit delta (-4095 ~ 4095)
+
+// LSB first bit writer
+typedef struct {
+    uint8_t *buf;
+    int size;
+    int pos;            // byte position
+    uint32_t acc;       // pending bits
+    int bits;           // number of pending bits
+} bit_writer;
+
+typedef struct {
+    const uint8_t *buf;
+    int size;
+    int pos;
+    uint32_t acc;
+    int bits;
+} bit_reader;
+
+static int bw_put(bit_writer *w, uint32_t value, int bits) {
+    w->acc |= value << w->bits;
+    w->bits += bits;
+    while (w->bits >= 8) {
+        if (w->pos >= w->size)
+            return -1;
+        w->buf[w->pos++] = (uint8_t)w->acc;
+        w->acc >>= 8;
+        w->bits -= 8;
+    }
+    return 0;
+}
+
+static int br_get(bit_reader *r, int bits, uint32_t *value) {
+    while (r->bits < bits) {
+        if (r->pos >= r->size)
+            return -1;
+        r->acc |= (uint32_t)r->buf[r->pos++] << r->bits;
+        r->bits += 8;
+    }
+    *value = r->acc & ((1u << bits) - 1);
+    r->acc >>= bits;
+    r->bits -= bits;
+    return 0;
+}
+
+// the shift is done unsigned, a left shift of a negative int32 is undefined
+static inline uint32_t zigzag(int32_t d) {
+    return ((uint32_t)d << 1) ^ (uint32_t)(d >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t z) {
+    return (int32_t)(z >> 1) ^ -(int32_t)(z & 1);
+}
+
+int capcodec_encode(const uint16_t *in, int count, uint8_t *out, int out_size) {
+    if (count <= 0)
+        return 0;
+    if (out_size < 2)
+        return -1;
+
+    int32_t prev = in[0] & CAPCODEC_MASK;
+    out[0] = (uint8_t)prev;
+    out[1] = (uint8_t)(prev >> 8);
+
+    bit_writer w = {out, out_size, 2, 0, 0};
+    uint32_t z[CAPCODEC_GROUP];
+
+    for (int i = 1; i < count; i += CAPCODEC_GROUP) {
+        int n = count - i < CAPCODEC_GROUP ? count - i : CAPCODEC_GROUP;
+
+        // deltas of the group & the width of the largest one
+        uint32_t all = 0;
+        for (int k = 0; k < n; k++) {
+            int32_t cur = in[i + k] & CAPCODEC_MASK;
+            z[k] = zigzag(cur - prev);
+            all |= z[k];
+            prev = cur;
+        }
+        int width = 0;
+        while (all >> width)
+            width++;
+
+        if (bw_put(&w, (uint32_t)width, 4) < 0)
+            return -1;
+        if (width > 0) {
+            for (int k = 0; k < n; k++)
+                if (bw_put(&w, z[k], width) < 0)
+                    return -1;
+        }
+    }
+
+    // flush the last partial byte
+    if (w.bits > 0 && bw_put(&w, 0, 8 - w.bits) < 0)
+        return -1;
+    return w.pos;
+}
+
+int capcodec_decode(const uint8_t *in, int in_len, uint16_t *out, int count) {
+    if (count <= 0)
+        return 0;
+    if (in_len < 2)
+        return -1;
+
+    int32_t prev = (in[0] | in[1] << 8) & CAPCODEC_MASK;
+    out[0] = (uint16_t)prev;
+
+    bit_reader r = {in, in_len, 2, 0, 0};
+
+    for (int i = 1; i < count; i += CAPCODEC_GROUP) {
+        int n = count - i < CAPCODEC_GROUP ? count - i : CAPCODEC_GROUP;
+
+        uint32_t width;
+        if (br_get(&r, 4, &width) < 0 || width > CAPCODEC_MAX_WIDTH)
+            return -1;
+
+        for (int k = 0; k < n; k++) {
+            uint32_t v = 0;
+            if (width > 0 && br_get(&r, (int)width, &v) < 0)
+                return -1;
+            prev += unzigzag(v);
+            if (prev < 0 || prev > CAPCODEC_MASK)
+                return -1;
+            out[i + k] = (uint16_t)prev;
+        }
+    }
+    return count;
+}
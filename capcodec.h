@@ -0,0 +1,29 @@
+// capcodec.h
+// lossless compression of 12bit ADC captures : delta + zigzag + bit packing per group
+// Each group of CAPCODEC_GROUP deltas is stored with the bit width of its largest value,
+// so quiet signals take a few bits per sample and the worst case is 13 bits per sample
+
+#ifndef CAPCODEC_H
+#define CAPCODEC_H
+
+#include <stdint.h>
+
+#define CAPCODEC_GROUP 32
+
+// Worst case encoded size [bytes] of count samples : 2 bytes first sample, 4 + 13 * 32 bits per group
+#define CAPCODEC_MAX_BYTES(count) (2 + (((count) + CAPCODEC_GROUP - 1) / CAPCODEC_GROUP) * (4 + 13 * CAPCODEC_GROUP + 7) / 8 + 1)
+
+// Function to encode 12bit samples
+// in: samples (0 ~ 4095, upper bits are ignored)
+// count: number of samples
+// out: output buffer, out_size: its size [bytes]
+// Returns: encoded size [bytes], -1 if out_size is too small
+int capcodec_encode(const uint16_t *in, int count, uint8_t *out, int out_size);
+
+// Function to decode samples written by capcodec_encode()
+// in: encoded data, in_len: its size [bytes]
+// out: decoded samples, count: number of samples to decode
+// Returns: number of samples decoded, -1 if the data is truncated or corrupt
+int capcodec_decode(const uint8_t *in, int in_len, uint16_t *out, int count);
+
+#endif // CAPCODEC_H
@@ -0,0 +1,190 @@
+// capstore.c
+// ring of capture records in a flash region
+
+#include "capstore.h"
+#include <stddef.h>
+#include <string.h>
+
+#define HDR_SIZE ((uint32_t)sizeof(capstore_header))
+
+uint32_t capstore_crc32(const uint8_t *data, uint32_t len) {
+    uint32_t crc = 0xFFFFFFFFu;
+    for (uint32_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++)
+            crc = (crc >> 1) ^ (0xEDB88320u & -(crc & 1));
+    }
+    return ~crc;
+}
+
+static uint32_t record_sectors(const capstore *st, uint32_t length) {
+    return (HDR_SIZE + length + st->flash.sector - 1) / st->flash.sector;
+}
+
+static uint32_t record_end(const capstore *st, uint32_t offset) {
+    const capstore_header *h = (const capstore_header *)(st->flash.base + offset);
+    return offset + record_sectors(st, h->length) * st->flash.sector;
+}
+
+static bool header_valid(const capstore *st, uint32_t offset) {
+    const capstore_header *h = (const capstore_header *)(st->flash.base + offset);
+    if (h->magic != CAPSTORE_MAGIC)
+        return false;
+    if (h->hdr_crc != capstore_crc32((const uint8_t *)h, offsetof(capstore_header, hdr_crc)))
+        return false;
+    return h->length <= st->flash.size - offset - HDR_SIZE;
+}
+
+static uint32_t header_seq(const capstore *st, uint32_t offset) {
+    return ((const capstore_header *)(st->flash.base + offset))->seq;
+}
+
+// drop the records overlapping [start, end)
+static void drop_range(capstore *st, uint32_t start, uint32_t end) {
+    int n = 0;
+    for (int i = 0; i < st->count; i++) {
+        uint32_t off = st->index[i];
+        if (off < end && record_end(st, off) > start)
+            continue;
+        st->index[n++] = off;
+    }
+    st->count = n;
+}
+
+bool capstore_init(capstore *st, const capstore_flash *flash) {
+    memset(st, 0, sizeof(*st));
+    st->flash = *flash;
+    if (flash->page > sizeof(st->page_buf) || flash->page == 0 || flash->sector % flash->page != 0 ||
+        flash->size % flash->sector != 0 || flash->size / flash->sector > CAPSTORE_MAX_RECORDS)
+        return false;
+
+    // headers at every sector start, oldest first
+    for (uint32_t off = 0; off < flash->size; off += flash->sector) {
+        if (!header_valid(st, off))
+            continue;
+        int i = st->count++;
+        while (i > 0 && header_seq(st, st->index[i - 1]) > header_seq(st, off)) {
+            st->index[i] = st->index[i - 1];
+            i--;
+        }
+        st->index[i] = off;
+    }
+
+    // a record partly erased by a newer one is gone
+    int n = 0;
+    for (int i = st->count - 1; i >= 0; i--) {
+        uint32_t off = st->index[i];
+        uint32_t end = record_end(st, off);
+        bool overlapped = false;
+        for (int k = st->count - n; k < st->count; k++) {
+            if (st->index[k] < end && record_end(st, st->index[k]) > off)
+                overlapped = true;
+        }
+        if (!overlapped)
+            st->index[st->count - 1 - n++] = off;
+    }
+    memmove(st->index, st->index + st->count - n, n * sizeof(st->index[0]));
+    st->count = n;
+
+    if (n > 0) {
+        uint32_t last = st->index[n - 1];
+        st->next_seq = header_seq(st, last) + 1;
+        st->head = record_end(st, last) % flash->size;
+    }
+    return true;
+}
+
+bool capstore_begin(capstore *st, const uint8_t *data, uint32_t length, uint16_t samples, uint16_t mode, uint32_t time_us) {
+    uint32_t sectors = record_sectors(st, length);
+    if (st->writing || sectors * st->flash.sector > st->flash.size)
+        return false;
+
+    if (st->head + sectors * st->flash.sector > st->flash.size)
+        st->head = 0;
+
+    st->data = data;
+    st->hdr.magic = CAPSTORE_MAGIC;
+    st->hdr.seq = st->next_seq;
+    st->hdr.length = length;
+    st->hdr.crc = capstore_crc32(data, length);
+    st->hdr.samples = samples;
+    st->hdr.mode = mode;
+    st->hdr.time_us = time_us;
+    st->hdr.hdr_crc = capstore_crc32((const uint8_t *)&st->hdr, offsetof(capstore_header, hdr_crc));
+
+    st->wr_offset = st->head;
+    st->wr_sectors = sectors;
+    st->wr_step = 0;
+    st->writing = true;
+
+    // the sectors are about to be erased
+    drop_range(st, st->wr_offset, st->wr_offset + sectors * st->flash.sector);
+    return true;
+}
+
+// page p of the record stream (header + payload), padded with the erased value
+static void fill_page(capstore *st, uint32_t p) {
+    uint32_t page = st->flash.page;
+    uint32_t total = HDR_SIZE + st->hdr.length;
+    const uint8_t *hdr = (const uint8_t *)&st->hdr;
+
+    memset(st->page_buf, 0xFF, page);
+    for (uint32_t i = 0; i < page; i++) {
+        uint32_t pos = p * page + i;
+        if (pos >= total)
+            break;
+        st->page_buf[i] = pos < HDR_SIZE ? hdr[pos] : st->data[pos - HDR_SIZE];
+    }
+}
+
+bool capstore_step(capstore *st) {
+    if (!st->writing)
+        return true;
+
+    uint32_t pages = (HDR_SIZE + st->hdr.length + st->flash.page - 1) / st->flash.page;
+    uint32_t step = st->wr_step++;
+    bool ok;
+
+    if (step < st->wr_sectors) {
+        ok = st->flash.erase(st->flash.ctx, st->wr_offset + step * st->flash.sector, st->flash.sector);
+    } else {
+        // pages 1 .. pages-1 first, page 0 (header) last
+        uint32_t p = step - st->wr_sectors + 1;
+        if (p == pages)
+            p = 0;
+        fill_page(st, p);
+        ok = st->flash.program(st->flash.ctx, st->wr_offset + p * st->flash.page, st->page_buf, st->flash.page);
+        if (ok && p == 0) {
+            if (st->count == CAPSTORE_MAX_RECORDS)
+                drop_range(st, st->index[0], st->index[0] + 1);
+            st->index[st->count++] = st->wr_offset;
+            st->next_seq++;
+            st->head = (st->wr_offset + st->wr_sectors * st->flash.sector) % st->flash.size;
+            st->writing = false;
+            return true;
+        }
+    }
+
+    if (!ok) {
+        st->errors++;
+        st->writing = false;
+        return true;
+    }
+    return false;
+}
+
+bool capstore_busy(const capstore *st) {
+    return st->writing;
+}
+
+const capstore_header *capstore_get(const capstore *st, int n, const uint8_t **payload) {
+    if (n < 0 || n >= st->count)
+        return NULL;
+    const capstore_header *h = (const capstore_header *)(st->flash.base + st->index[n]);
+    const uint8_t *data = (const uint8_t *)h + HDR_SIZE;
+    if (h->crc != capstore_crc32(data, h->length))
+        return NULL;
+    if (payload != NULL)
+        *payload = data;
+    return h;
+}
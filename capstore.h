@@ -0,0 +1,85 @@
+// capstore.h
+// ring of capture records in a flash region
+// Records start on a sector boundary, the first page (header + start of the payload) is programmed
+// last so a record interrupted by a reset is never seen as valid. Writing is split into steps of
+// one sector erase or one page program, so it can run between captures
+// Portable : the flash is accessed through callbacks (pico flash API on the target, RAM on a host)
+
+#ifndef CAPSTORE_H
+#define CAPSTORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CAPSTORE_MAGIC 0x52504143u   // "CAPR"
+#define CAPSTORE_MAX_RECORDS 256
+
+// Erase len bytes at offset (sector aligned) of the region
+typedef bool (*capstore_erase_fn)(void *ctx, uint32_t offset, uint32_t len);
+
+// Program len bytes at offset (page aligned, len = page size) of the region
+typedef bool (*capstore_program_fn)(void *ctx, uint32_t offset, const uint8_t *data, uint32_t len);
+
+typedef struct {
+    const uint8_t *base;        // memory mapped region for reads (XIP on the pico)
+    uint32_t size;              // region size, multiple of sector
+    uint32_t sector;            // erase size (4096)
+    uint32_t page;              // program size (256)
+    capstore_erase_fn erase;
+    capstore_program_fn program;
+    void *ctx;
+} capstore_flash;
+
+// Record header at the start of the first sector
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;               // increases with every record
+    uint32_t length;            // payload size [bytes]
+    uint32_t crc;               // CRC32 of the payload
+    uint16_t samples;           // number of samples
+    uint16_t mode;              // user tag (spectrum / oscilloscope capture)
+    uint32_t time_us;           // capture time stamp
+    uint32_t hdr_crc;           // CRC32 of the fields above
+} capstore_header;
+
+typedef struct {
+    capstore_flash flash;
+    uint32_t index[CAPSTORE_MAX_RECORDS]; // record offsets, oldest first
+    int count;                  // number of valid records
+    uint32_t next_seq;
+    uint32_t head;              // offset of the next record
+    // record being written
+    const uint8_t *data;        // payload (kept by the caller until the record is done)
+    capstore_header hdr;
+    uint32_t wr_offset;         // record offset
+    uint32_t wr_sectors;        // sectors of the record
+    uint32_t wr_step;           // next step : erase sectors, program pages 1.., then page 0
+    bool writing;
+    uint32_t errors;            // failed erase / program operations
+    uint8_t page_buf[256];
+} capstore;
+
+// Function to scan the region for valid records
+// Returns: false if the geometry is not supported (page > 256, size not a multiple of sector)
+bool capstore_init(capstore *st, const capstore_flash *flash);
+
+// Function to start writing a record, the oldest records are overwritten when the ring is full
+// data: payload, must stay valid until capstore_step() returns true
+// Returns: false if a record is being written or the payload is larger than the region
+bool capstore_begin(capstore *st, const uint8_t *data, uint32_t length, uint16_t samples, uint16_t mode, uint32_t time_us);
+
+// Function to run one flash operation (one sector erase or one page program) of the record
+// Returns: true when the record is complete or was dropped after a flash error (errors is counted)
+bool capstore_step(capstore *st);
+
+// Function to check if a record is being written
+bool capstore_busy(const capstore *st);
+
+// Function to get a record, 0 = oldest
+// Returns: header in the flash, NULL if there is no such record or its payload CRC is wrong
+const capstore_header *capstore_get(const capstore *st, int n, const uint8_t **payload);
+
+// CRC32 (IEEE) of a buffer
+uint32_t capstore_crc32(const uint8_t *data, uint32_t len);
+
+#endif // CAPSTORE_H
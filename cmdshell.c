@@ -0,0 +1,157 @@
+// cmdshell.c
+// line based command shell & parameter registry
+// A set is range checked, stored, then apply() re-inits the dependent state, all in the caller's context
+
+#include "cmdshell.h"
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void shell_init(shell *sh, const shell_param *params, int count, shell_print_fn print, void (*stats)(void)) {
+    sh->params = params;
+    sh->count = count;
+    sh->print = print;
+    sh->stats = stats;
+    sh->len = 0;
+    sh->overflow = false;
+}
+
+const shell_param *shell_find(const shell *sh, const char *name) {
+    for (int i = 0; i < sh->count; i++)
+        if (strcmp(sh->params[i].name, name) == 0)
+            return &sh->params[i];
+    return NULL;
+}
+
+static void print_param(shell *sh, const shell_param *p, bool detail) {
+    char text[96];
+    char range[24];
+    if (!detail) {
+        snprintf(text, sizeof(text), "%s = %d\n", p->name, *p->value);
+    } else {
+        if (p->flags & SHELL_RO)
+            snprintf(range, sizeof(range), "read only");
+        else
+            snprintf(range, sizeof(range), "[%d..%d]", p->min, p->max);
+        snprintf(text, sizeof(text), "%-10s %6d  %-12s %s\n", p->name, *p->value, range, p->help);
+    }
+    sh->print(text);
+}
+
+// integer in decimal or 0x hex, the whole token must be a number that fits an int
+static bool parse_int(const char *s, int *out) {
+    char *end;
+    errno = 0;
+    long v = strtol(s, &end, 0);
+    if (end == s || *end != '\0' || errno == ERANGE || v < INT_MIN || v > INT_MAX)
+        return false;
+    *out = (int)v;
+    return true;
+}
+
+static int cmd_set(shell *sh, const char *name, const char *arg) {
+    char text[64];
+    const shell_param *p = shell_find(sh, name);
+    int v;
+
+    if (p == NULL) {
+        sh->print("error : unknown parameter\n");
+        return SHELL_ERROR;
+    }
+    if (p->flags & SHELL_RO) {
+        sh->print("error : read only\n");
+        return SHELL_ERROR;
+    }
+    if (arg == NULL || !parse_int(arg, &v)) {
+        sh->print("error : value expected\n");
+        return SHELL_ERROR;
+    }
+    if (v < p->min || v > p->max) {
+        snprintf(text, sizeof(text), "error : out of range [%d..%d]\n", p->min, p->max);
+        sh->print(text);
+        return SHELL_ERROR;
+    }
+
+    *p->value = v;
+    if (p->apply != NULL)
+        p->apply();
+    print_param(sh, p, false);
+    return SHELL_SET;
+}
+
+int shell_exec(shell *sh, char *line) {
+    char *argv[4];
+    int argc = 0;
+
+    for (char *tok = strtok(line, " \t"); tok != NULL && argc < 4; tok = strtok(NULL, " \t"))
+        argv[argc++] = tok;
+    if (argc == 0)
+        return SHELL_NONE;
+
+    if (strcmp(argv[0], "help") == 0) {
+        sh->print("list | get <name> | set <name> <value> | stats\n");
+        return SHELL_DONE;
+    }
+    if (strcmp(argv[0], "list") == 0) {
+        for (int i = 0; i < sh->count; i++)
+            print_param(sh, &sh->params[i], true);
+        return SHELL_DONE;
+    }
+    if (strcmp(argv[0], "get") == 0 && argc >= 2) {
+        const shell_param *p = shell_find(sh, argv[1]);
+        if (p == NULL) {
+            sh->print("error : unknown parameter\n");
+            return SHELL_ERROR;
+        }
+        print_param(sh, p, false);
+        return SHELL_DONE;
+    }
+    if (strcmp(argv[0], "set") == 0 && argc >= 2)
+        return cmd_set(sh, argv[1], argc >= 3 ? argv[2] : NULL);
+    if (strcmp(argv[0], "stats") == 0 && sh->stats != NULL) {
+        sh->stats();
+        return SHELL_DONE;
+    }
+
+    sh->print("error : unknown command, try help\n");
+    return SHELL_ERROR;
+}
+
+int shell_input(shell *sh, int c) {
+    char echo[2] = {(char)c, '\0'};
+
+    if (c == '\r' || c == '\n') {
+        int result = SHELL_NONE;
+        sh->line[sh->len] = '\0';
+        if (sh->overflow) {
+            sh->print("\nerror : line too long\n");
+            result = SHELL_ERROR;
+        } else if (sh->len > 0) {
+            sh->print("\n");
+            result = shell_exec(sh, sh->line);
+        }
+        sh->len = 0;
+        sh->overflow = false;
+        return result;
+    }
+
+    if (c == '\b' || c == 0x7F) {
+        if (sh->len > 0) {
+            sh->len--;
+            sh->print("\b \b");
+        }
+        return SHELL_NONE;
+    }
+
+    if (c < ' ' || c > '~')
+        return SHELL_NONE;
+    if (sh->len >= SHELL_LINE_MAX - 1) {
+        sh->overflow = true;
+        return SHELL_NONE;
+    }
+    sh->line[sh->len++] = (char)c;
+    sh->print(echo);
+    return SHELL_NONE;
+}
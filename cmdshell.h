@@ -0,0 +1,63 @@
+// cmdshell.h
+// line based command shell for the USB CDC link : list / get / set of a parameter registry & stage timings
+// Non blocking, characters are fed one at a time from the main loop
+// Portable, the parser & registry build on a host
+
+#ifndef CMDSHELL_H
+#define CMDSHELL_H
+
+#include <stdbool.h>
+
+#define SHELL_LINE_MAX 48
+
+// Parameter flags
+#define SHELL_RO 1  // read only (compile time buffer size or screen format)
+
+typedef struct {
+    const char *name;
+    volatile int *value;
+    int min;
+    int max;
+    int flags;
+    void (*apply)(void);    // re-init of the state depending on the value, called after a set (NULL : none)
+    const char *help;
+} shell_param;
+
+// Output of the shell (NUL terminated text)
+typedef void (*shell_print_fn)(const char *text);
+
+typedef struct {
+    const shell_param *params;
+    int count;
+    shell_print_fn print;
+    void (*stats)(void);    // "stats" command (NULL : not available)
+    char line[SHELL_LINE_MAX];
+    int len;
+    bool overflow;          // the current line is too long, it is dropped at the end of line
+} shell;
+
+// Results of shell_input() / shell_exec()
+#define SHELL_NONE 0    // no complete line yet (or an empty line)
+#define SHELL_DONE 1    // a command was run
+#define SHELL_SET 2     // a parameter was changed & applied
+#define SHELL_ERROR 3   // unknown command, parameter or value
+
+// Function to initialize the shell
+// params: parameter registry (kept by reference)
+// print: output function
+// stats: function printing the stage timings for "stats", may be NULL
+void shell_init(shell *sh, const shell_param *params, int count, shell_print_fn print, void (*stats)(void));
+
+// Function to feed one input character (echoed), the line runs on CR or LF
+// Returns: SHELL_NONE until a line is complete, then the result of the command
+int shell_input(shell *sh, int c);
+
+// Function to run one command line (modified in place)
+// Commands: help, list, get <name>, set <name> <value>, stats
+int shell_exec(shell *sh, char *line);
+
+// Function to find a parameter by name
+// Returns: the parameter, NULL if unknown
+const shell_param *shell_find(const shell *sh, const char *name);
+
+#endif // CMDSHELL_H
@@ -0,0 +1,174 @@
+// distortion.c
+// THD / SNR / SINAD / ENOB measurement on the power spectrum
+// phases : peak search -> bin classification -> power integration -> result
+
+#include "distortion.h"
+#include <math.h>
+#include <string.h>
+
+enum { PHASE_IDLE, PHASE_PEAK, PHASE_CLASSIFY, PHASE_SUM };
+enum { BIN_NOISE, BIN_DC, BIN_FUND, BIN_HARM };
+
+#define DIST_DB_MAX 120.0f // used when a power is zero
+
+void dist_init(dist_state *st, int nbins, int leak_bins, int harmonics) {
+    memset(st, 0, sizeof(*st));
+    st->nbins = nbins > DIST_MAX_BINS ? DIST_MAX_BINS : nbins;
+    st->leak_bins = leak_bins;
+    st->harmonics = harmonics > DIST_MAX_HARMONICS ? DIST_MAX_HARMONICS : harmonics;
+    st->phase = PHASE_IDLE;
+}
+
+static void dist_begin(dist_state *st) {
+    st->phase = PHASE_PEAK;
+    st->pos = st->leak_bins + 1; // DC leakage is not a candidate
+    st->peak_bin = st->pos;
+    st->peak = 0.0f;
+}
+
+void dist_start_f32(dist_state *st, const float *power) {
+    for (int i = 0; i < st->nbins; i++)
+        st->power[i] = power[i] < 0.0f ? 0.0f : power[i];
+    dist_begin(st);
+}
+
+bool dist_busy(const dist_state *st) {
+    return st->phase != PHASE_IDLE;
+}
+
+// mark +-leak_bins around center, bins already marked keep their class
+static void mark_tone(dist_state *st, int center, uint8_t cls) {
+    for (int k = center - st->leak_bins; k <= center + st->leak_bins; k++) {
+        if (k >= 0 && k < st->nbins && st->bin_class[k] == BIN_NOISE)
+            st->bin_class[k] = cls;
+    }
+}
+
+// harmonic position folded back into 0 ~ nbins (aliasing of the decimated stream)
+static int fold_bin(int k, int nbins) {
+    int period = 2 * nbins;
+    k %= period;
+    if (k > nbins)
+        k = period - k;
+    return k;
+}
+
+static void classify(dist_state *st) {
+    memset(st->bin_class, BIN_NOISE, sizeof(st->bin_class));
+    mark_tone(st, 0, BIN_DC);
+    mark_tone(st, st->peak_bin, BIN_FUND);
+
+    for (int h = 2; h < st->harmonics + 2; h++) {
+        int k = fold_bin(h * st->peak_bin, st->nbins);
+        if (k >= st->nbins)
+            k = st->nbins - 1;
+
+        // window leakage & rounding of the fundamental : follow the local maximum
+        int best = k;
+        for (int d = -1; d <= 1; d++) {
+            int c = k + d;
+            if (c > 0 && c < st->nbins && st->power[c] > st->power[best])
+                best = c;
+        }
+        mark_tone(st, best, BIN_HARM);
+    }
+}
+
+static float ratio_db(float num, float den) {
+    if (den <= 0.0f)
+        return DIST_DB_MAX;
+    if (num <= 0.0f)
+        return -DIST_DB_MAX;
+    return 10.0f * log10f(num / den);
+}
+
+static void finish(dist_state *st) {
+    dist_result *r = &st->result;
+
+    // noise bins hidden under DC / tones are estimated from the average noise per bin. SINAD takes the
+    // harmonic bins as measured (their noise included), the estimate only covers the other bins
+    float noise = st->p_noise;
+    float noise_rest = st->p_noise;
+    if (st->noise_bins > 0) {
+        noise = noise * (float)(st->nbins - 1) / (float)st->noise_bins;
+        noise_rest = noise_rest * (float)(st->nbins - 1 - st->harm_bins) / (float)st->noise_bins;
+    }
+
+    float fund = st->p_fund;
+    float harm = st->p_harm;
+
+    r->fund_bin = st->peak_bin;
+    r->thd_db = ratio_db(harm, fund);
+    r->snr_db = ratio_db(fund, noise);
+    r->sinad_db = ratio_db(fund, noise_rest + harm);
+    r->enob = (r->sinad_db - 1.76f) / 6.02f;
+    r->count++;
+}
+
+bool dist_step(dist_state *st, int budget) {
+    while (budget > 0) {
+        switch (st->phase) {
+        case PHASE_PEAK: {
+            int end = st->pos + budget;
+            if (end > st->nbins)
+                end = st->nbins;
+            budget -= end - st->pos;
+            for (; st->pos < end; st->pos++) {
+                if (st->power[st->pos] > st->peak) {
+                    st->peak = st->power[st->pos];
+                    st->peak_bin = st->pos;
+                }
+            }
+            if (st->pos >= st->nbins) {
+                st->phase = PHASE_CLASSIFY;
+            }
+            break;
+        }
+        case PHASE_CLASSIFY:
+            // at most (harmonics + 2) * (2 * leak_bins + 1) bins
+            classify(st);
+            budget -= (st->harmonics + 2) * (2 * st->leak_bins + 1);
+            st->phase = PHASE_SUM;
+            st->pos = 0;
+            st->p_fund = 0.0f;
+            st->p_harm = 0.0f;
+            st->p_noise = 0.0f;
+            st->noise_bins = 0;
+            st->harm_bins = 0;
+            break;
+        case PHASE_SUM: {
+            int end = st->pos + budget;
+            if (end > st->nbins)
+                end = st->nbins;
+            budget -= end - st->pos;
+            for (; st->pos < end; st->pos++) {
+                float p = st->power[st->pos];
+                switch (st->bin_class[st->pos]) {
+                case BIN_FUND:
+                    st->p_fund += p;
+                    break;
+                case BIN_HARM:
+                    st->p_harm += p;
+                    st->harm_bins++;
+                    break;
+                case BIN_NOISE:
+                    st->p_noise += p;
+                    st->noise_bins++;
+                    break;
+                default: // DC is not a part of the signal
+                    break;
+                }
+            }
+            if (st->pos >= st->nbins) {
+                finish(st);
+                st->phase = PHASE_IDLE;
+                return true;
+            }
+            break;
+        }
+        default:
+            return false;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,61 @@
+// distortion.h
+// THD / SNR / SINAD / ENOB measurement on the power spectrum (mag_squared)
+// The work is split into small steps so it can run between captures
+
+#ifndef DISTORTION_H
+#define DISTORTION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define DIST_MAX_BINS 256       // FFT_SIZE / 2
+#define DIST_MAX_HARMONICS 9    // 2nd ~ 10th harmonics
+
+// Result of one analysis
+typedef struct {
+    int fund_bin;       // bin of the fundamental
+    float thd_db;       // harmonic power / fundamental power
+    float snr_db;       // fundamental power / noise power (harmonics excluded)
+    float sinad_db;     // fundamental power / (noise + harmonic) power
+    float enob;         // (SINAD - 1.76) / 6.02
+    uint32_t count;     // number of completed analyses
+} dist_result;
+
+// Analysis state, one spectrum is processed over several dist_step() calls
+typedef struct {
+    float power[DIST_MAX_BINS]; // snapshot of the power spectrum
+    uint8_t bin_class[DIST_MAX_BINS]; // DC, fundamental, harmonic or noise
+    int nbins;          // number of bins (N / 2)
+    int leak_bins;      // half width of a tone in bins (window main lobe)
+    int harmonics;      // number of harmonics (2nd, 3rd, ...)
+    int phase;          // current step of the analysis
+    int pos;            // current bin in the phase
+    int peak_bin;
+    float peak;
+    float p_fund;
+    float p_harm;
+    float p_noise;
+    int noise_bins;
+    int harm_bins;
+    dist_result result; // last completed result
+} dist_state;
+
+// Function to initialize the analysis
+// nbins: number of bins of the power spectrum (up to DIST_MAX_BINS)
+// leak_bins: half width of a tone in bins, 3 fits the Hann window (main lobe +-2 bins)
+// harmonics: number of harmonics to include in THD (up to DIST_MAX_HARMONICS)
+void dist_init(dist_state *st, int nbins, int leak_bins, int harmonics);
+
+// Function to start the analysis of a new spectrum
+// power: float32 power spectrum (fft_power), copied into the state, negative values are taken as 0
+void dist_start_f32(dist_state *st, const float *power);
+
+// Function to run part of the analysis
+// budget: number of bins processed in this call
+// Returns: true when a new result is available in st->result
+bool dist_step(dist_state *st, int budget);
+
+// Function to check if an analysis is in progress
+bool dist_busy(const dist_state *st);
+
+#endif // DISTORTION_H
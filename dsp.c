@@ -12,7 +12,7 @@
 
 // For ADC input
 #include "hardware/adc.h"
-#include "hardware/dma.h" // not in use
+#include "hardware/dma.h" // DMA acquisition (STAGED)
 #include "hardware/irq.h" // not in use
 
 // use multi core
@@ -25,18 +25,217 @@
 #include "pico/cyw43_arch.h"
 // LCD display control library
 #include "lcd_st7789_library.h"
+#include "readout.h"
 
 // for i2c device
 #include "hardware/i2c.h"
+#include "hardware/clocks.h"
+
+// tone tracking (Goertzel filter bank)
+#include "goertzel.h"
+// THD / SNR / SINAD / ENOB measurement
+#include "distortion.h"
+// acquire -> process -> render block scheduler
+#include "sched.h"
+// adaptive frame governor
+#include "governor.h"
+// log frequency axis & octave bands
+#include "binmap.h"
+// peak markers
+#include "marker.h"
+// frequency / period / duty counter
+#include "freqcount.h"
+// capture recorder (flash ring) & replay
+#include "capcodec.h"
+#include "capstore.h"
+#include "hardware/flash.h"
+#include "pico/flash.h"
+// boot phase report once the USB host is attached
+#include "pico/stdio_usb.h"
+// energy aware frame policy (LOW_POWER)
+#include "power.h"
+#include "hardware/structs/scb.h"
+// USB command shell
+#include "cmdshell.h"
+// SRAM placement of the hot path (cmake -DDSP_SRAM_HOT=ON) & XIP cache counters
+#include "sram_hot.h"
+#include "hardware/structs/xip_ctrl.h"
+#if DSP_SRAM_HOT
+#include "arm_common_tables.h"
+#endif
+// saturation & headroom telemetry, block floating point
+#include "headroom.h"
+// equivalent time sampling (oscilloscope)
+#include "ets.h"
 
 void core1_main();
-
-#define FFT_SIZE 256 * 2
+bool stage_render(void *ctx, int block, int step);
+void acquire_filtered();
+void power_dormant();
+void power_frame_end(uint32_t frame_start, uint32_t idle_us);
+uint32_t power_pace();
+void power_print_report();
+void shell_setup();
+void shell_poll();
+
+#define FFT_SIZE (256 * 2)
 #define FRAME_RATE 10
-#define RAW_SAMPLES 2560 * 2
-#define DOWNSAMPLED 256 * 2
+#define RAW_SAMPLES (2560 * 2)
+#define DOWNSAMPLED (256 * 2)
 #define DECIMATE_N 10
 #define ADC_CLKDIV 96.0f // 50Ksps : not applicable
+#define ADC_RATE 500000.0f // free running ADC (48MHz / 96)
+
+// FFT pipeline : Q15 (original), Q31 or float32 on the Cortex-M33 FPU
+#define PIPE_Q15 0
+#define PIPE_Q31 1
+#define PIPE_F32 2
+#define PIPE_COUNT 3
+#define FFT_PIPELINE PIPE_Q15 // initial pipeline, fft_pipeline can be changed at run time between frames
+
+// 1 : spectrum mode tracks a few tones (PWM fundamental & harmonics) with Goertzel filters instead of the full FFT
+#define TONE_TRACK 0
+#define TONE_COUNT 6           // PWM fundamental, 3rd, 5th, 7th, 9th & 11th harmonics
+#define TONE_RAW_MIN_FREQ 20000.0f // tones above this are tracked on the raw ADC stream (beyond the decimated Nyquist)
+#define TONE_DB_INIT -100      // display floor
+
+// 1 : spectrum mode is a frequency / period / duty counter on the full rate ADC stream (interpolated crossings)
+#define FREQ_COUNTER 0
+#define FC_GATE_SAMPLES 250000 // 0.5s gate, the resolution improves with the gate length
+#define FC_CHUNK 64            // samples per fc_process() call
+
+// 1 : THD / SNR / SINAD / ENOB of the spectrum are measured between FFT frames and printed under the graph
+// It needs the F32 pipeline : the Q13 / 3.29 powers of the Q15 / Q31 pipelines are 0 under the 12bit ADC
+// noise floor. The initial pipeline becomes F32, the analysis pauses while the shell selects another one
+#ifndef DIST_ANALYSIS // -D of the dsp_sim test builds
+#define DIST_ANALYSIS 0
+#endif
+#define DIST_LEAK_BINS 3       // Hann window main lobe (+-2 bins) + 1
+#define DIST_HARMONICS 9
+#define DIST_STEP_BINS 96      // bins per dist_step()
+#define DIST_STEPS ((FFT_SIZE + 2 * DIST_STEP_BINS - 1) / DIST_STEP_BINS) // one analysis : peak search, classification & sum
+
+// 1 : spectrum mode runs as a 3 stage pipeline, DMA acquisition -> DSP chunks on either core -> render on core1
+#ifndef STAGED // -D of the dsp_sim test builds
+#define STAGED 0
+#endif
+#define STAGE_BLOCKS 3         // capture blocks in flight
+#define STAGE_CHUNKS 3         // filter, FFT, result copy
+#define STAGE_RENDER_COLUMNS 32 // FFT columns drawn per render step
+#define STAGE_REPORT_US 1000000 // stage utilisation report period over USB
+#if STAGED && (TONE_TRACK || DIST_ANALYSIS)
+#error "STAGED runs the spectrum stages only, TONE_TRACK and DIST_ANALYSIS need the frame loop"
+#endif
+
+// 1 : spectrum frames are planned from the measured capture / FFT / render costs instead of FRAME_RATE
+// With GOV_AVERAGE the spectrum shown is the average of the captures that fit in a frame
+#define FRAME_GOVERNOR 0
+#define GOV_POLICY GOV_AVERAGE // GOV_AVERAGE : surplus captures are averaged, GOV_SKIP : not taken (CPU idles)
+#define GOV_REPORT_US 1000000  // frame rate & headroom report period over USB
+
+// spectrum frequency axis : linear (1 bin per column), log, or 1/1, 1/3, 1/6 octave bands
+#define VIEW_LINEAR 0
+#define VIEW_LOG 1
+#define VIEW_OCT1 2
+#define VIEW_OCT3 3
+#define VIEW_OCT6 4
+#define SPECTRUM_VIEW VIEW_LINEAR
+#define VIEW_F_MIN 50.0f       // lowest frequency of the log / octave views [Hz]
+
+// 1 : top MARKER_COUNT peaks are marked with interpolated frequency & level, M2... are shown relative to M1
+#define MARKERS 0
+#define MARKER_COUNT 3
+#define MARKER_INTERP MARKER_INTERP_HANN
+#define MARKER_SCAN_BINS 64    // background peak search per frame (a full search every 4 frames)
+#define MARKER_MIN_DB -90      // peaks below this level are ignored
+
+// 1 : pressing REC_PIN keeps the current capture in a flash ring (compressed, written between captures)
+#define RECORDER 0
+// 1 : captures come from the flash records (oldest first, looped) instead of the ADC
+#define REPLAY 0
+#define REC_PIN 4                      // record button, active low
+#define REC_FLASH_SIZE (512 * 1024)    // ring at the end of the flash (~100 spectrum captures)
+#define REC_FLASH_OFFSET (PICO_FLASH_SIZE_BYTES - REC_FLASH_SIZE)
+#define REC_FLASH_TIMEOUT_MS 100       // wait for core1 to park during a flash operation
+#define REC_MODE_SPECTRUM 0            // record of RAW_SAMPLES raw ADC samples
+#define REC_MODE_OSC 1                 // record of OSC_SIZE triggered samples
+
+// 1 : the spectrum capture is filtered & decimated on the fly in STREAM_CHUNK sample chunks,
+// there is no raw capture buffer (it is kept when RECORDER / REPLAY need the raw block)
+#define STREAM_FILTER 1
+#define STREAM_CHUNK 8 // filtered while the ADC FIFO fills, a few us per chunk
+#define STREAM_CAPTURE (STREAM_FILTER && !RECORDER && !REPLAY)
+#define STREAM_RETRIES 3 // captures started for one block when the ADC FIFO overflows
+
+// 1 : no fixed start up delays, SELECT_PIN is read before core1 starts and core0 sets up the DSP & captures
+// while core1 brings up the LCD (datasheet minimum delays), core0 waits for render_idle instead of sleeping
+#define FAST_BOOT 1
+#define BOOT_TARGET_US 250000 // time to first frame from reset (about 2s with FAST_BOOT 0)
+
+// boot phases, time stamped from reset & printed over USB after the first frame
+#define BOOT_MAIN 0
+#define BOOT_STDIO 1
+#define BOOT_CORE1 2
+#define BOOT_DSP_READY 3
+#define BOOT_FIRST_CAPTURE 4
+#define BOOT_LCD_INIT 5
+#define BOOT_LCD_CLEAR 6
+#define BOOT_DISPLAY_READY 7
+#define BOOT_FIRST_FRAME 8
+#define BOOT_PHASES 9
+
+// 1 : energy aware spectrum loop for battery units. ADC waits sleep on __wfe, one capture per frame (GOV_SKIP),
+// the clock follows the frame load & POWER_QUIET_FRAMES quiet frames drop into low rate probing until the signal is back
+#define LOW_POWER 0
+#define POWER_BUDGET_US 100000  // frame period target, the clock is lowered while the frame load leaves slack
+#define POWER_QUIET_RMS 40      // Q15 RMS of the filtered capture, ~50dB under a full scale sine
+#define POWER_WAKE_RMS 80
+#define POWER_QUIET_FRAMES 50
+#define POWER_POLL_MS 200       // probe capture period while dormant
+#define POWER_REPORT_US 1000000 // duty cycle & clock report period over USB
+#define ADC_WAKE_THRESH 2       // ADC FIFO level raising the FIFO irq, it wakes __wfe (SEVONPEND) in LOW_POWER
+#if LOW_POWER && !FRAME_GOVERNOR
+#error "LOW_POWER runs in the governed spectrum loop, set FRAME_GOVERNOR to 1"
+#endif
+#if STAGED && (FRAME_GOVERNOR || LOW_POWER)
+#error "STAGED replaces the frame loop, FRAME_GOVERNOR and LOW_POWER plan the frames of the plain acquisition"
+#endif
+
+// 1 : command shell on the USB CDC link, the runtime parameters are read & set between frames
+#define USB_SHELL 1
+
+// 1 : XIP cache hit / access counters read around each core0 stage, printed with the stage timings
+#define XIP_STATS 0
+#define XIP_CAPTURE 0 // capture & filter
+#define XIP_FFT 1     // window, FFT & power
+#define XIP_PUBLISH 2 // average, dB, peak & markers
+#define XIP_STAGES 3
+
+// 1 : clip & peak counters at each stage of the Q15 chain (filter, window, FFT), printed with the stage
+// timings. One scan of each 512 point FFT block per stage, meant to stay on
+#define HEADROOM 1
+// 1 : the ADC stage too (peak & rail samples), one more pass over each capture : about a third of the
+// Q15 filter loop on the host (sim/test/test_headroom.c), off by default
+#define HEADROOM_ADC 0
+// 1 : block floating point, the FFT input of each Q15 block is scaled up to the headroom of the block
+// and the power scaled back (can be changed at run time by the shell : bfp)
+#define BFP_AUTO 0
+#define BFP_MARGIN_BITS 1 // headroom kept under full scale
+#define BFP_MAX_SHIFT 8
+
+// 1 : equivalent time sampling of repetitive signals on the oscilloscope, each acquisition lands at a
+// random phase of the signal and its samples are binned by their time to the trigger. The trace fills
+// in over the acquisitions at ETS_BIN_NS, beyond the 2us ADC period
+#define ETS_MODE 0
+#define ETS_TRIG_PWM 0   // time stamp : PWM counter read at the start of the acquisition (OUTPUT_PIN signal)
+#define ETS_TRIG_LEVEL 1 // time stamp : rising level crossing interpolated between samples (slow edges only)
+#define ETS_TRIGGER ETS_TRIG_PWM
+#define ETS_BIN_NS 50.0f          // OSC_SIZE bins : 12.8us span, 20Msps when filled
+#define ETS_PRE_BINS (OSC_SIZE / 4)
+#define ETS_CAPTURE 2048          // samples per acquisition (4ms)
+#define ETS_LATENCY_NS 0          // [ns] counter read to the first ADC sample, a constant shift of the trace. Calibrated
+                                  // with the shell (ets_lat) : the report prints the time of the PWM edge on the trace
+#define ETS_REPORT_US 1000000     // fill & effective rate report period over USB
 
 // Channel 0 is GPIO26 for ADC sampling
 #define CAPTURE_CHANNEL 0
@@ -60,7 +259,7 @@ void core1_main();
 #define SELECT_PIN 3
 #define ADC_MAX 4095
 
-int dma_chan; // not in use
+int dma_chan; // ADC → capture block (STAGED)
 // false : Oscilloscope, true : spectrum analizer
 bool time_freq = 0;
 
@@ -69,24 +268,225 @@ uint32_t start_preprocess_time;
 uint32_t start_fft_time;
 uint32_t end_fft_time;
 uint32_t end_display_time;
+uint32_t end_filter_time;
+volatile uint32_t render_time_us; // last render time of core1 [us]
+
+// runtime parameters (USB_SHELL)
+volatile int frame_rate = FRAME_RATE; // captures per displayed frame
+uint32_t plain_captures;               // plain spectrum loop since the last shell "stats"
+uint32_t plain_frames;
+volatile int val_resi = 0x3f;         // MCP4131 wiper, 0x3f : gain 6db, 0x7f : 0db
 
 q15_t fft_output[FFT_SIZE * 2]; // 出力（複素数 interleaved）
 q15_t mag_squared[FFT_SIZE];    // パワースペクトル（Q13形式）
 q15_t hann_window[FFT_SIZE];
 arm_rfft_instance_q15 fft_instance;
 
+// Q31 pipeline buffers
+q31_t filtered_downsampled_q31[DOWNSAMPLED];
+q31_t windowed_input_q31[FFT_SIZE];
+q31_t fft_output_q31[FFT_SIZE * 2];
+q31_t mag_squared_q31[FFT_SIZE];    // パワースペクトル（3.29形式）
+q31_t hann_window_q31[FFT_SIZE];
+arm_rfft_instance_q31 fft_instance_q31;
+
+// float32 pipeline buffers
+float32_t filtered_downsampled_f32[DOWNSAMPLED];
+float32_t windowed_input_f32[FFT_SIZE];
+float32_t fft_output_f32[FFT_SIZE]; // packed : [X0, X(N/2), re1, im1, ...]
+float32_t mag_squared_f32[FFT_SIZE / 2];
+float32_t hann_window_f32[FFT_SIZE];
+arm_rfft_fast_instance_f32 fft_instance_f32;
+
+volatile int fft_pipeline = FFT_PIPELINE;
+uint32_t fft_exec_us[PIPE_COUNT]; // last fft_exec() time of each pipeline [us]
+
+// Q15 chain telemetry since the last report (HEADROOM)
+hr_telemetry headroom;
+volatile int bfp_auto = BFP_AUTO;
+
+// tone tracking : filtered_downsampled stream & raw ADC stream banks
+goertzel_bank tone_bank;
+goertzel_bank tone_bank_raw;
+float tone_freq[TONE_COUNT];
+int16_t tone_level_tmp[TONE_COUNT];
+volatile int16_t tone_level[2][TONE_COUNT];
+uint32_t start_tone_time;
+uint32_t end_tone_time;
+
+// distortion analysis : core0 updates dist_out, core1 prints it when dist_out.count changes
+dist_state dist;
+volatile dist_result dist_out;
+volatile bool dist_fixed = false; // the frame came from a fixed point pipeline, not analysed
+
+// frame governor : core1 measures the render time & tells core0 when it is idle
+governor gov;
+volatile bool render_idle = !FAST_BOOT; // FAST_BOOT : set when core1 has drawn the screen format
+
+// energy aware frame policy (LOW_POWER), clock levels fastest first
+power_policy power;
+const uint32_t power_clock_khz[] = {150000, 100000, 75000};
+uint32_t pwm_base_hz; // clk_sys of setup_pwm(), the PWM wrap is scaled to keep the test tone
+
+// boot phase time stamps [us from reset], 0 : not reached yet
+volatile uint32_t boot_us[BOOT_PHASES];
+const char *boot_phase_name[BOOT_PHASES] = {
+    "main", "stdio", "core1 launch", "dsp setup", "first capture",
+    "lcd init", "lcd clear", "screen format", "first frame"};
+bool boot_reported = false;
+
+#if XIP_STATS
+// XIP cache counters of each core0 stage since the last xip_print_report()
+// The cache is shared, core1 accesses during a core0 stage are counted too
+uint32_t xip_hit[XIP_STAGES];
+uint32_t xip_acc[XIP_STAGES];
+const char *xip_stage_name[XIP_STAGES] = {"capture", "fft", "publish"};
+
+// the counters saturate, they are cleared at the start of each stage
+static inline void xip_stage_begin()
+{
+    xip_ctrl_hw->ctr_hit = 0;
+    xip_ctrl_hw->ctr_acc = 0;
+}
+
+static inline void xip_stage_end(int stage)
+{
+    xip_hit[stage] += xip_ctrl_hw->ctr_hit;
+    xip_acc[stage] += xip_ctrl_hw->ctr_acc;
+}
+
+void xip_print_report()
+{
+    printf("xip");
+    for (int i = 0; i < XIP_STAGES; i++)
+    {
+        uint32_t miss = xip_acc[i] - xip_hit[i];
+        uint32_t miss_x10 = xip_acc[i] > 0 ? (uint32_t)((uint64_t)miss * 1000 / xip_acc[i]) : 0;
+        printf(" %s access %lu miss %lu (%lu.%lu%%)", xip_stage_name[i], (unsigned long)xip_acc[i],
+               (unsigned long)miss, (unsigned long)miss_x10 / 10, (unsigned long)miss_x10 % 10);
+        xip_hit[i] = 0;
+        xip_acc[i] = 0;
+    }
+    printf("\n");
+}
+#endif
+
+#if HEADROOM
+// peak [dBFS] & clips of each Q15 stage since the last report, range of the BFP shifts
+void hr_print_report()
+{
+    const char *stage_name[HR_STAGES] = {"adc", "filter", "window", "fft"};
+
+    printf("hr");
+    for (int i = HEADROOM_ADC ? HR_ADC : HR_FILTER; i < HR_STAGES; i++)
+        printf(" %s %.1fdBFS clip %lu", stage_name[i], hr_peak_dbfs(headroom.stage[i].peak),
+               (unsigned long)headroom.stage[i].clips);
+    printf(" shift %d..%d\n", headroom.shift_min, headroom.shift_max);
+    hr_reset(&headroom);
+}
+#endif
+
+#if DSP_SRAM_HOT
+// linker script symbols of the SRAM sections
+extern char __scratch_x_start__[], __scratch_x_end__[];
+extern char __scratch_y_start__[], __scratch_y_end__[];
+extern char __data_start__[], __data_end__[];
+
+// SRAM footprint & placement of the hot path, the CMSIS-DSP sections are renamed by CMake (a library
+// built without -ffunction-sections keeps its kernels in flash, shown here)
+void sram_report()
+{
+    const struct
+    {
+        const char *name;
+        const void *addr;
+    } sym[] = {
+        {"arm_rfft_q15", (const void *)arm_rfft_q15},
+        {"arm_cfft_q15", (const void *)arm_cfft_q15},
+        {"arm_rfft_q31", (const void *)arm_rfft_q31},
+        {"arm_rfft_fast_f32", (const void *)arm_rfft_fast_f32},
+        {"arm_cfft_f32", (const void *)arm_cfft_f32},
+        {"realCoefAQ15", realCoefAQ15},
+        {"twiddleCoef_256_q15", twiddleCoef_256_q15},
+        {"twiddleCoef_rfft_512", twiddleCoef_rfft_512},
+        {"lcd_draw_column", (const void *)lcd_draw_column},
+    };
+
+    printf("sram scratch_x %u B (core1) scratch_y %u B (core0) data & time critical %u B\n",
+           (unsigned)(__scratch_x_end__ - __scratch_x_start__), (unsigned)(__scratch_y_end__ - __scratch_y_start__),
+           (unsigned)(__data_end__ - __data_start__));
+    for (int i = 0; i < (int)(sizeof(sym) / sizeof(sym[0])); i++)
+        printf("sram %-20s %s 0x%08lx\n", sym[i].name, ((uintptr_t)sym[i].addr >> 28) == 2 ? "sram " : "flash",
+               (unsigned long)(uintptr_t)sym[i].addr);
+}
+#endif
+
+void boot_mark(int phase)
+{
+    if (boot_us[phase] == 0)
+        boot_us[phase] = time_us_32();
+}
+
+// print the boot phases once, after the first frame & as soon as the USB host is there
+void boot_report()
+{
+    if (boot_reported || boot_us[BOOT_FIRST_FRAME] == 0 || !stdio_usb_connected())
+        return;
+    boot_reported = true;
+
+    for (int i = 0; i < BOOT_PHASES; i++)
+        printf("boot %-13s %7lu us\n", boot_phase_name[i], (unsigned long)boot_us[i]);
+    printf("boot first frame %lu ms (target %d ms)%s\n", (unsigned long)boot_us[BOOT_FIRST_FRAME] / 1000,
+           BOOT_TARGET_US / 1000, boot_us[BOOT_FIRST_FRAME] > BOOT_TARGET_US ? " missed" : "");
+#if DSP_SRAM_HOT
+    sram_report();
+#endif
+}
+
+// end of a rendered frame : boot report (printed once)
+void boot_frame_rendered()
+{
+    boot_mark(BOOT_FIRST_FRAME);
+    boot_report();
+}
+
+#if !STREAM_CAPTURE
 uint16_t capture_buf[RAW_SAMPLES];
+#endif
 q15_t filtered_downsampled[DOWNSAMPLED];
 
 // FFT結果（dB変換後の値 : dual buffer for display control）
 // Core0が更新する。Core1は読み取りのみ
 int16_t fft_result_tmp[FFT_SIZE / 2];
+// power of the FFTs since the last fft_publish()（平均化用）
+float fft_power_acc[FFT_SIZE / 2];
+int fft_power_count = 0;
+float fft_power[FFT_SIZE / 2]; // averaged power of the last frame
+volatile int32_t peak_hz = 0;  // strongest bin of the last frame (readout)
+volatile int16_t peak_db = 0;
+
+// markers : core0 updates them after each frame, core1 draws a copy of marker_out
+marker_state markers;
+marker_peak marker_out[MARKER_MAX];
+volatile uint32_t marker_seq = 0; // odd while core0 writes marker_out, core1 copies again
+
+// log / octave views : bins → columns map, built once by view_setup()
+binmap view_map;
+float view_power[BINMAP_MAX_ENTRIES];
+volatile int spectrum_view = SPECTRUM_VIEW;
+volatile int view_cols = FFT_SIZE / 2; // displayed columns (bars)
+volatile int view_pitch = 1;           // bar pitch [dots]
 volatile int16_t fft_result[2][FFT_SIZE / 2];
 volatile int non_active_index = 0;
 volatile int next = 0;
 
 // oscilloscope function
 #define OSC_SIZE 256
+// 1 : the waveform is a connected trace, one vertical span per column updated by difference
+// 0 : one dot per sample
+#ifndef OSC_VECTOR // -D of the dsp_sim test builds
+#define OSC_VECTOR 1
+#endif
 int16_t adc_result_tmp[OSC_SIZE];
 volatile int16_t adc_result[2][OSC_SIZE];
 
@@ -123,19 +523,45 @@ void write_i2c(uint8_t val)
         cyw43_arch_gpio_put(CYW43_WL_GPIO_LED_PIN, 1);
 }*/
 
-void __not_in_flash_func(adc_capture)(uint16_t *buf, size_t count)
+// next ADC sample, LOW_POWER sleeps until the FIFO irq is pending instead of polling
+static inline uint16_t __core0_func(adc_fifo_get_wait)()
+{
+#if LOW_POWER
+    while (adc_fifo_is_empty())
+    {
+        irq_clear(ADC_IRQ_FIFO); // the irq is not enabled in the NVIC, clearing re-arms the pending edge
+        if (!adc_fifo_is_empty())
+            break;
+        __wfe();
+    }
+    return adc_fifo_get();
+#else
+    return adc_fifo_get_blocking();
+#endif
+}
+
+// true if the ADC FIFO overflowed (samples were lost) since the last call, the sticky flag is cleared
+static inline bool adc_fifo_overflowed()
 {
-    adc_fifo_setup(true, false, 0, false, false);
+    if (!(adc_hw->fcs & ADC_FCS_OVER_BITS))
+        return false;
+    hw_set_bits(&adc_hw->fcs, ADC_FCS_OVER_BITS); // write 1 to clear
+    return true;
+}
+
+void __core0_func(adc_capture)(uint16_t *buf, size_t count)
+{
+    adc_fifo_setup(true, false, ADC_WAKE_THRESH, false, false);
     adc_run(true);
     for (size_t i = 0; i < count; i = i + 1)
-        buf[i] = adc_fifo_get_blocking();
+        buf[i] = adc_fifo_get_wait();
     adc_run(false);
     adc_fifo_drain();
 }
 
-void __not_in_flash_func(adc_capture_edge)(uint16_t *buf, size_t count)
+void __core0_func(adc_capture_edge)(uint16_t *buf, size_t count)
 {
-    adc_fifo_setup(true, false, 0, false, false);
+    adc_fifo_setup(true, false, ADC_WAKE_THRESH, false, false);
     adc_run(true);
 
     int16_t time_loop = 0;
@@ -148,8 +574,8 @@ void __not_in_flash_func(adc_capture_edge)(uint16_t *buf, size_t count)
         else
         {
             time_loop++;
-            int16_t edge_prev = ADC_MAX - adc_fifo_get_blocking();
-            int16_t edge_cur = ADC_MAX - adc_fifo_get_blocking();
+            int16_t edge_prev = ADC_MAX - adc_fifo_get_wait();
+            int16_t edge_cur = ADC_MAX - adc_fifo_get_wait();
             if (edge_cur > (edge_prev + 3) * 10)
             { // consider edge_prev = zero
                 break;
@@ -158,7 +584,7 @@ void __not_in_flash_func(adc_capture_edge)(uint16_t *buf, size_t count)
     }
 
     for (size_t i = 0; i < count; i++)
-        buf[i] = ADC_MAX - adc_fifo_get_blocking();
+        buf[i] = ADC_MAX - adc_fifo_get_wait();
     adc_run(false);
     adc_fifo_drain();
 }
@@ -170,32 +596,139 @@ static inline q15_t lowpass_filter_q15(q15_t input, q15_t prev, q15_t alpha)
     return (q15_t)__SSAT(filtered, 16);
 }
 
-void filter_and_downsample()
+static inline q31_t lowpass_filter_q31(q31_t input, q31_t prev, q31_t alpha)
+{
+    int64_t one_minus_alpha = 2147483648LL - alpha; // Q31で (1 - α)
+    int64_t filtered = ((int64_t)input * alpha + (int64_t)prev * one_minus_alpha) >> 31;
+    return (q31_t)filtered;
+}
+
+// decimation filter state, kept between chunks so a capture can be filtered while it arrives
+typedef struct
 {
-    q15_t prev = 0;     // IIRの初期値
-    q15_t alpha = 8192; // cut off freq. 23KHz
+    int phase;    // position in the decimation period (sample index % DECIMATE_N)
+    int out;      // next output index
+    int pipeline; // fft_pipeline latched by filter_begin(), the FFT of the block runs the same one
+    q15_t prev;
+    q31_t prev_q31;
+    float32_t prev_f32;
+} decim_state;
+decim_state decim;
+volatile int filter_alpha = 8192; // IIR coefficient (Q15) of every pipeline, 8192 : cut off freq. 23KHz
+
+// start a new block of DOWNSAMPLED outputs
+void filter_begin()
+{
+    memset(&decim, 0, sizeof(decim));
+    decim.pipeline = fft_pipeline; // a shell change applies from the next block
+}
 
-    int down_idx = 0;
+static void __core0_func(filter_chunk_q15)(const uint16_t *src, int n)
+{
+    q15_t prev = decim.prev;
+    q15_t alpha = (q15_t)filter_alpha;
+    int phase = decim.phase;
+    int out = decim.out;
 
-    for (int i = 0; i < RAW_SAMPLES; i++)
+    for (int i = 0; i < n; i++)
     {
         // ADC raw は 12bit（0～4095）想定 → 中心化＆スケーリング
-        int32_t centered = (int32_t)capture_buf[i] - 2048;
+        int32_t centered = (int32_t)src[i] - 2048;
         q15_t sample = (q15_t)__SSAT(centered << 3, 16); // ≒ Q15スケーリング　Clipping would not happen in this case
 
         // IIR フィルタ適用
         prev = lowpass_filter_q15(sample, prev, alpha);
 
         // N点ごとに出力へ保存
-        if ((i % DECIMATE_N) == 0 && down_idx < DOWNSAMPLED)
+        if (phase == 0 && out < DOWNSAMPLED)
+        {
+            filtered_downsampled[out++] = prev;
+        }
+        if (++phase == DECIMATE_N)
+            phase = 0;
+    }
+
+    decim.prev = prev;
+    decim.phase = phase;
+    decim.out = out;
+}
+
+// Q31 version : same scaling as Q15 (0.5 full scale), 16 more bits below
+static void __core0_func(filter_chunk_q31)(const uint16_t *src, int n)
+{
+    q31_t prev = decim.prev_q31;
+    q31_t alpha = (q31_t)filter_alpha << 16;
+    int phase = decim.phase;
+    int out = decim.out;
+
+    for (int i = 0; i < n; i++)
+    {
+        int32_t centered = (int32_t)src[i] - 2048;
+        prev = lowpass_filter_q31(centered << 19, prev, alpha);
+
+        if (phase == 0 && out < DOWNSAMPLED)
+        {
+            filtered_downsampled_q31[out++] = prev;
+        }
+        if (++phase == DECIMATE_N)
+            phase = 0;
+    }
+
+    decim.prev_q31 = prev;
+    decim.phase = phase;
+    decim.out = out;
+}
+
+// float32 version : same scaling as Q15 (0.5 full scale)
+static void __core0_func(filter_chunk_f32)(const uint16_t *src, int n)
+{
+    float32_t prev = decim.prev_f32;
+    float32_t alpha = filter_alpha * (1.0f / 32768.0f);
+    int phase = decim.phase;
+    int out = decim.out;
+
+    for (int i = 0; i < n; i++)
+    {
+        float32_t sample = (float32_t)((int32_t)src[i] - 2048) * (1.0f / 4096.0f);
+        prev = sample * alpha + prev * (1.0f - alpha);
+
+        if (phase == 0 && out < DOWNSAMPLED)
         {
-            filtered_downsampled[down_idx++] = prev;
+            filtered_downsampled_f32[out++] = prev;
         }
+        if (++phase == DECIMATE_N)
+            phase = 0;
     }
+
+    decim.prev_f32 = prev;
+    decim.phase = phase;
+    decim.out = out;
+}
+
+// feed n samples of 12bit ADC data to the filter of the current pipeline
+void __core0_func(filter_chunk)(const uint16_t *src, int n)
+{
+    if (decim.pipeline == PIPE_Q31)
+        filter_chunk_q31(src, n);
+    else if (decim.pipeline == PIPE_F32)
+        filter_chunk_f32(src, n);
+    else
+        filter_chunk_q15(src, n);
+}
+
+// src : RAW_SAMPLES of 12bit ADC data (capture_buf / capture_pool)
+void __hot_func(filter_and_downsample)(const uint16_t *src)
+{
+    filter_begin();
+    filter_chunk(src, RAW_SAMPLES);
+#if HEADROOM && HEADROOM_ADC
+    if (decim.pipeline == PIPE_Q15)
+        hr_note_adc(&headroom, src, RAW_SAMPLES);
+#endif
 }
 
 // FFT & Power calc
-void perform_fft_and_power_spectrum(arm_rfft_instance_q15 *instance, q15_t *input, q15_t *output, q15_t *power_spectrum)
+void __hot_func(perform_fft_and_power_spectrum)(arm_rfft_instance_q15 *instance, q15_t *input, q15_t *output, q15_t *power_spectrum)
 {
     arm_rfft_q15(instance, input, output);
     arm_cmplx_mag_squared_q15(output, power_spectrum, FFT_SIZE);
@@ -214,217 +747,1565 @@ void adc_initialize()
         false  // 12bitデータをそのまま
     );
     // adc_set_clkdiv(ADC_CLKDIV);
+#if LOW_POWER
+    // FIFO irq only raises the pending flag, SEVONPEND turns it into a __wfe wake up event
+    adc_irq_set_enabled(true);
+    hw_set_bits(&scb_hw->scr, M33_SCR_SEVONPEND_BITS);
+#endif
 }
 
-// to apply Hann window & call FFT/Power calc
-void fft_exec()
-{
-    // q15_t input[FFT_SIZE];
-    q15_t windowed_input[FFT_SIZE];
-
-    float hann_correction = 1.0f / 0.5f; // ハニング窓で約0.5倍になる補正
-
-    for (int n = 0; n < FFT_SIZE; n++)
-    {
-        int32_t val = filtered_downsampled[n] * hann_window[n];
-        windowed_input[n] = (q15_t)(val >> 15);
-    }
+#if RECORDER || REPLAY
+capstore recorder;
+uint8_t rec_stage[CAPCODEC_MAX_BYTES(RAW_SAMPLES)]; // encoded capture being written
+bool rec_pin_prev = true;
+int replay_next = 0;
 
-    start_fft_time = time_us_32();
+// flash operations run with core1 parked (flash_safe_execute), XIP is not available meanwhile
+typedef struct
+{
+    uint32_t offset;
+    const uint8_t *data;
+    uint32_t len;
+} rec_flash_op;
 
-    perform_fft_and_power_spectrum(&fft_instance, windowed_input, fft_output, mag_squared);
+static void rec_do_erase(void *param)
+{
+    rec_flash_op *op = param;
+    flash_range_erase(REC_FLASH_OFFSET + op->offset, op->len);
+}
 
-    float q13_to_float = 1.0f / 8192.0f; // Q13 → float
+static void rec_do_program(void *param)
+{
+    rec_flash_op *op = param;
+    flash_range_program(REC_FLASH_OFFSET + op->offset, op->data, op->len);
+}
 
-    for (uint32_t j = 0; j < FFT_SIZE / 2; j++)
-    {
-        float mag_q13 = (float)mag_squared[j] * q13_to_float;
-        float mag_corr = mag_q13 * hann_correction; // Hanning補正（約2倍）
+bool rec_erase(void *ctx, uint32_t offset, uint32_t len)
+{
+    rec_flash_op op = {offset, NULL, len};
+    return flash_safe_execute(rec_do_erase, &op, REC_FLASH_TIMEOUT_MS) == PICO_OK;
+}
 
-        float voltage_rms = sqrtf(mag_corr);
-        fft_result_tmp[j] = (int)20.0f * log10f(voltage_rms + 1e-5f);
-    }
+bool rec_program(void *ctx, uint32_t offset, const uint8_t *data, uint32_t len)
+{
+    rec_flash_op op = {offset, data, len};
+    return flash_safe_execute(rec_do_program, &op, REC_FLASH_TIMEOUT_MS) == PICO_OK;
+}
 
-    end_fft_time = time_us_32();
+void recorder_setup()
+{
+    capstore_flash flash = {
+        (const uint8_t *)XIP_BASE + REC_FLASH_OFFSET,
+        REC_FLASH_SIZE,
+        FLASH_SECTOR_SIZE,
+        FLASH_PAGE_SIZE,
+        rec_erase,
+        rec_program,
+        NULL,
+    };
+    capstore_init(&recorder, &flash);
+    printf("recorder : %d captures in flash\n", recorder.count);
+
+    gpio_init(REC_PIN);
+    gpio_set_dir(REC_PIN, GPIO_IN);
+    gpio_pull_up(REC_PIN);
 }
+#endif
 
-#define OUTPUT_PIN 2
+#if RECORDER
+bool rec_request = false; // REC_PIN was pressed, the next published frame is recorded
 
-void setup_pwm()
+// called after each capture : latches a REC_PIN press
+void recorder_pin()
 {
-    gpio_set_function(OUTPUT_PIN, GPIO_FUNC_PWM);
-    uint slice_num = pwm_gpio_to_slice_num(OUTPUT_PIN);
-
-    pwm_config config = pwm_get_default_config();
-    pwm_config_set_clkdiv(&config, 1.0f); // PWM clock = 125 MHz / 1 = 125 MHz
+    bool pin = gpio_get(REC_PIN);
+    if (rec_pin_prev && !pin)
+        rec_request = true;
+    rec_pin_prev = pin;
+}
 
-    // 周期 = 25,000クロック → 2.5kHz（= 125M / 50.0k）
-    pwm_config_set_wrap(&config, 63999);
-    pwm_init(slice_num, &config, true);
+// called when a frame is published : a pending press keeps the capture shown by that frame
+// (the last capture of a GOV_AVERAGE frame, the average itself is not a capture)
+void recorder_frame(const uint16_t *samples, int count, uint16_t mode)
+{
+    if (!rec_request || capstore_busy(&recorder))
+        return;
+    rec_request = false;
+    int len = capcodec_encode(samples, count, rec_stage, sizeof(rec_stage));
+    if (len > 0)
+        capstore_begin(&recorder, rec_stage, len, count, mode, time_us_32());
+}
 
-    // デューティー比 = 50%
-    pwm_set_gpio_level(OUTPUT_PIN, 32000);
+// one sector erase (~45ms) or page program (~1ms) of the record being written, called between frames :
+// never inside a capture or the capture / FFT times measured by the governor. flash_safe_execute parks
+// core1, the governed loop calls it while core1 is idle
+void recorder_idle()
+{
+    if (capstore_busy(&recorder) && capstore_step(&recorder))
+        printf("recorder : %d captures, %lu errors\n", recorder.count, (unsigned long)recorder.errors);
 }
+#endif
 
-int main()
+#if REPLAY
+// decode the next stored capture of this mode into buf
+// Returns: false if there is none (the ADC is used instead)
+bool replay_capture(uint16_t *buf, int count, uint16_t mode)
 {
-    stdio_init_all();
+    for (int i = 0; i < recorder.count; i++)
+    {
+        int n = (replay_next + i) % recorder.count;
+        const uint8_t *payload;
+        const capstore_header *h = capstore_get(&recorder, n, &payload);
+        if (h == NULL || h->mode != mode || h->samples != count)
+            continue;
+        replay_next = n + 1;
+        return capcodec_decode(payload, h->length, buf, count) == count;
+    }
+    return false;
+}
+#endif
 
-    cyw43_arch_init(); // debug purpose
-    cyw43_arch_gpio_put(CYW43_WL_GPIO_LED_PIN, 0);
+#if !STREAM_CAPTURE
+// RAW_SAMPLES from the ADC, or from the next stored capture in replay mode
+void capture_spectrum(uint16_t *buf)
+{
+#if REPLAY
+    uint32_t start = time_us_32();
+    if (replay_capture(buf, RAW_SAMPLES, REC_MODE_SPECTRUM))
+    {
+        // keep the pace of a real capture
+        uint32_t capture_us = (uint32_t)(RAW_SAMPLES * 1000000.0f / ADC_RATE);
+        uint32_t used = time_us_32() - start;
+        if (used < capture_us)
+            sleep_us(capture_us - used);
+        return;
+    }
+#endif
+    adc_capture(buf, RAW_SAMPLES);
+#if RECORDER
+    recorder_pin();
+#endif
+}
+#endif
 
-    sleep_ms(1000);
-    multicore_launch_core1(core1_main);
-    sleep_ms(500);
+// triggered OSC_SIZE samples for the oscilloscope, or the next stored one in replay mode
+void capture_osc(int16_t *buf)
+{
+#if REPLAY
+    if (replay_capture((uint16_t *)buf, OSC_SIZE, REC_MODE_OSC))
+        return;
+#endif
+    adc_capture_edge((uint16_t *)buf, OSC_SIZE);
+    boot_mark(BOOT_FIRST_CAPTURE);
+#if RECORDER
+    recorder_pin();
+#endif
+}
 
-    // pwn enable
-    setup_pwm();
-    /*
-        // degital potentiometer initialize & set initial value
-        setup_i2c();
-        uint8_t val = 0x7f; // set wiper to max value
-        write_i2c(val);*/
+// power (1.0 = Q13 full scale of the Q15 pipeline) → dB
+static inline int16_t power_to_db(float power)
+{
+    float hann_correction = 1.0f / 0.5f; // ハニング窓で約0.5倍になる補正
 
-    // SPI MCP4131 initialize
-    spi_init(SPI_PORT, 1000 * 1000); // 1 MHz
-    gpio_set_function(PIN_SCK, GPIO_FUNC_SPI);
-    gpio_set_function(PIN_MOSI, GPIO_FUNC_SPI);
-    // no MISO output（MCP4131）
+    float mag_corr = power * hann_correction; // Hanning補正（約2倍）
+    float voltage_rms = sqrtf(mag_corr);
+    return (int)20.0f * log10f(voltage_rms + 1e-5f);
+}
 
-    gpio_init(PIN_CS);
-    gpio_set_dir(PIN_CS, GPIO_OUT);
-    gpio_put(PIN_CS, 1);
+// Q31 pipeline : arm_rfft_q31 has the same output scaling as arm_rfft_q15
+void __hot_func(fft_exec_q31)()
+{
+    for (int n = 0; n < FFT_SIZE; n++)
+    {
+        windowed_input_q31[n] = (q31_t)(((int64_t)filtered_downsampled_q31[n] * hann_window_q31[n]) >> 31);
+    }
 
-    int16_t val_resi = 0x3f;        // 0x3f : gain 6db, 0x7f : 0db
-    mcp4131_write(val_resi);
+    start_fft_time = time_us_32();
 
-    // read SELECT-PIN status
-    gpio_init(SELECT_PIN);
-    gpio_set_dir(SELECT_PIN, GPIO_IN);
-    gpio_pull_up(SELECT_PIN);
-    sleep_ms(1); // wait for stable condition (time constant when using internal pull up resistor)
-    time_freq = gpio_get(SELECT_PIN);
+    arm_rfft_q31(&fft_instance_q31, windowed_input_q31, fft_output_q31);
+    arm_cmplx_mag_squared_q31(fft_output_q31, mag_squared_q31, FFT_SIZE);
 
-    // display buffer initialize
-    memset((void *)fft_result, 0, sizeof(fft_result));
-    memset((void *)adc_result, 0, sizeof(adc_result));
+    float q29_to_float = 1.0f / 536870912.0f; // 3.29 → float
 
-    if (time_freq == true)
+    for (uint32_t j = 0; j < FFT_SIZE / 2; j++)
     {
-        // to prepare Hanning window coefficient
-        for (int n = 0; n < FFT_SIZE; n++)
-        {
-            float hann = 0.5f * (1.0f - cosf(2.0f * M_PI * n / (FFT_SIZE - 1)));
-            hann_window[n] = (q15_t)(hann * 32767.0f);
-        }
-        // initialise FFT instance
-        arm_status status = arm_rfft_init_q15(&fft_instance, FFT_SIZE, 0, 1);
-
-        adc_initialize();
-
-        int disp_index = 0;
+        fft_power_acc[j] += (float)mag_squared_q31[j] * q29_to_float;
+    }
+}
 
-        while (1)
-        {
+// float32 pipeline : arm_rfft_fast_f32 is not scaled, divide by FFT_SIZE like the fixed point RFFT (the 512
+// point RFFT output is 10.6 in Q15 / 10.22 in Q31)
+void __hot_func(fft_exec_f32)()
+{
+    arm_mult_f32(filtered_downsampled_f32, hann_window_f32, windowed_input_f32, FFT_SIZE);
 
-            start_adc_time = time_us_32();
+    start_fft_time = time_us_32();
 
-            adc_capture(capture_buf, RAW_SAMPLES);
+    arm_rfft_fast_f32(&fft_instance_f32, windowed_input_f32, fft_output_f32, 0);
+    arm_cmplx_mag_squared_f32(fft_output_f32, mag_squared_f32, FFT_SIZE / 2);
+    mag_squared_f32[0] = fft_output_f32[0] * fft_output_f32[0]; // bin 0 also holds X(N/2) in the packed format
 
-            start_preprocess_time = time_us_32();
+    float scale = 1.0f / ((float)FFT_SIZE * FFT_SIZE);
 
-            filter_and_downsample();
+    for (uint32_t j = 0; j < FFT_SIZE / 2; j++)
+    {
+        fft_power_acc[j] += mag_squared_f32[j] * scale;
+    }
+}
 
-            //  LCD refresh is a sampling mode
-            if ((disp_index % FRAME_RATE) == 0)
-            {
-                fft_exec();
-                disp_index = 0;
+// to apply Hann window & call FFT/Power calc, the power is accumulated until fft_publish()
+void __hot_func(fft_exec)()
+{
+#if XIP_STATS
+    xip_stage_begin();
+#endif
+    uint32_t start_time = time_us_32();
+    int pipeline = decim.pipeline; // the pipeline that filtered the block
 
-                // notify that the display data is available
-                uint32_t message = 1;
-                multicore_fifo_push_blocking(message);
-            }
-            else
-            {
-                disp_index++;
-            }
-        }
-        // wait forever(doesn't reach here)
-        __wfi();
+    if (pipeline == PIPE_Q31)
+    {
+        fft_exec_q31();
+    }
+    else if (pipeline == PIPE_F32)
+    {
+        fft_exec_f32();
     }
     else
     {
-        adc_initialize();
-
-        while (1)
+        // q15_t input[FFT_SIZE];
+        q15_t windowed_input[FFT_SIZE];
+        int shift = 0; // BFP : the window multiply keeps shift more bits
+
+#if HEADROOM
+        uint32_t clips = 0;
+        uint16_t filter_peak = hr_peak_q15(filtered_downsampled, FFT_SIZE, &clips);
+        hr_note(&headroom, HR_FILTER, filter_peak, clips);
+        if (bfp_auto)
+            shift = hr_block_shift(filter_peak, BFP_MARGIN_BITS, BFP_MAX_SHIFT);
+        hr_note_shift(&headroom, shift);
+#else
+        if (bfp_auto)
+            shift = hr_block_shift(hr_peak_q15(filtered_downsampled, FFT_SIZE, NULL), BFP_MARGIN_BITS, BFP_MAX_SHIFT);
+#endif
+        for (int n = 0; n < FFT_SIZE; n++)
         {
+            int32_t val = filtered_downsampled[n] * hann_window[n];
+            windowed_input[n] = (q15_t)__SSAT(val >> (15 - shift), 16);
+        }
+#if HEADROOM
+        clips = 0;
+        uint16_t peak = hr_peak_q15(windowed_input, FFT_SIZE, &clips);
+        hr_note(&headroom, HR_WINDOW, peak, clips);
+#endif
 
-            adc_capture_edge(adc_result_tmp, OSC_SIZE);
+        start_fft_time = time_us_32();
 
-            start_preprocess_time = time_us_32();
+        perform_fft_and_power_spectrum(&fft_instance, windowed_input, fft_output, mag_squared);
 
-            // notify that the display data is available
-            uint32_t message = 0;
-            multicore_fifo_push_blocking(message);
+#if HEADROOM
+        clips = 0;
+        peak = hr_peak_q15(fft_output, FFT_SIZE, &clips); // bins 0 .. N/2 - 1
+        hr_note(&headroom, HR_FFT, peak, clips);
+#endif
+        float q13_to_float = ldexpf(1.0f / 8192.0f, -2 * shift); // Q13 → float, the BFP shift scaled the power by 4^shift
+
+        for (uint32_t j = 0; j < FFT_SIZE / 2; j++)
+        {
+            fft_power_acc[j] += (float)mag_squared[j] * q13_to_float;
         }
     }
 
-    //__BKPT(1);
+    end_fft_time = time_us_32();
+    fft_exec_us[pipeline] = end_fft_time - start_time;
+    fft_power_count++;
+#if XIP_STATS
+    xip_stage_end(XIP_FFT);
+#endif
 }
 
-// ----------------------------------------------------------------------------
-// core1 will be used for LCD display control
-#include "pico/stdlib.h"
-#include "lcd_st7789_library.h"
-#include "hardware/spi.h"
-// for spectrum analizer
-#define SCREEN_WIDTH 310  // FFT result display area max
-#define SCREEN_HEIGHT 220 // FFT result display area max
-#define DB_MIN -100       // floor level
-#define DB_MAX 0
-#define COLOR_BG create_color(0, 0, 0)
-#define COLOR_FG create_color(255, 255, 255)
-#define COLOR_LINE create_color(0, 0, 255)
-
-int hori_offset = 54;
-int char_offset = 10;
-int ver_offset = 20;
-int scale = 40;
-// y座標をdB値（-100～0）から画面の高さ（20～219）へマッピング（上が20）
-int db_to_y(int db_value)
+// average of the accumulated power → dB (fft_result_tmp)
+void fft_publish()
 {
-    if (db_value < DB_MIN)
-        db_value = DB_MIN;
-    if (db_value > DB_MAX)
-        db_value = DB_MAX;
-    return (int)((DB_MAX - db_value) * (SCREEN_HEIGHT - 1 - ver_offset) / (DB_MAX - DB_MIN));
+#if XIP_STATS
+    xip_stage_begin();
+#endif
+    float scale = fft_power_count > 0 ? 1.0f / fft_power_count : 1.0f;
+
+    int peak_bin = 1;
+    for (uint32_t j = 0; j < FFT_SIZE / 2; j++)
+    {
+        fft_power[j] = fft_power_acc[j] * scale;
+        fft_power_acc[j] = 0.0f;
+        if (j > 0 && fft_power[j] > fft_power[peak_bin])
+            peak_bin = j;
+    }
+    fft_power_count = 0;
+
+    peak_hz = (int32_t)(peak_bin * (ADC_RATE / DECIMATE_N / FFT_SIZE));
+    peak_db = power_to_db(fft_power[peak_bin]);
+
+#if MARKERS
+    marker_update(&markers, fft_power, MARKER_SCAN_BINS);
+    marker_seq++;
+    __dmb();
+    for (int i = 0; i < MARKER_MAX; i++)
+        marker_out[i] = markers.peak[i];
+    __dmb();
+    marker_seq++;
+#endif
+
+    if (spectrum_view == VIEW_LINEAR)
+    {
+        for (uint32_t j = 0; j < FFT_SIZE / 2; j++)
+            fft_result_tmp[j] = power_to_db(fft_power[j]);
+    }
+    else
+    {
+        // summed in the power domain, then dB
+        binmap_apply(&view_map, fft_power, view_power);
+        for (int j = 0; j < view_map.count; j++)
+            fft_result_tmp[j] = power_to_db(view_power[j]);
+    }
+#if XIP_STATS
+    xip_stage_end(XIP_PUBLISH);
+#endif
 }
 
-// FFT棒グラフの描画（差分のみ更新）
-void draw_fft_graph()
+// build the bin → column map of a view
+void view_setup(int view)
 {
-    for (int x = 0; x < FFT_SIZE / 2; x++)
-    {
-        int y_new = db_to_y(fft_result[1 - non_active_index][x]);
-        int y_old = db_to_y(fft_result[non_active_index][x]);
+    float bin_hz = ADC_RATE / DECIMATE_N / FFT_SIZE;
+    float f_max = ADC_RATE / DECIMATE_N / 2;
+
+    if (view == VIEW_LOG)
+        binmap_log(&view_map, FFT_SIZE / 2, VIEW_F_MIN, f_max, bin_hz, FFT_SIZE / 2);
+    else if (view == VIEW_OCT1)
+        binmap_octave(&view_map, 1, VIEW_F_MIN, f_max, bin_hz, FFT_SIZE / 2);
+    else if (view == VIEW_OCT3)
+        binmap_octave(&view_map, 3, VIEW_F_MIN, f_max, bin_hz, FFT_SIZE / 2);
+    else if (view == VIEW_OCT6)
+        binmap_octave(&view_map, 6, VIEW_F_MIN, f_max, bin_hz, FFT_SIZE / 2);
+
+    if (view == VIEW_LINEAR)
+        view_cols = FFT_SIZE / 2;
+    else
+        view_cols = view_map.count;
+    view_pitch = (FFT_SIZE / 2) / view_cols;
+    spectrum_view = view;
+}
 
-        if (y_new != y_old)
-        {
-            //  消す（古い棒） → 黒
-            if (y_old < SCREEN_HEIGHT)
-                lcd_draw_line(x + hori_offset, y_old + ver_offset, x + hori_offset, SCREEN_HEIGHT - 1, COLOR_BG);
+#if STAGED
+// 3 stage pipeline : each block has its own capture & result buffer, DSP chunks of the blocks run in order
+uint16_t capture_pool[STAGE_BLOCKS][RAW_SAMPLES];
+int16_t stage_result[STAGE_BLOCKS][FFT_SIZE / 2];
+sched stage;
+volatile bool stage_ready = false; // core1 starts polling after sched_init()
 
-            // 描く（新しい棒） → 白
-            if (y_new < SCREEN_HEIGHT)
-                lcd_draw_line(x + hori_offset, y_new + ver_offset, x + hori_offset, SCREEN_HEIGHT - 1, COLOR_FG);
-        }
-    }
+void adc_dma_setup()
+{
+    dma_chan = dma_claim_unused_channel(true);
+    dma_channel_config cfg = dma_channel_get_default_config(dma_chan);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_16);
+    channel_config_set_read_increment(&cfg, false);
+    channel_config_set_write_increment(&cfg, true);
+    channel_config_set_dreq(&cfg, DREQ_ADC);
+    dma_channel_configure(dma_chan, &cfg, NULL, &adc_hw->fifo, RAW_SAMPLES, false);
 }
 
-int v_to_y(int adc_value)
+// capture RAW_SAMPLES into buf in the background
+void adc_dma_start(uint16_t *buf)
 {
-    return (int)((1.0 - adc_value / 4095.0) * scale * 3.3 + (5.0 - 3.3) * scale); // adc full scale is 3.3V and 1.7 * 40 is an offset
+    adc_fifo_setup(true, true, 1, false, false); // DREQ有効
+    adc_fifo_drain();
+    dma_channel_set_write_addr(dma_chan, buf, false);
+    dma_channel_set_trans_count(dma_chan, RAW_SAMPLES, true);
+    adc_run(true);
+}
+
+void stage_dsp(void *ctx, int block, int chunk)
+{
+    switch (chunk)
+    {
+    case 0:
+        filter_and_downsample(capture_pool[block]);
+        break;
+    case 1:
+        fft_exec();
+        break;
+    default:
+        fft_publish();
+        memcpy(stage_result[block], fft_result_tmp, sizeof(stage_result[block]));
+        break;
+    }
+}
+
+void stage_report()
+{
+    sched_stats st;
+    sched_get_stats(&stage, &st);
+    sched_stats_reset(&stage);
+
+    int acq = sched_utilisation(&st, SCHED_STAGE_ACQUIRE);
+    int dsp = sched_utilisation(&st, SCHED_STAGE_DSP);
+    int render = sched_utilisation(&st, SCHED_STAGE_RENDER);
+    printf("stage acq %d.%d%% dsp %d.%d%% render %d.%d%% frames %lu chunks %lu/%lu waits %lu\n",
+           acq / 10, acq % 10, dsp / 10, dsp % 10, render / 10, render % 10,
+           (unsigned long)st.frames, (unsigned long)st.dsp_chunks[0], (unsigned long)st.dsp_chunks[1],
+           (unsigned long)st.acquire_waits);
+}
+
+// core0 side of the pipeline : acquisition & DSP chunks (never returns)
+void stage_run()
+{
+    sched_config cfg = {STAGE_BLOCKS, STAGE_CHUNKS, stage_dsp, stage_render, time_us_32, NULL};
+    sched_init(&stage, &cfg);
+    adc_dma_setup();
+    stage_ready = true;
+
+    int acq_block = -1;
+    uint32_t report_time = time_us_32();
+
+    while (1)
+    {
+        if (acq_block < 0)
+        {
+            acq_block = sched_acquire_begin(&stage);
+            if (acq_block >= 0)
+                adc_dma_start(capture_pool[acq_block]);
+        }
+        else if (!dma_channel_is_busy(dma_chan))
+        {
+            adc_run(false);
+            sched_acquire_end(&stage, acq_block);
+            acq_block = -1;
+#if USB_SHELL
+            // between blocks : the pipeline is latched per block by filter_begin(), the other sets apply
+            // from the next chunk or render step
+            shell_poll();
+#endif
+        }
+
+        sched_dsp_poll(&stage, 0);
+
+        if (time_us_32() - report_time >= STAGE_REPORT_US)
+        {
+            stage_report();
+            report_time = time_us_32();
+        }
+    }
+}
+#endif
+
+// start the distortion analysis of the frame just published, on its averaged power (the spectrum shown)
+void dist_start_frame()
+{
+    // the fixed point powers are 0 under the 12bit ADC noise floor, SNR / SINAD / ENOB would saturate :
+    // no analysis on those pipelines (core1 shows why)
+    dist_fixed = decim.pipeline != PIPE_F32;
+    if (dist_fixed)
+        return;
+    // the previous analysis is dropped if it could not finish in time
+    dist_start_f32(&dist, fft_power);
+}
+
+#if FRAME_GOVERNOR
+void gov_print_report()
+{
+    gov_report r;
+    gov_get_report(&gov, &r);
+    printf("gov fps %d.%d captures %d headroom %d%% (capture %lu fft %lu render %lu us)\n",
+           r.fps_x10 / 10, r.fps_x10 % 10, r.captures, r.headroom_pct,
+           (unsigned long)gov.capture_us, (unsigned long)gov.dsp_us, (unsigned long)gov.render_us);
+}
+
+// core0 spectrum loop with the frame governor (never returns)
+void governed_run()
+{
+#if LOW_POWER
+    gov_init(&gov, GOV_SKIP, frame_rate); // the CPU sleeps until the next frame instead of averaging
+#else
+    gov_init(&gov, GOV_POLICY, frame_rate);
+#endif
+    uint32_t report_time = time_us_32();
+
+    while (1)
+    {
+#if LOW_POWER
+        if (power.state == POWER_DORMANT)
+            power_dormant();
+        uint32_t frame_start = power_pace();
+#endif
+        int captures = gov_plan(&gov);
+        uint32_t delay = gov_start_delay(&gov);
+        if (delay > 0)
+            sleep_us(delay); // GOV_SKIP : start the capture just in time for the next frame
+
+        for (int k = 0; k < captures; k++)
+        {
+            acquire_filtered();
+
+            uint32_t filter_end = time_us_32();
+            fft_exec();
+            gov_add_dsp(&gov, filter_end - start_adc_time, end_fft_time - filter_end);
+        }
+
+        // wait for core1, the spare time goes to the distortion analysis
+#if LOW_POWER
+        uint32_t wait_start = time_us_32();
+#endif
+        while (!render_idle)
+        {
+#if DIST_ANALYSIS
+            if (dist_busy(&dist))
+            {
+                if (dist_step(&dist, DIST_STEP_BINS))
+                    dist_out = dist.result;
+                continue;
+            }
+#endif
+            __wfe();
+        }
+#if LOW_POWER
+        // core1 is idle, a clock change can't hit an SPI transfer
+        power_frame_end(frame_start, delay + time_us_32() - wait_start);
+#endif
+
+        fft_publish();
+#if DIST_ANALYSIS
+        dist_start_frame();
+#endif
+#if RECORDER
+        // core1 is idle & the captures of the next frame have not started
+        recorder_frame(capture_buf, RAW_SAMPLES, REC_MODE_SPECTRUM);
+        recorder_idle();
+#endif
+
+        // notify that the display data is available
+        render_idle = false;
+        multicore_fifo_push_blocking(1);
+#if USB_SHELL
+        shell_poll();
+#endif
+
+        if (time_us_32() - report_time >= GOV_REPORT_US)
+        {
+            gov_print_report();
+#if XIP_STATS
+            xip_print_report();
+#endif
+#if HEADROOM
+            hr_print_report();
+#endif
+#if LOW_POWER
+            power_print_report();
+#endif
+            report_time = time_us_32();
+        }
+    }
+}
+#endif
+
+// initialise the windows & FFT instances of every pipeline (fft_pipeline can change at run time)
+void fft_setup()
+{
+    // to prepare Hanning window coefficient
+    for (int n = 0; n < FFT_SIZE; n++)
+    {
+        float hann = 0.5f * (1.0f - cosf(2.0f * M_PI * n / (FFT_SIZE - 1)));
+        hann_window[n] = (q15_t)(hann * 32767.0f);
+        hann_window_q31[n] = (q31_t)(hann * 2147483647.0f);
+        hann_window_f32[n] = hann;
+    }
+    // initialise FFT instance
+    arm_rfft_init_q15(&fft_instance, FFT_SIZE, 0, 1);
+    arm_rfft_init_q31(&fft_instance_q31, FFT_SIZE, 0, 1);
+    arm_rfft_fast_init_f32(&fft_instance_f32, FFT_SIZE);
+}
+
+// tone tracking : route each target tone to the decimated or the raw ADC stream
+void tone_setup(float fundamental)
+{
+    float low[TONE_COUNT];
+    float high[TONE_COUNT];
+    int n_low = 0;
+    int n_high = 0;
+
+    for (int i = 0; i < TONE_COUNT; i++)
+    {
+        tone_freq[i] = fundamental * (2 * i + 1); // square wave : odd harmonics only
+        if (tone_freq[i] < TONE_RAW_MIN_FREQ)
+            low[n_low++] = tone_freq[i];
+        else
+            high[n_high++] = tone_freq[i];
+    }
+    goertzel_bank_init(&tone_bank, low, n_low, ADC_RATE / DECIMATE_N, DOWNSAMPLED);
+    goertzel_bank_init(&tone_bank_raw, high, n_high, ADC_RATE, RAW_SAMPLES);
+}
+
+// tone tracking : raw ADC samples to the high frequency bank (core0 capture loop, streamed per chunk)
+void __core0_func(tone_raw_feed)(const uint16_t *src, int n)
+{
+    if (tone_bank_raw.count == 0)
+        return;
+
+    // same centering & scaling as filter_chunk_q15(), in small chunks to stay on the stack
+    q15_t chunk[256];
+    while (n > 0)
+    {
+        int len = n < 256 ? n : 256;
+        for (int j = 0; j < len; j++)
+            chunk[j] = (q15_t)__SSAT(((int32_t)src[j] - 2048) << 3, 16);
+        goertzel_bank_process(&tone_bank_raw, chunk, len);
+        src += len;
+        n -= len;
+    }
+}
+
+// tone tracking : run the filter banks over the latest capture (replaces fft_exec)
+void tone_exec()
+{
+    start_tone_time = time_us_32();
+
+    goertzel_bank_process(&tone_bank, filtered_downsampled, DOWNSAMPLED);
+#if !STREAM_CAPTURE
+    tone_raw_feed(capture_buf, RAW_SAMPLES); // streamed during the capture otherwise
+#endif
+
+    // tone order is kept : low bank first, then the raw bank
+    for (int i = 0; i < tone_bank.count; i++)
+        tone_level_tmp[i] = tone_bank.tone[i].level_db;
+    for (int i = 0; i < tone_bank_raw.count; i++)
+        tone_level_tmp[tone_bank.count + i] = tone_bank_raw.tone[i].level_db;
+
+    end_tone_time = time_us_32();
+}
+
+#if STREAM_CAPTURE
+uint32_t stream_overruns; // streamed captures hit by an ADC FIFO overflow
+uint32_t stream_dropped;  // blocks kept with lost samples (STREAM_RETRIES overflows in a row)
+
+// capture RAW_SAMPLES & filter them while the ADC runs, STREAM_CHUNK samples at a time.
+// The filter has to keep up with the ADC : a chunk filtered slower than the FIFO fills loses samples,
+// the block is checked per chunk & restarted (the spectrum of a block with a gap shows spurs)
+void __core0_func(adc_capture_filtered)()
+{
+    uint16_t chunk[STREAM_CHUNK];
+
+    for (int attempt = 0; attempt < STREAM_RETRIES; attempt++)
+    {
+        bool overflow = false;
+
+        filter_begin();
+        adc_fifo_setup(true, false, ADC_WAKE_THRESH, false, false);
+        adc_fifo_overflowed(); // flag left by an earlier capture
+        adc_run(true);
+        for (int i = 0; i < RAW_SAMPLES && !overflow; i += STREAM_CHUNK)
+        {
+            for (int j = 0; j < STREAM_CHUNK; j++)
+                chunk[j] = adc_fifo_get_wait();
+            filter_chunk(chunk, STREAM_CHUNK);
+#if HEADROOM && HEADROOM_ADC
+            if (decim.pipeline == PIPE_Q15)
+                hr_note_adc(&headroom, chunk, STREAM_CHUNK);
+#endif
+#if TONE_TRACK
+            tone_raw_feed(chunk, STREAM_CHUNK);
+#endif
+            overflow = adc_fifo_overflowed();
+        }
+        adc_run(false);
+        adc_fifo_drain();
+        if (!overflow)
+            return;
+        stream_overruns++;
+    }
+    stream_dropped++; // the last attempt is kept, a partial block
+}
+#endif
+
+// one spectrum capture → filtered_downsampled (start_adc_time / start_preprocess_time are updated)
+void __hot_func(acquire_filtered)()
+{
+#if XIP_STATS
+    xip_stage_begin();
+#endif
+    start_adc_time = time_us_32();
+#if STREAM_CAPTURE
+    adc_capture_filtered();
+    start_preprocess_time = time_us_32();
+#else
+    capture_spectrum(capture_buf);
+    start_preprocess_time = time_us_32();
+    filter_and_downsample(capture_buf);
+#endif
+    end_filter_time = time_us_32();
+#if XIP_STATS
+    xip_stage_end(XIP_CAPTURE);
+#endif
+    boot_mark(BOOT_FIRST_CAPTURE);
+}
+
+#if FREQ_COUNTER
+fc_state fcount;
+volatile fc_result fc_out; // last gate, for core1
+
+// frequency counter loop : gapless capture, one result per FC_GATE_SAMPLES (never returns)
+void freq_counter_run()
+{
+    uint16_t chunk[FC_CHUNK];
+
+    fc_init(&fcount, ADC_RATE, ADC_MAX / 2);
+    adc_fifo_setup(true, false, ADC_WAKE_THRESH, false, false);
+    adc_fifo_overflowed(); // flag left by an earlier capture
+    adc_run(true);
+    while (1)
+    {
+        for (int n = 0; n < FC_GATE_SAMPLES; n += FC_CHUNK)
+        {
+            for (int j = 0; j < FC_CHUNK; j++)
+                chunk[j] = adc_fifo_get_wait();
+            fc_process(&fcount, chunk, FC_CHUNK);
+            // a gap shifts every later crossing of the gate, the gate is dropped
+            if (adc_fifo_overflowed())
+                fc_lost(&fcount);
+        }
+
+        fc_result r;
+        fc_gate(&fcount, &r);
+        fc_out = r;
+        boot_mark(BOOT_FIRST_CAPTURE);
+
+        // notify that the display data is available
+        multicore_fifo_push_blocking(3);
+    }
+}
+#endif
+
+#define OUTPUT_PIN 2
+#define PWM_WRAP 63999
+
+void setup_pwm()
+{
+    gpio_set_function(OUTPUT_PIN, GPIO_FUNC_PWM);
+    uint slice_num = pwm_gpio_to_slice_num(OUTPUT_PIN);
+
+    pwm_config config = pwm_get_default_config();
+    pwm_config_set_clkdiv(&config, 1.0f); // PWM clock = 125 MHz / 1 = 125 MHz
+
+    // 周期 = 25,000クロック → 2.5kHz（= 125M / 50.0k）
+    pwm_config_set_wrap(&config, PWM_WRAP);
+    pwm_init(slice_num, &config, true);
+
+    // デューティー比 = 50%
+    pwm_set_gpio_level(OUTPUT_PIN, 32000);
+    pwm_base_hz = clock_get_hz(clk_sys);
+}
+
+#if ETS_MODE
+ets_state ets;
+uint16_t ets_buf[ETS_CAPTURE];
+volatile int ets_fill;        // filled bins [%], for core1
+volatile int ets_rate_x10;    // effective sample rate [0.1 Msps]
+volatile int ets_latency_ns = ETS_LATENCY_NS;
+uint16_t ets_level;           // ETS_TRIG_LEVEL : trigger level of the binned acquisitions
+
+// one ETS acquisition binned, the reconstructed trace → buf (OSC_SIZE bins)
+void ets_acquire(int16_t *buf)
+{
+    adc_fifo_setup(true, false, ADC_WAKE_THRESH, false, false);
+#if ETS_TRIGGER == ETS_TRIG_PWM
+    // the counter read & the ADC start are kept together, the phase of sample 0 is the counter phase
+    uint slice = pwm_gpio_to_slice_num(OUTPUT_PIN);
+    uint32_t irq = save_and_disable_interrupts();
+    uint16_t counter = pwm_get_counter(slice);
+    adc_run(true);
+    restore_interrupts(irq);
+#else
+    adc_run(true);
+#endif
+    for (int i = 0; i < ETS_CAPTURE; i++)
+        ets_buf[i] = ADC_MAX - adc_fifo_get_wait();
+    adc_run(false);
+    adc_fifo_drain();
+    boot_mark(BOOT_FIRST_CAPTURE);
+
+#if ETS_TRIGGER == ETS_TRIG_PWM
+    // PWM output rises at counter 0, the trigger of the displayed (non inverted) trace. The period is the
+    // one of setup_pwm(), a clock change scales the wrap to keep it
+    float period_ns = (PWM_WRAP + 1) * 1e9f / pwm_base_hz;
+    ets_add_phase(&ets, ets_buf, ETS_CAPTURE, counter * 1e9f / clock_get_hz(clk_sys) + ets_latency_ns, period_ns);
+#else
+    uint16_t min = ADC_MAX;
+    uint16_t max = 0;
+    for (int i = 0; i < ETS_CAPTURE; i++)
+    {
+        min = ets_buf[i] < min ? ets_buf[i] : min;
+        max = ets_buf[i] > max ? ets_buf[i] : max;
+    }
+    if (max - min > 32) // no trigger on noise
+    {
+        uint16_t level = (min + max) / 2;
+        uint16_t hyst = (max - min) / 8;
+        // another signal : the bins of the previous one are dropped
+        int shift = (int)level - (int)ets_level;
+        if (shift > hyst || shift < -hyst)
+            ets_clear(&ets);
+        ets_level = level;
+        ets_add_level(&ets, ets_buf, ETS_CAPTURE, level, hyst);
+    }
+#endif
+    ets_reconstruct(&ets, buf);
+    ets_fill = ets_fill_pct(&ets);
+    ets_rate_x10 = (int)(ets_rate_msps(&ets) * 10.0f);
+}
+
+void ets_print_report()
+{
+    printf("ets fill %d%% %d.%d Msps (%lu acquisitions, %lu triggers, %lu samples)\n", ets_fill, ets_rate_x10 / 10,
+           ets_rate_x10 % 10, (unsigned long)ets.acquisitions, (unsigned long)ets.triggers,
+           (unsigned long)ets.samples);
+#if ETS_TRIGGER == ETS_TRIG_PWM
+    // the PWM edge is the trigger, its time on the trace is the latency left to compensate
+    int16_t trace[OSC_SIZE];
+    float edge_ns;
+    ets_reconstruct(&ets, trace);
+    if (ets_edge_ns(&ets, trace, &edge_ns))
+    {
+        int edge = (int)lroundf(edge_ns);
+        printf("ets edge %+d ns, latency %d ns (set ets_lat %d)\n", edge, ets_latency_ns, ets_latency_ns - edge);
+    }
+#endif
+}
+#endif
+
+#if LOW_POWER
+// signal RMS of the last capture in Q15 units
+uint32_t signal_rms()
+{
+    if (decim.pipeline == PIPE_Q31)
+        return power_rms_q31(filtered_downsampled_q31, DOWNSAMPLED);
+    else if (decim.pipeline == PIPE_F32)
+        return power_rms_f32(filtered_downsampled_f32, DOWNSAMPLED);
+    return power_rms_q15(filtered_downsampled, DOWNSAMPLED);
+}
+
+// change clk_sys, only while core1 is idle (the LCD SPI clock comes from clk_peri = clk_sys)
+void power_apply_clock(uint32_t khz)
+{
+    if (clock_get_hz(clk_sys) == khz * 1000)
+        return;
+    set_sys_clock_khz(khz, true);
+    lcd_spi_clock_update();
+
+    // same PWM test tone frequency at the new clock
+    uint32_t wrap = (uint32_t)((uint64_t)(PWM_WRAP + 1) * clock_get_hz(clk_sys) / pwm_base_hz) - 1;
+    pwm_set_wrap(pwm_gpio_to_slice_num(OUTPUT_PIN), wrap);
+    pwm_set_gpio_level(OUTPUT_PIN, (wrap + 1) / 2);
+}
+
+void power_print_report()
+{
+    power_report r;
+    power_get_report(&power, &r);
+    printf("power duty %d.%d%% clock %lu kHz %s, %lu dormant entries\n", r.duty_x10 / 10, r.duty_x10 % 10,
+           (unsigned long)r.clock_khz, r.state == POWER_DORMANT ? "dormant" : "run", (unsigned long)r.dormant_entries);
+}
+
+// one frame per POWER_BUDGET_US, the CPU sleeps (sleep_us waits on __wfe) until the next frame starts
+// Returns: start time of the frame
+uint32_t power_pace()
+{
+    static uint32_t next_frame;
+    uint32_t now = time_us_32();
+    int32_t wait = (int32_t)(next_frame - now);
+
+    if (wait > 0 && wait <= POWER_BUDGET_US)
+    {
+        sleep_us(wait);
+        power_account(&power, 0, wait);
+        now = time_us_32();
+    }
+    next_frame = now + POWER_BUDGET_US;
+    return now;
+}
+
+// end of a governed frame (core1 idle) : duty cycle, clock level & no signal detection
+void power_frame_end(uint32_t frame_start, uint32_t idle_us)
+{
+    uint32_t busy = time_us_32() - frame_start - idle_us;
+    power_account(&power, busy, idle_us);
+
+    uint32_t load = busy > gov.render_us ? busy : gov.render_us;
+    if (power_frame(&power, load, signal_rms()) && power.state == POWER_RUN)
+        power_apply_clock(power.clock_khz[power.level]);
+}
+
+// no signal : lowest clock, a probe capture every POWER_POLL_MS (sleep_ms waits on __wfe), returns when the signal is back
+void power_dormant()
+{
+    while (!render_idle)
+        __wfe();
+    power_apply_clock(power.clock_khz[power.level]);
+
+    uint32_t report_time = time_us_32();
+    while (1)
+    {
+        uint32_t sleep_start = time_us_32();
+        sleep_ms(POWER_POLL_MS);
+        uint32_t probe_start = time_us_32();
+        acquire_filtered();
+        power_account(&power, time_us_32() - probe_start, probe_start - sleep_start);
+
+        if (power_probe(&power, signal_rms()))
+            break;
+        if (time_us_32() - report_time >= POWER_REPORT_US)
+        {
+            power_print_report();
+            report_time = time_us_32();
+        }
+    }
+    power_apply_clock(power.clock_khz[power.level]);
+}
+#endif
+
+// read SELECT-PIN status
+void read_select_pin()
+{
+    gpio_init(SELECT_PIN);
+    gpio_set_dir(SELECT_PIN, GPIO_IN);
+    gpio_pull_up(SELECT_PIN);
+    sleep_ms(1); // wait for stable condition (time constant when using internal pull up resistor)
+    time_freq = gpio_get(SELECT_PIN);
+}
+
+int main()
+{
+    boot_mark(BOOT_MAIN);
+    stdio_init_all();
+    boot_mark(BOOT_STDIO);
+
+#if FAST_BOOT
+    // core1 draws the screen format of the selected mode as soon as it starts
+    read_select_pin();
+    multicore_launch_core1(core1_main);
+    boot_mark(BOOT_CORE1);
+
+    cyw43_arch_init(); // debug purpose, runs during the LCD reset on core1
+    cyw43_arch_gpio_put(CYW43_WL_GPIO_LED_PIN, 0);
+#else
+    cyw43_arch_init(); // debug purpose
+    cyw43_arch_gpio_put(CYW43_WL_GPIO_LED_PIN, 0);
+
+    sleep_ms(1000);
+    multicore_launch_core1(core1_main);
+    boot_mark(BOOT_CORE1);
+    sleep_ms(500);
+#endif
+
+    // pwn enable
+    setup_pwm();
+    /*
+        // degital potentiometer initialize & set initial value
+        setup_i2c();
+        uint8_t val = 0x7f; // set wiper to max value
+        write_i2c(val);*/
+
+    // SPI MCP4131 initialize
+    spi_init(SPI_PORT, 1000 * 1000); // 1 MHz
+    gpio_set_function(PIN_SCK, GPIO_FUNC_SPI);
+    gpio_set_function(PIN_MOSI, GPIO_FUNC_SPI);
+    // no MISO output（MCP4131）
+
+    gpio_init(PIN_CS);
+    gpio_set_dir(PIN_CS, GPIO_OUT);
+    gpio_put(PIN_CS, 1);
+
+    mcp4131_write(val_resi);
+#if USB_SHELL
+    shell_setup();
+#endif
+
+#if !FAST_BOOT
+    read_select_pin();
+#endif
+
+#if RECORDER || REPLAY
+    recorder_setup();
+#endif
+
+    // display buffer initialize
+    memset((void *)fft_result, 0, sizeof(fft_result));
+    memset((void *)adc_result, 0, sizeof(adc_result));
+    for (int i = 0; i < TONE_COUNT; i++)
+    {
+        tone_level[0][i] = TONE_DB_INIT;
+        tone_level[1][i] = TONE_DB_INIT;
+    }
+
+    if (time_freq == true)
+    {
+        fft_setup();
+        view_setup(SPECTRUM_VIEW);
+#if MARKERS
+        // power_to_db() : 20log10(sqrt(2 * power))
+        marker_init(&markers, FFT_SIZE / 2, ADC_RATE / DECIMATE_N / FFT_SIZE, MARKER_COUNT, MARKER_INTERP,
+                    0.5f * powf(10.0f, MARKER_MIN_DB / 10.0f));
+#endif
+
+        adc_initialize();
+
+#if TONE_TRACK
+        fft_pipeline = PIPE_Q15; // Goertzel bank runs on filtered_downsampled
+        tone_setup((float)clock_get_hz(clk_sys) / (PWM_WRAP + 1));
+#endif
+#if DIST_ANALYSIS
+        dist_init(&dist, FFT_SIZE / 2, DIST_LEAK_BINS, DIST_HARMONICS);
+#if !TONE_TRACK
+        fft_pipeline = PIPE_F32; // the analysis needs the float power
+#endif
+#endif
+#if LOW_POWER
+        power_init(&power, power_clock_khz, sizeof(power_clock_khz) / sizeof(power_clock_khz[0]), POWER_BUDGET_US,
+                   POWER_QUIET_RMS, POWER_WAKE_RMS, POWER_QUIET_FRAMES);
+#endif
+        boot_mark(BOOT_DSP_READY);
+
+#if FREQ_COUNTER
+        freq_counter_run();
+#endif
+
+#if STAGED
+        stage_run();
+#elif FRAME_GOVERNOR && !TONE_TRACK
+        governed_run();
+#endif
+
+        int disp_index = 0;
+
+        while (1)
+        {
+
+            acquire_filtered();
+
+#if TONE_TRACK
+            // Goertzel is cheap enough to refresh levels on every capture
+            tone_exec();
+            multicore_fifo_push_blocking(2);
+#if RECORDER
+            recorder_frame(capture_buf, RAW_SAMPLES, REC_MODE_SPECTRUM);
+#endif
+#if USB_SHELL
+            shell_poll();
+#endif
+#else
+            // LCD refresh is a sampling mode : the first of every frame_rate captures is transformed & displayed
+            plain_captures++;
+            if (disp_index == 0)
+            {
+                plain_frames++;
+                fft_exec();
+                fft_publish();
+#if DIST_ANALYSIS
+                dist_start_frame();
+#endif
+
+                // notify that the display data is available
+                uint32_t message = 1;
+                multicore_fifo_push_blocking(message);
+#if RECORDER
+                recorder_frame(capture_buf, RAW_SAMPLES, REC_MODE_SPECTRUM);
+#endif
+#if USB_SHELL
+                shell_poll();
+#endif
+            }
+#if DIST_ANALYSIS
+            // the analysis of the frame is spread over its frame_rate captures (core1 draws meanwhile), all of
+            // its DIST_STEPS after the push when every capture is a frame
+            for (int k = (DIST_STEPS + frame_rate - 1) / frame_rate; k > 0 && dist_busy(&dist); k--)
+            {
+                if (dist_step(&dist, DIST_STEP_BINS))
+                    dist_out = dist.result;
+            }
+#endif
+            // a lower frame_rate set by the shell takes effect at once
+            if (++disp_index >= frame_rate)
+                disp_index = 0;
+#endif
+#if RECORDER
+            // this loop has no idle time : one flash step per capture, after its frame work
+            recorder_idle();
+#endif
+        }
+        // wait forever(doesn't reach here)
+        __wfi();
+    }
+    else
+    {
+        adc_initialize();
+#if ETS_MODE
+        ets_init(&ets, OSC_SIZE, ETS_PRE_BINS, ETS_BIN_NS, 1e9f / ADC_RATE);
+        uint32_t report_time = time_us_32();
+#endif
+        boot_mark(BOOT_DSP_READY);
+
+        while (1)
+        {
+
+#if ETS_MODE
+            ets_acquire(adc_result_tmp);
+            if (time_us_32() - report_time >= ETS_REPORT_US)
+            {
+                ets_print_report();
+                report_time = time_us_32();
+            }
+#else
+            capture_osc(adc_result_tmp);
+#endif
+
+            start_preprocess_time = time_us_32();
+
+            // notify that the display data is available
+            uint32_t message = 0;
+            multicore_fifo_push_blocking(message);
+#if RECORDER && !ETS_MODE
+            recorder_frame((uint16_t *)adc_result_tmp, OSC_SIZE, REC_MODE_OSC);
+            recorder_idle();
+#endif
+#if USB_SHELL
+            shell_poll();
+#endif
+        }
+    }
+
+    //__BKPT(1);
+}
+
+// ----------------------------------------------------------------------------
+// core1 will be used for LCD display control
+#include "pico/stdlib.h"
+#include "lcd_st7789_library.h"
+#include "hardware/spi.h"
+// for spectrum analizer
+#define SCREEN_WIDTH 310  // FFT result display area max
+#define SCREEN_HEIGHT 220 // FFT result display area max
+#define DB_MIN -100       // floor level at start up, "set db_min" / "set db_max" change the scale
+#define DB_MAX 0
+#define COLOR_BG create_color(0, 0, 0)
+#define COLOR_FG create_color(255, 255, 255)
+#define COLOR_LINE create_color(0, 0, 255)
+#define COLOR_MARKER create_color(255, 255, 0)
+#define GRID_LINES 5 // reference lines, every GRID_STEP rows from the top of the plot
+#define GRID_STEP 40
+
+int hori_offset = 54;
+int char_offset = 10;
+int ver_offset = 20;
+volatile int scale = 40; // oscilloscope [dots / V]
+volatile int db_min = DB_MIN; // shell parameters, core1 takes them in db_scale_update()
+volatile int db_max = DB_MAX;
+volatile bool db_scale_changed;
+int db_lo = DB_MIN; // scale of the bars on screen
+int db_hi = DB_MAX;
+
+// y座標をdB値（db_lo～db_hi）から画面の高さ（20～219）へマッピング（上が20）
+int db_to_y(int db_value)
+{
+    if (db_value < db_lo)
+        db_value = db_lo;
+    if (db_value > db_hi)
+        db_value = db_hi;
+    return (int)((db_hi - db_value) * (SCREEN_HEIGHT - 1 - ver_offset) / (db_hi - db_lo));
+}
+
+// level guide : one label per reference line & the floor, right aligned
+void draw_db_labels()
+{
+    char text[8];
+
+    lcd_fill_rect(0, ver_offset - 3, hori_offset - 1, GRID_LINES * GRID_STEP + 8, COLOR_BG);
+    for (int i = 0; i <= GRID_LINES; i++)
+    {
+        int db = db_hi - (i * (db_hi - db_lo) + GRID_LINES / 2) / GRID_LINES;
+        int len = snprintf(text, sizeof(text), "%ddb", db);
+        lcd_draw_text(char_offset + 30 - 6 * len, GRID_STEP * i + ver_offset - 3, text, COLOR_FG, COLOR_BG, 1);
+    }
+}
+
+// live readouts（変化した文字のみ描画）
+readout readout_fps;
+readout readout_peak;
+readout readout_vpp;
+uint32_t frame_interval_us = 0; // moving average of the display frame interval
+uint32_t last_frame_time = 0;
+
+// frame interval → "12.3fps"
+void update_fps_readout()
+{
+    char text[READOUT_MAX_CHARS + 1];
+    uint32_t now = time_us_32();
+
+    if (last_frame_time != 0)
+    {
+        uint32_t interval = now - last_frame_time;
+        frame_interval_us = frame_interval_us == 0 ? interval : (frame_interval_us * 7 + interval) / 8;
+    }
+    last_frame_time = now;
+    if (frame_interval_us == 0)
+        return;
+
+    int len = fmt_fixed(text, (int32_t)(10000000u / frame_interval_us), 1);
+    text[len++] = 'f';
+    text[len++] = 'p';
+    text[len++] = 's';
+    text[len] = '\0';
+    readout_set(&readout_fps, text);
+}
+
+// strongest bin → "2343Hz -6db"
+void update_peak_readout()
+{
+    char text[READOUT_MAX_CHARS + 1];
+
+    int len = fmt_int(text, peak_hz);
+    text[len++] = 'H';
+    text[len++] = 'z';
+    text[len++] = ' ';
+    len += fmt_int(text + len, peak_db);
+    text[len++] = 'd';
+    text[len++] = 'b';
+    text[len] = '\0';
+    readout_set(&readout_peak, text);
+}
+
+// peak to peak of the displayed waveform → "Vpp 1.234V"
+void update_vpp_readout(volatile int16_t *samples)
+{
+    char text[READOUT_MAX_CHARS + 1];
+    int16_t min = ADC_MAX;
+    int16_t max = 0;
+
+    for (int i = 0; i < OSC_SIZE; i++)
+    {
+        if (samples[i] < min)
+            min = samples[i];
+        if (samples[i] > max)
+            max = samples[i];
+    }
+    int32_t mv = (int32_t)(max - min) * 3300 / ADC_MAX; // adc full scale is 3.3V
+
+    text[0] = 'V';
+    text[1] = 'p';
+    text[2] = 'p';
+    text[3] = ' ';
+    int len = 4 + fmt_fixed(text + 4, mv, 3);
+    text[len++] = 'V';
+    text[len] = '\0';
+    readout_set(&readout_vpp, text);
+}
+
+#if ETS_MODE
+readout readout_ets;
+
+// ETS fill & effective sample rate → "ETS 87% 17.4M"
+void update_ets_readout()
+{
+    char text[READOUT_MAX_CHARS + 1];
+
+    text[0] = 'E';
+    text[1] = 'T';
+    text[2] = 'S';
+    text[3] = ' ';
+    int len = 4 + fmt_int(text + 4, ets_fill);
+    text[len++] = '%';
+    text[len++] = ' ';
+    len += fmt_fixed(text + len, ets_rate_x10, 1);
+    text[len++] = 'M';
+    text[len] = '\0';
+    readout_set(&readout_ets, text);
+}
+#endif
+
+#if MARKERS
+// markers : ▼ above the bar (linear view) & values at the top right of the graph
+#define MARKER_TEXT_W 20
+readout readout_marker[MARKER_MAX];
+int marker_glyph_x[MARKER_MAX]; // glyph on the screen (-1 : none)
+int marker_glyph_y[MARKER_MAX];
+
+void marker_glyph(int x, int y, uint16_t color)
+{
+    lcd_draw_line(x - 2, y - 4, x + 2, y - 4, color);
+    lcd_draw_line(x - 1, y - 3, x + 1, y - 3, color);
+    lcd_draw_pixel(x, y - 2, color);
+}
+
+// must be called before the bars are drawn, the glyphs sit above the old bar tops
+void erase_marker_glyphs()
+{
+    for (int i = 0; i < MARKER_MAX; i++)
+    {
+        if (marker_glyph_x[i] >= 0)
+            marker_glyph(marker_glyph_x[i], marker_glyph_y[i], COLOR_BG);
+        marker_glyph_x[i] = -1;
+    }
+}
+
+// 0.1 dB units, same scale as power_to_db()
+int32_t power_to_db10(float power)
+{
+    return (int32_t)(100.0f * log10f(power * 2.0f + 1e-10f));
+}
+
+void draw_markers()
+{
+    char text[READOUT_MAX_CHARS + 8];
+    int text_bottom = ver_offset + 2 + 10 * MARKER_COUNT;
+    int first_col = (SCREEN_WIDTH - MARKER_TEXT_W * 6 - hori_offset) / view_pitch;
+
+    // bars under the text area may have overwritten it
+    for (int x = first_col; x < view_cols; x++)
+    {
+        if (db_to_y(fft_result[non_active_index][x]) + ver_offset < text_bottom)
+        {
+            for (int i = 0; i < MARKER_COUNT; i++)
+                readout_invalidate(&readout_marker[i]);
+            break;
+        }
+    }
+
+    // core0 may publish the next frame while core1 draws : copy until no publish overlapped the copy
+    static marker_state view;
+    uint32_t seq;
+    do
+    {
+        seq = marker_seq;
+        __dmb();
+        for (int i = 0; i < MARKER_MAX; i++)
+            view.peak[i] = marker_out[i];
+        __dmb();
+    } while ((seq & 1) || seq != marker_seq);
+
+    for (int i = 0; i < MARKER_COUNT; i++)
+    {
+        marker_peak pk = view.peak[i];
+        int len = 0;
+        float dfreq;
+        float ratio;
+
+        if (!pk.active || (i > 0 && !marker_delta(&view, i, &dfreq, &ratio)))
+        {
+            readout_set(&readout_marker[i], "");
+            continue;
+        }
+
+        // "M1 2343.7Hz -6.1db" / "D2 +4687.5Hz -20.0db"
+        text[len++] = i == 0 ? 'M' : 'D';
+        text[len++] = '1' + i;
+        text[len++] = ' ';
+        int32_t freq10;
+        int32_t db10;
+        if (i == 0)
+        {
+            freq10 = (int32_t)(pk.freq * 10.0f);
+            db10 = power_to_db10(pk.power);
+        }
+        else
+        {
+            freq10 = (int32_t)(dfreq * 10.0f);
+            db10 = (int32_t)(100.0f * log10f(ratio));
+            if (freq10 >= 0)
+                text[len++] = '+';
+        }
+        len += fmt_fixed(text + len, freq10, 1);
+        text[len++] = 'H';
+        text[len++] = 'z';
+        text[len++] = ' ';
+        len += fmt_fixed(text + len, db10, 1);
+        text[len++] = 'd';
+        text[len++] = 'b';
+        text[len] = '\0';
+        readout_set(&readout_marker[i], text);
+
+        // glyph on the bar of the marker (linear view only)
+        if (spectrum_view == VIEW_LINEAR)
+        {
+            int col = (int)(pk.bin + 0.5f);
+            int y = db_to_y(fft_result[non_active_index][col]) + ver_offset;
+            if (col < view_cols && y - 4 > text_bottom)
+            {
+                marker_glyph_x[i] = col + hori_offset;
+                marker_glyph_y[i] = y;
+                marker_glyph(marker_glyph_x[i], y, COLOR_MARKER);
+            }
+        }
+    }
+}
+#endif
+
+// FFT棒グラフの描画（差分のみ更新）
+void draw_fft_columns(int from, int to)
+{
+    int pitch = view_pitch;
+    int width = pitch > 2 ? pitch - 1 : pitch; // 1 dot gap between wide bars
+
+    if (to > view_cols)
+        to = view_cols;
+
+    for (int x = from; x < to; x++)
+    {
+        int y_new = db_to_y(fft_result[1 - non_active_index][x]);
+        int y_old = db_to_y(fft_result[non_active_index][x]);
+
+        if (y_new != y_old && width > 1)
+        {
+            // band bars : only the difference is filled
+            int px = x * pitch + hori_offset;
+            if (y_new > y_old)
+                lcd_fill_rect(px, y_old + ver_offset, width, y_new - y_old, COLOR_BG);
+            else
+                lcd_fill_rect(px, y_new + ver_offset, width, y_old - y_new, COLOR_FG);
+        }
+        else if (y_new != y_old)
+        {
+            //  消す（古い棒） → 黒
+            if (y_old < SCREEN_HEIGHT)
+                lcd_draw_line(x + hori_offset, y_old + ver_offset, x + hori_offset, SCREEN_HEIGHT - 1, COLOR_BG);
+
+            // 描く（新しい棒） → 白
+            if (y_new < SCREEN_HEIGHT)
+                lcd_draw_line(x + hori_offset, y_new + ver_offset, x + hori_offset, SCREEN_HEIGHT - 1, COLOR_FG);
+        }
+    }
+}
+
+void draw_fft_graph()
+{
+    draw_fft_columns(0, FFT_SIZE / 2);
+}
+
+// new db_min / db_max from the shell : the plot is cleared & the bars start from the floor, so the next
+// frame draws every bar in full on the new scale
+void db_scale_update()
+{
+    if (!db_scale_changed)
+        return;
+    db_scale_changed = false;
+    db_lo = db_min;
+    db_hi = db_max;
+
+    lcd_fill_rect(hori_offset, ver_offset, SCREEN_WIDTH - hori_offset, SCREEN_HEIGHT - ver_offset, COLOR_BG);
+    for (int i = 0; i < FFT_SIZE / 2; i++)
+        fft_result[non_active_index][i] = INT16_MIN;
+    for (int i = 0; i < TONE_COUNT; i++)
+        tone_level[non_active_index][i] = INT16_MIN;
+#if MARKERS
+    for (int i = 0; i < MARKER_MAX; i++)
+    {
+        readout_invalidate(&readout_marker[i]);
+        marker_glyph_x[i] = -1; // cleared with the plot
+    }
+#endif
+    draw_db_labels();
+}
+
+#if STAGED
+// render stage : step 0 takes the block result, the next steps draw STAGE_RENDER_COLUMNS columns each
+bool stage_render(void *ctx, int block, int step)
+{
+    if (step == 0)
+    {
+        db_scale_update();
+        next = 1 - non_active_index;
+        for (int i = 0; i < FFT_SIZE / 2; i++)
+        {
+            fft_result[next][i] = stage_result[block][i];
+        }
+#if MARKERS
+        erase_marker_glyphs();
+#endif
+        return false;
+    }
+
+    int from = (step - 1) * STAGE_RENDER_COLUMNS;
+    draw_fft_columns(from, from + STAGE_RENDER_COLUMNS);
+    if (from + STAGE_RENDER_COLUMNS < FFT_SIZE / 2)
+        return false;
+
+    non_active_index = next;
+    end_display_time = time_us_32();
+    boot_frame_rendered();
+    update_peak_readout();
+    update_fps_readout();
+
+    // to draw db reference lines
+    for (int i = 0; i < GRID_LINES; i++)
+    {
+        lcd_draw_line(hori_offset - 1, ver_offset + GRID_STEP * i, SCREEN_WIDTH, ver_offset + GRID_STEP * i, COLOR_LINE);
+    }
+#if MARKERS
+    draw_markers();
+#endif
+    return true;
+}
+#endif
+
+// tone level bars（差分のみ更新）
+#define TONE_BAR_W 24
+#define TONE_BAR_PITCH 42
+void draw_tone_graph()
+{
+    char text[12];
+
+    for (int i = 0; i < TONE_COUNT; i++)
+    {
+        int y_new = db_to_y(tone_level[1 - non_active_index][i]) + ver_offset;
+        int y_old = db_to_y(tone_level[non_active_index][i]) + ver_offset;
+        int x = hori_offset + 8 + i * TONE_BAR_PITCH;
+
+        if (y_new > y_old) // level went down : erase the top part only
+            lcd_fill_rect(x, y_old, TONE_BAR_W, y_new - y_old, COLOR_BG);
+        else if (y_new < y_old) // level went up : draw the added part only
+            lcd_fill_rect(x, y_new, TONE_BAR_W, y_old - y_new, COLOR_FG);
+
+        if (y_new != y_old)
+        {
+            snprintf(text, sizeof(text), "%4ddb", tone_level[1 - non_active_index][i]);
+            lcd_draw_text(x - 3, SCREEN_HEIGHT + 11, text, COLOR_FG, COLOR_BG, 1);
+        }
+    }
+}
+
+// distortion analysis result（更新時のみ描画）
+void draw_dist_text()
+{
+    static uint32_t drawn_count = 0;
+    static bool drawn_fixed = false;
+    char text[56];
+
+    if (dist_fixed != drawn_fixed)
+    {
+        drawn_fixed = dist_fixed;
+        drawn_count = dist_out.count - 1; // the last result is drawn again when the notice goes
+        if (drawn_fixed)
+        {
+            snprintf(text, sizeof(text), "%-46s", "THD / SNR : F32 pipeline only (set pipeline 2)");
+            lcd_draw_text(char_offset, SCREEN_HEIGHT + 2, text, COLOR_FG, COLOR_BG, 1);
+            return;
+        }
+    }
+    if (drawn_fixed || dist_out.count == drawn_count)
+        return;
+    drawn_count = dist_out.count;
+
+    snprintf(text, sizeof(text), "THD%6.1fdB SNR%5.1fdB SINAD%5.1fdB ENOB%4.1f",
+             dist_out.thd_db, dist_out.snr_db, dist_out.sinad_db, dist_out.enob);
+    lcd_draw_text(char_offset, SCREEN_HEIGHT + 2, text, COLOR_FG, COLOR_BG, 1);
+}
+
+int v_to_y(int adc_value)
+{
+    return (int)((1.0 - adc_value / 4095.0) * scale * 3.3 + (5.0 - 3.3) * scale); // adc full scale is 3.3V and 1.7 * 40 is an offset
 }
 
 // Oscilloscope waveform draw（差分のみ更新）
@@ -443,34 +2324,267 @@ void draw_osc_graph()
     }
 }
 
+#if OSC_VECTOR
+// spans of the trace on screen (y without ver_offset), lo > hi : nothing drawn yet
+uint8_t osc_span_lo[OSC_SIZE];
+uint8_t osc_span_hi[OSC_SIZE];
+
+// background of a column between y0 and y1, the reference lines are kept
+void erase_osc_span(int x, int y0, int y1)
+{
+    uint16_t colors[SCREEN_HEIGHT];
+    for (int y = y0; y <= y1; y++)
+        colors[y - y0] = (y % GRID_STEP) == 0 && y < GRID_LINES * GRID_STEP ? COLOR_LINE : COLOR_BG;
+    lcd_draw_column(x + hori_offset, y0 + ver_offset, y1 - y0 + 1, colors);
+}
+
+// Oscilloscope vector trace : each column spans from its sample to half way to both neighbours,
+// so consecutive samples are connected. Only the rows that changed since the last frame are sent
+void draw_osc_trace()
+{
+    volatile int16_t *samples = adc_result[1 - non_active_index];
+    int y_prev = v_to_y(samples[0]);
+    int y = y_prev;
+
+    for (int x = 0; x < OSC_SIZE; x++)
+    {
+        int y_next = x + 1 < OSC_SIZE ? v_to_y(samples[x + 1]) : y;
+        // the same rounded midpoint ends one column & starts the next
+        int m0 = (y + y_prev) >> 1;
+        int m1 = (y + y_next) >> 1;
+        int lo = y;
+        int hi = y;
+        if (m0 < lo) lo = m0;
+        if (m1 < lo) lo = m1;
+        if (m0 > hi) hi = m0;
+        if (m1 > hi) hi = m1;
+
+        int old_lo = osc_span_lo[x];
+        int old_hi = osc_span_hi[x];
+        if (old_lo > old_hi)
+        {
+            lcd_draw_vline(x + hori_offset, lo + ver_offset, hi - lo + 1, COLOR_FG);
+        }
+        else if (lo != old_lo || hi != old_hi)
+        {
+            // erase the old rows outside the new span, draw the new rows outside the old span
+            if (old_lo < lo)
+                erase_osc_span(x, old_lo, (old_hi < lo ? old_hi : lo - 1));
+            if (old_hi > hi)
+                erase_osc_span(x, (old_lo > hi ? old_lo : hi + 1), old_hi);
+            if (lo < old_lo)
+                lcd_draw_vline(x + hori_offset, lo + ver_offset, (hi < old_lo ? hi : old_lo - 1) - lo + 1, COLOR_FG);
+            if (hi > old_hi)
+            {
+                int from = lo > old_hi ? lo : old_hi + 1;
+                lcd_draw_vline(x + hori_offset, from + ver_offset, hi - from + 1, COLOR_FG);
+            }
+        }
+        osc_span_lo[x] = lo;
+        osc_span_hi[x] = hi;
+
+        y_prev = y;
+        y = y_next;
+    }
+}
+#endif
+
+// screen format is drawn, core0 can publish frames
+void display_ready()
+{
+    boot_mark(BOOT_DISPLAY_READY);
+    render_idle = true;
+    __sev(); // wake core0 from __wfe()
+}
+
+#if FREQ_COUNTER
+readout readout_freq;
+readout readout_period;
+readout readout_duty;
+readout readout_periods;
+readout readout_level;
+
+// frequency counter screen, one update per gate (never returns)
+// value → right aligned on width characters with unit, decimals dropped while value x 10^decimals
+// does not fit an int32 → "  2343.7500 Hz"
+int fc_format(char *text, float value, int decimals, int width, const char *unit)
+{
+    float scale = 1.0f;
+    for (int i = 0; i < decimals; i++)
+        scale *= 10.0f;
+    while (decimals > 0 && fabsf(value) * scale >= 2.0e9f)
+    {
+        decimals--;
+        scale *= 0.1f;
+    }
+
+    char num[READOUT_MAX_CHARS + 1];
+    int len = fmt_fixed(num, (int32_t)lroundf(value * scale), decimals);
+    int pos = 0;
+    while (pos < width - len)
+        text[pos++] = ' ';
+    for (int i = 0; i < len; i++)
+        text[pos++] = num[i];
+    while (*unit != '\0')
+        text[pos++] = *unit++;
+    text[pos] = '\0';
+    return pos;
+}
+
+void freq_counter_display()
+{
+    char text[24];
+
+    lcd_draw_text(SCREEN_WIDTH / 2 - 40, 5, "Frequency counter", COLOR_FG, COLOR_BG, 1);
+    lcd_draw_text(char_offset, 60, "freq", COLOR_FG, COLOR_BG, 1);
+    lcd_draw_text(char_offset, 100, "period", COLOR_FG, COLOR_BG, 1);
+    lcd_draw_text(char_offset, 140, "duty", COLOR_FG, COLOR_BG, 1);
+    readout_init(&readout_freq, hori_offset, 55, 16, COLOR_FG, COLOR_BG, 2);
+    readout_init(&readout_period, hori_offset, 95, 16, COLOR_FG, COLOR_BG, 2);
+    readout_init(&readout_duty, hori_offset, 135, 16, COLOR_FG, COLOR_BG, 2);
+    readout_init(&readout_periods, hori_offset, 180, 16, COLOR_FG, COLOR_BG, 1);
+    readout_init(&readout_level, hori_offset, 195, 16, COLOR_FG, COLOR_BG, 1);
+    display_ready();
+
+    while (1)
+    {
+        multicore_fifo_pop_blocking();
+        fc_result r = fc_out;
+
+        if (r.valid)
+        {
+            fc_format(text, r.freq_hz, 4, 11, " Hz");
+            readout_set(&readout_freq, text);
+            fc_format(text, r.period_us, 4, 11, " us");
+            readout_set(&readout_period, text);
+            fc_format(text, r.duty_pct, 2, 11, " %");
+            readout_set(&readout_duty, text);
+        }
+        else
+        {
+            readout_set(&readout_freq, r.lost ? "ADC overflow" : "   no signal");
+            readout_set(&readout_period, "");
+            readout_set(&readout_duty, "");
+        }
+        fc_format(text, (float)r.periods, 0, 0, " periods");
+        readout_set(&readout_periods, text);
+        text[0] = 'l';
+        text[1] = 'v';
+        text[2] = 'l';
+        text[3] = ' ';
+        int len = 4 + fmt_int(text + 4, r.level);
+        text[len++] = ' ';
+        text[len++] = 'p';
+        text[len++] = 'p';
+        text[len++] = ' ';
+        len += fmt_int(text + len, r.pp);
+        text[len] = '\0';
+        readout_set(&readout_level, text);
+
+        end_display_time = time_us_32();
+        boot_frame_rendered();
+    }
+}
+#endif
+
 void core1_main()
 {
     stdio_init_all();
+#if RECORDER
+    // core1 parks in RAM while core0 erases / programs the capture ring
+    flash_safe_execute_core_init();
+#endif
 
-    sleep_ms(500);
     // Initialize the LCD
+#if FAST_BOOT
+    lcd_init_fast();
+#else
+    sleep_ms(500);
     lcd_init();
+#endif
+    boot_mark(BOOT_LCD_INIT);
     // to draw the display format
     lcd_fill_color(COLOR_BG);
+    boot_mark(BOOT_LCD_CLEAR);
 
     if (time_freq == true)
     {
+#if FREQ_COUNTER
+        freq_counter_display();
+#endif
         // print level guide
+#if TONE_TRACK
+        lcd_draw_text(SCREEN_WIDTH / 2 - 40, 5, "Tone tracking", COLOR_FG, COLOR_BG, 1);
+#else
         lcd_draw_text(SCREEN_WIDTH / 2 - 40, 5, "Spectrum analizer", COLOR_FG, COLOR_BG, 1);
-        lcd_draw_text(char_offset + 10, 0 + ver_offset - 3, "0db", COLOR_FG, COLOR_BG, 1);
-        lcd_draw_text(char_offset, 40 + ver_offset - 3, "-20db", COLOR_FG, COLOR_BG, 1);
-        lcd_draw_text(char_offset, 80 + ver_offset - 3, "-40db", COLOR_FG, COLOR_BG, 1);
-        lcd_draw_text(char_offset, 120 + ver_offset - 3, "-60db", COLOR_FG, COLOR_BG, 1);
-        lcd_draw_text(char_offset, 160 + ver_offset - 3, "-80db", COLOR_FG, COLOR_BG, 1);
-        lcd_draw_text(char_offset - 5, 200 + ver_offset - 3, "-100db", COLOR_FG, COLOR_BG, 1);
-        lcd_draw_text(SCREEN_WIDTH / 2, 230, "<0~25KHz>", COLOR_FG, COLOR_BG, 1);
+#endif
+        readout_init(&readout_fps, 5, 5, 8, COLOR_FG, COLOR_BG, 1);
+        readout_init(&readout_peak, SCREEN_WIDTH - 84, 5, 14, COLOR_FG, COLOR_BG, 1);
+#if MARKERS
+        for (int i = 0; i < MARKER_MAX; i++)
+        {
+            readout_init(&readout_marker[i], SCREEN_WIDTH - MARKER_TEXT_W * 6, ver_offset + 2 + 10 * i, MARKER_TEXT_W, COLOR_MARKER, COLOR_BG, 1);
+            marker_glyph_x[i] = -1;
+        }
+#endif
+        draw_db_labels();
+#if TONE_TRACK
+        // tone frequency labels [Hz]
+        for (int i = 0; i < TONE_COUNT; i++)
+        {
+            char text[12];
+            snprintf(text, sizeof(text), "%5d", (int)tone_freq[i]);
+            lcd_draw_text(hori_offset + 5 + i * TONE_BAR_PITCH, SCREEN_HEIGHT + 2, text, COLOR_FG, COLOR_BG, 1);
+        }
+#else
+        if (spectrum_view == VIEW_LOG)
+            lcd_draw_text(SCREEN_WIDTH / 2, 230, "<50Hz~25KHz log>", COLOR_FG, COLOR_BG, 1);
+        else if (spectrum_view == VIEW_OCT1)
+            lcd_draw_text(SCREEN_WIDTH / 2, 230, "<1/1 oct 63Hz~16KHz>", COLOR_FG, COLOR_BG, 1);
+        else if (spectrum_view == VIEW_OCT3)
+            lcd_draw_text(SCREEN_WIDTH / 2, 230, "<1/3 oct 50Hz~20KHz>", COLOR_FG, COLOR_BG, 1);
+        else if (spectrum_view == VIEW_OCT6)
+            lcd_draw_text(SCREEN_WIDTH / 2, 230, "<1/6 oct 50Hz~23KHz>", COLOR_FG, COLOR_BG, 1);
+        else
+            lcd_draw_text(SCREEN_WIDTH / 2, 230, "<0~25KHz>", COLOR_FG, COLOR_BG, 1);
+#endif
         // X/Y line
         lcd_draw_line(hori_offset - 1, ver_offset, hori_offset - 1, SCREEN_HEIGHT - 1, COLOR_FG);
         lcd_draw_line(hori_offset - 1, SCREEN_HEIGHT, SCREEN_WIDTH, SCREEN_HEIGHT, COLOR_FG);
+        display_ready();
+
+#if STAGED
+        while (!stage_ready)
+            tight_loop_contents();
+        while (1)
+        {
+            // render steps interleave with DSP chunks, core0 takes the chunks while core1 draws
+            sched_render_poll(&stage, 1);
+            sched_dsp_poll(&stage, 1);
+        }
+#endif
 
         while (1)
         {
             uint32_t data = multicore_fifo_pop_blocking();
+            uint32_t render_start = time_us_32();
+            db_scale_update();
+
+#if TONE_TRACK
+            next = 1 - non_active_index;
+            for (int i = 0; i < TONE_COUNT; i++)
+            {
+                tone_level[next][i] = tone_level_tmp[i];
+            }
+
+            draw_tone_graph();
+
+            non_active_index = next;
+
+            end_display_time = time_us_32();
+            boot_frame_rendered();
+            continue;
+#endif
 
             next = 1 - non_active_index;
             // to move fft data to the display buffer
@@ -479,36 +2593,76 @@ void core1_main()
                 fft_result[next][i] = fft_result_tmp[i];
             }
 
+#if MARKERS
+            erase_marker_glyphs();
+#endif
             draw_fft_graph();
+#if DIST_ANALYSIS
+            draw_dist_text();
+#endif
+            update_peak_readout();
+            update_fps_readout();
 
             // change the dual buffer active one
             non_active_index = next;
 
             end_display_time = time_us_32();
+            boot_frame_rendered();
 
             // to draw db reference lines
-            for (int i = 0; i < 5; i++)
+            for (int i = 0; i < GRID_LINES; i++)
             {
-                lcd_draw_line(hori_offset - 1, ver_offset + 40 * i, SCREEN_WIDTH, ver_offset + 40 * i, COLOR_LINE);
+                lcd_draw_line(hori_offset - 1, ver_offset + GRID_STEP * i, SCREEN_WIDTH, ver_offset + GRID_STEP * i, COLOR_LINE);
             }
+#if MARKERS
+            draw_markers();
+#endif
+            render_time_us = time_us_32() - render_start;
+
+#if FRAME_GOVERNOR
+            gov_add_render(&gov, render_time_us);
+            render_idle = true;
+            __sev(); // wake core0 from __wfe()
+#endif
         }
     }
     else
     { // print voltage guide
         lcd_draw_text(SCREEN_WIDTH / 2 - 40, 5, "Oscilloscope", COLOR_FG, COLOR_BG, 1);
+        readout_init(&readout_vpp, 5, 5, 10, COLOR_FG, COLOR_BG, 1);
+        readout_init(&readout_fps, SCREEN_WIDTH - 48, 5, 8, COLOR_FG, COLOR_BG, 1);
         lcd_draw_text(char_offset + 20, 0 + ver_offset - 3, "5V", COLOR_FG, COLOR_BG, 1);
         lcd_draw_text(char_offset + 20, 40 + ver_offset - 3, "4V", COLOR_FG, COLOR_BG, 1);
         lcd_draw_text(char_offset + 20, 80 + ver_offset - 3, "3V", COLOR_FG, COLOR_BG, 1);
         lcd_draw_text(char_offset + 20, 120 + ver_offset - 3, "2V", COLOR_FG, COLOR_BG, 1);
         lcd_draw_text(char_offset + 20, 160 + ver_offset - 3, "1V", COLOR_FG, COLOR_BG, 1);
         lcd_draw_text(char_offset + 20, 200 + ver_offset - 3, "0V", COLOR_FG, COLOR_BG, 1);
+#if ETS_MODE
+        char span[24];
+        int span_ns = (int)(OSC_SIZE * ETS_BIN_NS);
+        snprintf(span, sizeof(span), "<%d.%d micro sec>", span_ns / 1000, span_ns % 1000 / 100);
+        lcd_draw_text(SCREEN_WIDTH / 2, 230, span, COLOR_FG, COLOR_BG, 1);
+        readout_init(&readout_ets, 5, 230, 14, COLOR_FG, COLOR_BG, 1);
+#else
         lcd_draw_text(SCREEN_WIDTH / 2, 230, "<500 mciro sec>", COLOR_FG, COLOR_BG, 1);
+#endif
         // X/Y line
         lcd_draw_line(hori_offset - 1, ver_offset, hori_offset - 1, SCREEN_HEIGHT, COLOR_FG);
         lcd_draw_line(hori_offset - 1, SCREEN_HEIGHT + 1, SCREEN_WIDTH, SCREEN_HEIGHT + 1, COLOR_FG);
+#if OSC_VECTOR
+        // drawn once, erase_osc_span() restores them under the trace
+        for (int i = 0; i < GRID_LINES; i++)
+        {
+            lcd_draw_line(hori_offset - 1, ver_offset + GRID_STEP * i, SCREEN_WIDTH, ver_offset + GRID_STEP * i, COLOR_LINE);
+        }
+        memset(osc_span_lo, 0xFF, sizeof(osc_span_lo));
+        memset(osc_span_hi, 0, sizeof(osc_span_hi));
+#endif
+        display_ready();
         while (1)
         {
             uint32_t data = multicore_fifo_pop_blocking();
+            uint32_t render_start = time_us_32();
 
             next = 1 - non_active_index;
             // to move fft data to the display buffer
@@ -517,18 +2671,169 @@ void core1_main()
                 adc_result[next][i] = adc_result_tmp[i];
             }
 
+#if OSC_VECTOR
+            draw_osc_trace();
+#else
             draw_osc_graph();
+#endif
+            update_vpp_readout(adc_result[next]);
+            update_fps_readout();
+#if ETS_MODE
+            update_ets_readout();
+#endif
 
             // change the dual buffer active one
             non_active_index = next;
 
             end_display_time = time_us_32();
+            render_time_us = end_display_time - render_start;
+            boot_frame_rendered();
 
+#if !OSC_VECTOR
             // to draw voltage reference lines
-            for (int i = 0; i < 5; i++)
+            for (int i = 0; i < GRID_LINES; i++)
             {
-                lcd_draw_line(hori_offset - 1, ver_offset + 40 * i, SCREEN_WIDTH, ver_offset + 40 * i, COLOR_LINE);
+                lcd_draw_line(hori_offset - 1, ver_offset + GRID_STEP * i, SCREEN_WIDTH, ver_offset + GRID_STEP * i, COLOR_LINE);
             }
+#endif
         }
     }
 }
+
+#if USB_SHELL
+// ----------------------------------------------------------------------------
+// USB command shell (core0) : parameters are set between frames, the stage timings of the
+// following frame are printed after a set
+shell usb_shell;
+bool shell_report = false; // print the stage timings at the next poll
+
+// compile time buffer sizes, listed read only
+volatile int shell_fft_size = FFT_SIZE;
+volatile int shell_decimate_n = DECIMATE_N;
+
+void shell_apply_gain()
+{
+    mcp4131_write(val_resi);
+}
+
+// the plain loop reads frame_rate on each capture, the governor keeps it as its averaging bound
+void shell_apply_frame_rate()
+{
+#if FRAME_GOVERNOR
+    gov.max_avg = frame_rate;
+#endif
+}
+
+// core1 redraws the labels & the bars before its next frame
+void shell_apply_db_scale()
+{
+    db_scale_changed = true;
+}
+
+#if ETS_MODE && ETS_TRIGGER == ETS_TRIG_PWM
+// the bins of the old latency are dropped (a set of the same value only clears the trace)
+void shell_apply_ets()
+{
+    ets_clear(&ets);
+}
+#endif
+
+// the power accumulated with the old pipeline is dropped, the next capture starts the new filter
+void shell_apply_pipeline()
+{
+    memset(fft_power_acc, 0, sizeof(fft_power_acc));
+    fft_power_count = 0;
+}
+
+const shell_param shell_params[] = {
+    {"fft_size", &shell_fft_size, FFT_SIZE, FFT_SIZE, SHELL_RO, NULL, "FFT points (static buffers)"},
+    {"decimate_n", &shell_decimate_n, DECIMATE_N, DECIMATE_N, SHELL_RO, NULL, "ADC samples per FFT sample"},
+    {"frame_rate", &frame_rate, 1, 50, TONE_TRACK || STAGED ? SHELL_RO : 0, shell_apply_frame_rate,
+     "captures per displayed frame"},
+    {"alpha", &filter_alpha, 1, 32767, 0, NULL, "IIR coefficient (Q15), 8192 : 23KHz"},
+    {"gain", &val_resi, 0, 0x7f, 0, shell_apply_gain, "MCP4131 wiper, 0x3f : 6db"},
+    {"scale", &scale, 10, 40, 0, NULL, "oscilloscope [dots / V], grid labels for 40"},
+    {"pipeline", &fft_pipeline, PIPE_Q15, PIPE_F32, TONE_TRACK ? SHELL_RO : 0, shell_apply_pipeline,
+     "0 : Q15, 1 : Q31, 2 : F32"},
+    {"bfp", &bfp_auto, 0, 1, 0, NULL, "block floating point (Q15)"},
+    {"db_min", &db_min, -160, -20, 0, shell_apply_db_scale, "floor level [dB]"},
+    {"db_max", &db_max, -10, 20, 0, shell_apply_db_scale, "top level [dB]"},
+#if ETS_MODE && ETS_TRIGGER == ETS_TRIG_PWM
+    {"ets_lat", &ets_latency_ns, -5000, 5000, 0, shell_apply_ets, "ETS counter to ADC start [ns], clears"},
+#endif
+};
+
+void shell_print(const char *text)
+{
+    printf("%s", text);
+}
+
+// last frame : capture (+ streamed filter), filter, window, FFT & render times
+void shell_print_stats()
+{
+    const char *pipe_name[PIPE_COUNT] = {"q15", "q31", "f32"};
+
+    if (!time_freq)
+    {
+        printf("stage render %lu us, frame %lu us\n", (unsigned long)render_time_us, (unsigned long)frame_interval_us);
+#if ETS_MODE
+        ets_print_report();
+#endif
+        return;
+    }
+#if !FRAME_GOVERNOR && !STAGED && !TONE_TRACK
+    printf("spectrum %lu captures in %lu frames\n", (unsigned long)plain_captures, (unsigned long)plain_frames);
+    plain_captures = 0;
+    plain_frames = 0;
+#endif
+#if DIST_ANALYSIS
+    dist_result d = dist_out;
+    printf("dist %lu results, fundamental bin %d THD %.1fdB SNR %.1fdB SINAD %.1fdB ENOB %.1f\n",
+           (unsigned long)d.count, d.fund_bin, d.thd_db, d.snr_db, d.sinad_db, d.enob);
+#endif
+    printf("stage capture %lu filter %lu window %lu fft %lu render %lu us, frame %lu us (%s)\n",
+           (unsigned long)(start_preprocess_time - start_adc_time), (unsigned long)(end_filter_time - start_preprocess_time),
+           (unsigned long)(start_fft_time - end_filter_time), (unsigned long)(end_fft_time - start_fft_time),
+           (unsigned long)render_time_us, (unsigned long)frame_interval_us, pipe_name[decim.pipeline]);
+    // last fft_exec() of each pipeline, 0 until the pipeline has run ("set pipeline N" then "stats")
+    printf("fft_exec");
+    for (int i = 0; i < PIPE_COUNT; i++)
+        printf(" %s %lu", pipe_name[i], (unsigned long)fft_exec_us[i]);
+    printf(" us\n");
+#if STREAM_CAPTURE
+    if (stream_overruns != 0)
+        printf("adc fifo overflow : %lu captures, %lu blocks kept with lost samples\n",
+               (unsigned long)stream_overruns, (unsigned long)stream_dropped);
+#endif
+#if XIP_STATS
+    xip_print_report();
+#endif
+#if HEADROOM
+    if (time_freq)
+        hr_print_report();
+#endif
+}
+
+void shell_setup()
+{
+    shell_init(&usb_shell, shell_params, sizeof(shell_params) / sizeof(shell_params[0]), shell_print,
+               shell_print_stats);
+}
+
+// read the pending USB input without waiting, called by core0 after each frame
+void shell_poll()
+{
+    int c;
+
+    if (shell_report)
+    {
+        shell_print_stats();
+        shell_report = false;
+    }
+    while ((c = getchar_timeout_us(0)) != PICO_ERROR_TIMEOUT)
+    {
+        if (shell_input(&usb_shell, c) == SHELL_SET)
+            shell_report = true;
+    }
+}
+#endif
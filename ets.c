@@ -0,0 +1,170 @@
+// ets.c
+// equivalent time sampling : trigger time stamps, binning & reconstruction
+// Times are kept in ADC samples (float) from the start of the acquisition, a sample i lands in the bin
+// of its time to the trigger (i - t_trig) * ts_ns / bin_ns, offset by the pre trigger bins
+
+#include "ets.h"
+#include <math.h>
+
+void ets_init(ets_state *st, int bins, int pre_bins, float bin_ns, float ts_ns) {
+    if (bins > ETS_MAX_BINS)
+        bins = ETS_MAX_BINS;
+    if (bins < 2)
+        bins = 2;
+    if (pre_bins < 0 || pre_bins >= bins)
+        pre_bins = 0;
+
+    st->bins = bins;
+    st->pre_bins = pre_bins;
+    st->bin_ns = bin_ns;
+    st->ts_ns = ts_ns;
+    ets_clear(st);
+}
+
+void ets_clear(ets_state *st) {
+    for (int i = 0; i < st->bins; i++) {
+        st->sum[i] = 0;
+        st->count[i] = 0;
+    }
+    st->filled = 0;
+    st->acquisitions = 0;
+    st->triggers = 0;
+    st->samples = 0;
+}
+
+static inline void put(ets_state *st, int bin, uint16_t v) {
+    if (st->count[bin] == 0)
+        st->filled++;
+    if (st->count[bin] < ETS_AVG) {
+        st->sum[bin] += v;
+        st->count[bin]++;
+    } else {
+        st->sum[bin] += v - st->sum[bin] / ETS_AVG;
+    }
+    st->samples++;
+}
+
+// samples in the window of one trigger at t_trig [samples]
+static void bin_trigger(ets_state *st, const uint16_t *x, int n, float t_trig) {
+    float scale = st->ts_ns / st->bin_ns; // bins per sample
+    float span0 = -st->pre_bins / scale;  // window [samples from the trigger]
+    float span1 = (st->bins - st->pre_bins) / scale;
+    int i0 = (int)ceilf(t_trig + span0);
+    int i1 = (int)ceilf(t_trig + span1);
+
+    if (i0 < 0)
+        i0 = 0;
+    if (i1 > n)
+        i1 = n;
+    for (int i = i0; i < i1; i++) {
+        int bin = (int)floorf((i - t_trig) * scale) + st->pre_bins;
+        if (bin >= 0 && bin < st->bins)
+            put(st, bin, x[i]);
+    }
+    st->triggers++;
+}
+
+int ets_add_level(ets_state *st, const uint16_t *x, int n, uint16_t level, uint16_t hyst) {
+    int32_t arm = (int32_t)level - hyst;
+    int armed = 0;
+    int events = 0;
+
+    for (int i = 0; i < n; i++) {
+        if (!armed) {
+            armed = x[i] <= arm;
+        } else if (x[i] >= level && i > 0) {
+            int32_t a = x[i - 1];
+            int32_t b = x[i];
+            bin_trigger(st, x, n, (float)(i - 1) + (float)((int32_t)level - a) / (float)(b - a));
+            armed = 0;
+            events++;
+        }
+    }
+    st->acquisitions++;
+    return events;
+}
+
+int ets_add_phase(ets_state *st, const uint16_t *x, int n, float phase0_ns, float period_ns) {
+    float scale = st->ts_ns / st->bin_ns;
+    float span0 = -st->pre_bins / scale;
+    float span1 = (st->bins - st->pre_bins) / scale;
+    float p = period_ns / st->ts_ns;
+    float t = -phase0_ns / st->ts_ns; // trigger before sample 0
+    int events = 0;
+
+    // earliest trigger whose window reaches sample 0, then every period up to the end
+    while (t - p + span1 > 0.0f)
+        t -= p;
+    for (; t + span0 < n; t += p) {
+        bin_trigger(st, x, n, t);
+        events++;
+    }
+    st->acquisitions++;
+    return events;
+}
+
+void ets_reconstruct(const ets_state *st, int16_t *out) {
+    int last = -1; // last filled bin
+
+    for (int i = 0; i < st->bins; i++) {
+        if (st->count[i] == 0)
+            continue;
+        int16_t v = (int16_t)((st->sum[i] + st->count[i] / 2) / st->count[i]);
+        out[i] = v;
+        if (last < 0) {
+            for (int j = 0; j < i; j++)
+                out[j] = v;
+        } else {
+            for (int j = last + 1; j < i; j++)
+                out[j] = out[last] + (int32_t)(v - out[last]) * (j - last) / (i - last);
+        }
+        last = i;
+    }
+    for (int j = last + 1; j < st->bins; j++)
+        out[j] = last < 0 ? 0 : out[last];
+}
+
+bool ets_edge_ns(const ets_state *st, const int16_t *trace, float *edge_ns) {
+    int16_t lo = trace[0];
+    int16_t hi = trace[0];
+
+    for (int i = 1; i < st->bins; i++) {
+        lo = trace[i] < lo ? trace[i] : lo;
+        hi = trace[i] > hi ? trace[i] : hi;
+    }
+    if (st->filled * 2 < st->bins || hi - lo < ETS_EDGE_MIN)
+        return false;
+
+    // a bin holds the samples of [b, b + 1) bins from the trigger, its value is taken at the bin centre
+    int32_t mid = ((int32_t)lo + hi) / 2;
+    int32_t low = lo + (hi - lo) / 10;
+    int32_t high = hi - (hi - lo) / 10;
+    bool found = false;
+    for (int i = 1; i < st->bins; i++) {
+        if (trace[i - 1] >= mid || trace[i] < mid)
+            continue;
+        // an edge : 10% .. 90% within half the trace, a slow ramp over the trace has no time of its own
+        int a = i - 1;
+        int c = i;
+        while (a > 0 && trace[a] > low && c - a <= st->bins / 2)
+            a--;
+        while (c < st->bins - 1 && trace[c] < high && c - a <= st->bins / 2)
+            c++;
+        if (trace[a] > low || trace[c] < high || c - a > st->bins / 2)
+            continue;
+        float b = (float)(i - 1) + (float)(mid - trace[i - 1]) / (float)(trace[i] - trace[i - 1]);
+        float t = (b + 0.5f - st->pre_bins) * st->bin_ns;
+        if (!found || fabsf(t) < fabsf(*edge_ns))
+            *edge_ns = t;
+        found = true;
+    }
+    return found;
+}
+
+int ets_fill_pct(const ets_state *st) {
+    return st->filled * 100 / st->bins;
+}
+
+float ets_rate_msps(const ets_state *st) {
+    return st->filled * 1000.0f / (st->bins * st->bin_ns);
+}
@@ -0,0 +1,69 @@
+// ets.h
+// equivalent time sampling (random interleaved) of repetitive signals
+// Each trigger event of an acquisition gets a time stamp finer than the ADC period, the samples around it
+// are binned by their time to the trigger into a reconstruction buffer of bin_ns bins. Acquisitions start
+// at random phases of the signal, so the buffer fills in progressively at a rate beyond the ADC rate
+// Portable, the binning & the reconstruction can be fed synthetic captures on a host
+
+#ifndef ETS_H
+#define ETS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define ETS_MAX_BINS 512
+#define ETS_AVG 16          // a bin averages its last ~ETS_AVG samples (moving average once full)
+#define ETS_EDGE_MIN 16     // smallest swing of the trace for ets_edge_ns() [LSB]
+
+typedef struct {
+    int bins;
+    int pre_bins;           // bins before the trigger
+    float bin_ns;
+    float ts_ns;            // ADC sample period
+    int32_t sum[ETS_MAX_BINS];
+    uint16_t count[ETS_MAX_BINS];
+    int filled;             // bins holding at least one sample
+    uint32_t acquisitions;
+    uint32_t triggers;      // trigger events binned
+    uint32_t samples;       // samples binned
+} ets_state;
+
+// Function to initialize the reconstruction buffer
+// bins: number of bins (<= ETS_MAX_BINS), pre_bins: bins before the trigger
+// bin_ns: bin width [ns], ts_ns: ADC sample period [ns]
+void ets_init(ets_state *st, int bins, int pre_bins, float bin_ns, float ts_ns);
+
+// Function to empty the buffer (signal change)
+void ets_clear(ets_state *st);
+
+// Function to bin an acquisition on a level trigger : every rising crossing of level (armed below
+// level - hyst) is a trigger, its time is interpolated between the two samples. The edge must span
+// more than one sample (band limited signal) for a time stamp finer than the ADC period
+// Returns: number of trigger events
+int ets_add_level(ets_state *st, const uint16_t *x, int n, uint16_t level, uint16_t hyst);
+
+// Function to bin an acquisition on a timer trigger : the signal period & the phase of the first sample
+// in it are known (e.g. the counter of the PWM generating the signal), the trigger is at phase 0
+// phase0_ns: time from the trigger to sample 0 (0 .. period_ns)
+// Returns: number of trigger events (periods) in the acquisition
+int ets_add_phase(ets_state *st, const uint16_t *x, int n, float phase0_ns, float period_ns);
+
+// Function to get the reconstructed waveform, bins values, empty bins are interpolated between the
+// nearest filled bins
+// out: bins values
+void ets_reconstruct(const ets_state *st, int16_t *out);
+
+// Function to get the time of the rising mid level crossing of the trace nearest to the trigger, the
+// calibration of a trigger latency : the edge that triggers sits at 0 once the latency is compensated
+// trace: ets_reconstruct() output, edge_ns: time from the trigger [ns]
+// Returns: false if the trace is less than half filled, flat (< ETS_EDGE_MIN) or has no rising edge
+// (10% .. 90% of the swing within half the trace)
+bool ets_edge_ns(const ets_state *st, const int16_t *trace, float *edge_ns);
+
+// Function to get the share of the bins holding samples [%]
+int ets_fill_pct(const ets_state *st);
+
+// Function to get the effective sample rate : filled bins over the buffer time span [Msps]
+float ets_rate_msps(const ets_state *st);
+
+#endif // ETS_H
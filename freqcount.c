@@ -0,0 +1,155 @@
+// freqcount.c
+// frequency / period / duty counter
+// Each step of the crossing search is a "first sample above / below a threshold" scan
+
+#include "freqcount.h"
+
+#define FC_HYST_DIV 8       // hysteresis band = +- peak to peak / FC_HYST_DIV around the level
+#define FC_HYST_MIN 8       // [ADC counts], keeps ADC noise from re-arming the trigger
+#define FC_MIN_PP 32        // smaller signals are not counted
+
+// crossing search steps
+#define FC_ARM_LOW 0        // wait for x <= arm_lo
+#define FC_RISE 1           // wait for x >= level : rising crossing
+#define FC_ARM_HIGH 2       // wait for x >= arm_hi
+#define FC_FALL 3           // wait for x < level : falling crossing
+
+static void set_level(fc_state *st, uint16_t level, uint16_t hyst) {
+    st->level = level;
+    st->arm_lo = level > hyst ? level - hyst : 0;
+    st->arm_hi = level + hyst;
+}
+
+static void gate_reset(fc_state *st) {
+    st->first_rise = -1;
+    st->last_rise = -1;
+    st->high_sum = 0;
+    st->high_open = 0;
+    st->rises = 0;
+    st->min = 0xFFFF;
+    st->max = 0;
+    st->lost = false;
+}
+
+void fc_init(fc_state *st, float fs, uint16_t level) {
+    st->fs = fs;
+    st->phase = FC_ARM_LOW;
+    st->prev = level;
+    st->base = 0;
+    set_level(st, level, FC_HYST_MIN);
+    gate_reset(st);
+}
+
+// first index >= i with x >= t (n if none)
+static int find_above(const uint16_t *x, int i, int n, uint16_t t) {
+    for (; i < n; i++)
+        if (x[i] >= t)
+            return i;
+    return n;
+}
+
+// first index >= i with x < t (n if none)
+static int find_below(const uint16_t *x, int i, int n, uint16_t t) {
+    for (; i < n; i++)
+        if (x[i] < t)
+            return i;
+    return n;
+}
+
+void fc_lost(fc_state *st) {
+    st->lost = true;
+    st->phase = FC_ARM_LOW; // no crossing is interpolated across the gap
+}
+
+// time of the level crossing between samples k - 1 (a) & k (b) [samples, Q16]
+static int64_t crossing_time(const fc_state *st, int k, int32_t a, int32_t b) {
+    int64_t t = (st->base + k - 1) << 16;
+    return t + (((int64_t)((int32_t)st->level - a) << 16) / (b - a));
+}
+
+void fc_process(fc_state *st, const uint16_t *x, int n) {
+    int i = 0;
+
+    if (n <= 0)
+        return; // x[n - 1] is kept for the next chunk
+
+    // amplitude of the gate
+    uint16_t lo = st->min;
+    uint16_t hi = st->max;
+    for (int k = 0; k < n; k++) {
+        lo = x[k] < lo ? x[k] : lo;
+        hi = x[k] > hi ? x[k] : hi;
+    }
+    st->min = lo;
+    st->max = hi;
+
+    while (i < n) {
+        switch (st->phase) {
+        case FC_ARM_LOW:
+            i = find_below(x, i, n, st->arm_lo + 1);
+            if (i < n)
+                st->phase = FC_RISE;
+            break;
+        case FC_RISE:
+            i = find_above(x, i, n, st->level);
+            if (i < n) {
+                int32_t a = i > 0 ? x[i - 1] : st->prev;
+                int64_t t = crossing_time(st, i, a, x[i]);
+                if (st->first_rise < 0)
+                    st->first_rise = t;
+                else
+                    st->high_sum = st->high_open; // the period before t is complete
+                st->last_rise = t;
+                st->rises++;
+                st->phase = FC_ARM_HIGH;
+            }
+            break;
+        case FC_ARM_HIGH:
+            i = find_above(x, i, n, st->arm_hi);
+            if (i < n)
+                st->phase = FC_FALL;
+            break;
+        default: // FC_FALL
+            i = find_below(x, i, n, st->level);
+            if (i < n) {
+                int32_t a = i > 0 ? x[i - 1] : st->prev;
+                int64_t t = crossing_time(st, i, a, x[i]);
+                if (st->last_rise >= 0)
+                    st->high_open = st->high_sum + (t - st->last_rise);
+                st->phase = FC_ARM_LOW;
+            }
+            break;
+        }
+    }
+
+    st->prev = x[n - 1];
+    st->base += n;
+}
+
+void fc_gate(fc_state *st, fc_result *r) {
+    uint16_t pp = st->max > st->min ? st->max - st->min : 0;
+
+    r->level = st->level;
+    r->pp = pp;
+    r->periods = st->rises > 1 ? st->rises - 1 : 0;
+    r->lost = st->lost;
+    r->valid = r->periods > 0 && pp >= FC_MIN_PP && !st->lost;
+    if (r->valid) {
+        double span = (double)(st->last_rise - st->first_rise) / 65536.0; // [samples]
+        double period = span / r->periods;
+        r->freq_hz = st->fs / period;
+        r->period_us = period * 1e6 / st->fs;
+        r->duty_pct = (float)(100.0 * (double)st->high_sum / 65536.0 / span);
+    } else {
+        r->freq_hz = 0.0;
+        r->period_us = 0.0;
+        r->duty_pct = 0.0f;
+    }
+
+    // next gate : level in the middle of the signal
+    if (pp >= FC_MIN_PP) {
+        uint16_t hyst = pp / FC_HYST_DIV;
+        set_level(st, st->min + pp / 2, hyst < FC_HYST_MIN ? FC_HYST_MIN : hyst);
+    }
+    gate_reset(st);
+}
@@ -0,0 +1,60 @@
+// freqcount.h
+// frequency / period / duty counter on the full rate ADC stream
+// Level crossings (Schmitt trigger armed) are interpolated between samples, the frequency is the reciprocal
+// of the mean period between the first & last rising crossing of a gate (reciprocal counting)
+// Portable, the kernel can be fed synthetic streams on a host
+
+#ifndef FREQCOUNT_H
+#define FREQCOUNT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Result of one gate
+typedef struct {
+    bool valid;         // at least 2 rising crossings with enough amplitude, no samples lost
+    bool lost;          // samples were lost in the gate (fc_lost)
+    double freq_hz;
+    double period_us;
+    float duty_pct;     // high time / period
+    uint32_t periods;   // periods averaged
+    uint16_t level;     // crossing level used in the gate [ADC counts]
+    uint16_t pp;        // peak to peak amplitude of the gate [ADC counts]
+} fc_result;
+
+typedef struct {
+    float fs;           // sample rate [Hz]
+    int phase;          // crossing search step (arm low, rise, arm high, fall)
+    uint16_t level;     // crossing level
+    uint16_t arm_lo;    // rising crossings are armed below this
+    uint16_t arm_hi;    // falling crossings are armed above this
+    uint16_t prev;      // last sample of the previous chunk
+    int64_t base;       // index of the first sample of the current chunk
+    int64_t first_rise; // crossing times of the gate [samples, Q16], -1 : none yet
+    int64_t last_rise;
+    int64_t high_sum;   // high time of the complete periods [samples, Q16]
+    int64_t high_open;  // high time since first_rise, not closed by a rising crossing yet
+    uint32_t rises;
+    uint16_t min;       // amplitude of the gate, gives the level & hysteresis of the next gate
+    uint16_t max;
+    bool lost;          // fc_lost() was called in the gate
+} fc_state;
+
+// Function to initialize the counter
+// fs: sample rate [Hz]
+// level: initial crossing level [ADC counts], it then follows the middle of the signal
+void fc_init(fc_state *st, float fs, uint16_t level);
+
+// Function to feed samples, any chunk size (streaming, the state is kept between calls)
+// x: ADC samples (12 bit)
+// n: number of samples, nothing is done for n <= 0
+void fc_process(fc_state *st, const uint16_t *x, int n);
+
+// Function to report samples missing from the stream (ADC FIFO overflow), the gate is not valid
+void fc_lost(fc_state *st);
+
+// Function to close the gate, compute the result & start a new gate on the following samples
+// The level & hysteresis of the next gate are set from the amplitude of this one
+void fc_gate(fc_state *st, fc_result *r);
+
+#endif // FREQCOUNT_H
@@ -0,0 +1,97 @@
+// goertzel.c
+// fixed-point Goertzel filter bank
+// s[n] = x[n] + coeff * s[n-1] - s[n-2], |X|^2 = s1^2 + s2^2 - coeff * s1 * s2
+
+#include "goertzel.h"
+#include <math.h>
+
+// input is shifted down to keep the resonator state inside int32 for low frequencies
+#define GOERTZEL_IN_SHIFT 2
+#define GOERTZEL_DB_FLOOR -120
+
+void goertzel_bank_init(goertzel_bank *bank, const float *freqs, int count, float fs, int block_len) {
+    if (count > GOERTZEL_MAX_TONES)
+        count = GOERTZEL_MAX_TONES;
+
+    bank->count = count;
+    bank->block_len = block_len;
+    bank->fs = fs;
+    bank->blocks = 0;
+
+    for (int i = 0; i < count; i++) {
+        float w = 2.0f * (float)M_PI * freqs[i] / fs;
+        bank->tone[i].freq = freqs[i];
+        bank->tone[i].coeff = (int32_t)lrintf(2.0f * cosf(w) * 16384.0f);   // Q14
+        bank->tone[i].level_db = GOERTZEL_DB_FLOOR;
+    }
+
+    // full scale amplitude after the input shift, |X| = A * N / 2
+    float full_scale = (32768 >> GOERTZEL_IN_SHIFT) * (float)block_len * 0.5f;
+    bank->ref_db = 20.0f * log10f(full_scale);
+
+    goertzel_bank_reset(bank);
+}
+
+void goertzel_bank_reset(goertzel_bank *bank) {
+    for (int i = 0; i < bank->count; i++) {
+        bank->tone[i].s1 = 0;
+        bank->tone[i].s2 = 0;
+    }
+    bank->n = 0;
+}
+
+// convert the final state of one filter to dBFS
+static int16_t goertzel_level(const goertzel_filter *f, float ref_db) {
+    int64_t s1 = f->s1;
+    int64_t s2 = f->s2;
+    int64_t power = s1 * s1 + s2 * s2 - ((f->coeff * s1) >> 14) * s2;
+
+    if (power <= 0)
+        return GOERTZEL_DB_FLOOR;
+
+    float db = 10.0f * log10f((float)power) - ref_db;
+    if (db < GOERTZEL_DB_FLOOR)
+        db = GOERTZEL_DB_FLOOR;
+    return (int16_t)db;
+}
+
+int goertzel_bank_process(goertzel_bank *bank, const int16_t *input, int len) {
+    int done = 0;
+
+    while (len > 0) {
+        // samples left until the end of the current block
+        int chunk = bank->block_len - bank->n;
+        if (chunk > len)
+            chunk = len;
+
+        // one tone at a time keeps s1/s2/coeff in registers for the inner loop
+        for (int t = 0; t < bank->count; t++) {
+            goertzel_filter *f = &bank->tone[t];
+            int32_t coeff = f->coeff;
+            int32_t s1 = f->s1;
+            int32_t s2 = f->s2;
+
+            for (int i = 0; i < chunk; i++) {
+                int32_t s0 = (input[i] >> GOERTZEL_IN_SHIFT) + (int32_t)(((int64_t)coeff * s1) >> 14) - s2;
+                s2 = s1;
+                s1 = s0;
+            }
+            f->s1 = s1;
+            f->s2 = s2;
+        }
+
+        input += chunk;
+        len -= chunk;
+        bank->n += chunk;
+
+        if (bank->n >= bank->block_len) {
+            for (int t = 0; t < bank->count; t++)
+                bank->tone[t].level_db = goertzel_level(&bank->tone[t], bank->ref_db);
+            goertzel_bank_reset(bank);
+            bank->blocks++;
+            done++;
+        }
+    }
+
+    return done;
+}
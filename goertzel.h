@@ -0,0 +1,50 @@
+// goertzel.h
+// fixed-point Goertzel filter bank for tone tracking (a few target frequencies only)
+
+#ifndef GOERTZEL_H
+#define GOERTZEL_H
+
+#include <stdint.h>
+
+// Maximum number of tones tracked at the same time
+#define GOERTZEL_MAX_TONES 8
+
+// One Goertzel filter (one target frequency)
+typedef struct {
+    float freq;         // target frequency [Hz]
+    int32_t coeff;      // 2 * cos(2 * pi * k / N) in Q14
+    int32_t s1;         // filter state s[n-1]
+    int32_t s2;         // filter state s[n-2]
+    int16_t level_db;   // last block result [dBFS]
+} goertzel_filter;
+
+// Bank of Goertzel filters sharing the same block length
+typedef struct {
+    goertzel_filter tone[GOERTZEL_MAX_TONES];
+    int count;          // number of active tones
+    int block_len;      // samples per result (N)
+    int n;              // samples consumed in the current block
+    float fs;           // sample rate [Hz]
+    float ref_db;       // dB value of a full scale sine at the bin center
+    uint32_t blocks;    // number of completed blocks
+} goertzel_bank;
+
+// Function to initialize the filter bank
+// bank: bank to initialize
+// freqs: target frequencies [Hz]
+// count: number of frequencies (up to GOERTZEL_MAX_TONES)
+// fs: sample rate of the input stream [Hz]
+// block_len: samples per result, a larger value gives narrower bins but more latency
+void goertzel_bank_init(goertzel_bank *bank, const float *freqs, int count, float fs, int block_len);
+
+// Function to feed Q15 samples into every filter of the bank
+// Can be called with any chunk size, levels are updated each time a block completes
+// input: Q15 samples
+// len: number of samples
+// Returns: number of blocks completed during this call
+int goertzel_bank_process(goertzel_bank *bank, const int16_t *input, int len);
+
+// Function to clear the filter states and start a new block
+void goertzel_bank_reset(goertzel_bank *bank);
+
+#endif // GOERTZEL_H
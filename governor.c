@@ -0,0 +1,70 @@
+// governor.c
+// adaptive frame governor
+// frame period = max(render time, captures * (capture + FFT) time), render runs on core1 in parallel
+
+#include "governor.h"
+
+// moving average weight 1/8, integer only
+#define GOV_EMA_SHIFT 3
+
+static uint32_t ema(uint32_t est, uint32_t sample) {
+    if (est == 0)
+        return sample; // first sample
+    return (uint32_t)((int32_t)est + (((int32_t)sample - (int32_t)est) >> GOV_EMA_SHIFT));
+}
+
+void gov_init(governor *g, int policy, int max_avg) {
+    g->policy = policy;
+    g->max_avg = max_avg < 1 ? 1 : max_avg;
+    g->capture_us = 0;
+    g->dsp_us = 0;
+    g->render_us = 0;
+    g->captures = 1;
+}
+
+void gov_add_dsp(governor *g, uint32_t capture_us, uint32_t dsp_us) {
+    g->capture_us = ema(g->capture_us, capture_us);
+    g->dsp_us = ema(g->dsp_us, dsp_us);
+}
+
+void gov_add_render(governor *g, uint32_t render_us) {
+    g->render_us = ema(g->render_us, render_us);
+}
+
+int gov_plan(governor *g) {
+    uint32_t per_capture = g->capture_us + g->dsp_us;
+    int n = 1;
+
+    // as many captures as fit in the render time of the previous frame
+    if (g->policy == GOV_AVERAGE && per_capture > 0) {
+        n = (int)(g->render_us / per_capture);
+        if (n < 1)
+            n = 1;
+        if (n > g->max_avg)
+            n = g->max_avg;
+    }
+    g->captures = n;
+    return n;
+}
+
+uint32_t gov_start_delay(const governor *g) {
+    uint32_t busy = (uint32_t)g->captures * (g->capture_us + g->dsp_us);
+    if (g->policy != GOV_SKIP || g->render_us <= busy)
+        return 0;
+    return g->render_us - busy;
+}
+
+void gov_get_report(const governor *g, gov_report *r) {
+    uint32_t busy = (uint32_t)g->captures * (g->capture_us + g->dsp_us);
+    uint32_t period = g->render_us > busy ? g->render_us : busy;
+
+    r->frame_us = period;
+    r->captures = g->captures;
+    if (period == 0) {
+        r->fps_x10 = 0;
+        r->headroom_pct = 100;
+        return;
+    }
+    r->fps_x10 = (int)(10000000u / period);
+    r->headroom_pct = (int)(100 - (uint64_t)busy * 100 / period);
+}
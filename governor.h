@@ -0,0 +1,55 @@
+// governor.h
+// adaptive frame governor : plans the captures of each spectrum frame from the measured stage costs
+// Portable, the control logic can be driven with simulated costs on a host
+
+#ifndef GOVERNOR_H
+#define GOVERNOR_H
+
+#include <stdint.h>
+
+// Policy for the captures that do not fit in a display frame
+#define GOV_AVERAGE 0   // fill the render time with captures and average their power spectra
+#define GOV_SKIP 1      // one capture per frame, started just in time, the CPU idles in between
+
+typedef struct {
+    int policy;
+    int max_avg;            // upper limit of captures per frame (GOV_AVERAGE)
+    uint32_t capture_us;    // estimated capture + filter time
+    uint32_t dsp_us;        // estimated FFT time per capture
+    uint32_t render_us;     // estimated core1 render time per frame
+    int captures;           // captures planned for the current frame
+} governor;
+
+// Governor report
+typedef struct {
+    uint32_t frame_us;      // expected display frame period
+    int fps_x10;            // expected display rate x10
+    int captures;           // captures per displayed frame
+    int headroom_pct;       // core0 idle share of the frame period
+} gov_report;
+
+// Function to initialize the governor
+// policy: GOV_AVERAGE or GOV_SKIP
+// max_avg: maximum number of captures averaged into one frame
+void gov_init(governor *g, int policy, int max_avg);
+
+// Function to feed the measured cost of one capture (core0)
+// capture_us: ADC capture + filter time
+// dsp_us: FFT time
+void gov_add_dsp(governor *g, uint32_t capture_us, uint32_t dsp_us);
+
+// Function to feed the measured render time of one frame (core1)
+void gov_add_render(governor *g, uint32_t render_us);
+
+// Function to plan the next frame
+// Returns: number of captures to take for the next frame (1 or more)
+int gov_plan(governor *g);
+
+// Function to get the idle time before the first capture of the planned frame (GOV_SKIP)
+// Returns: micro seconds, 0 when the capture should start at once
+uint32_t gov_start_delay(const governor *g);
+
+// Function to compute the expected frame rate & headroom from the current estimates
+void gov_get_report(const governor *g, gov_report *r);
+
+#endif // GOVERNOR_H
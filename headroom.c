@@ -0,0 +1,85 @@
+// headroom.c
+// saturation & headroom telemetry, BFP shift rule
+// The CMSIS Q15 FFT scales every stage down, so any input within full scale is safe : the shift only has
+// to keep the block peak under full scale, the margin is for the rounding of the window multiply
+
+#include "headroom.h"
+#include <math.h>
+#include <stddef.h>
+
+void hr_reset(hr_telemetry *t) {
+    for (int i = 0; i < HR_STAGES; i++) {
+        t->stage[i].clips = 0;
+        t->stage[i].peak = 0;
+    }
+    t->blocks = 0;
+    t->shift_min = 0;
+    t->shift_max = 0;
+}
+
+void hr_note_shift(hr_telemetry *t, int shift) {
+    if (t->blocks == 0 || shift < t->shift_min)
+        t->shift_min = shift;
+    if (t->blocks == 0 || shift > t->shift_max)
+        t->shift_max = shift;
+    t->blocks++;
+}
+
+void hr_note_adc(hr_telemetry *t, const uint16_t *x, int n) {
+    uint16_t lo0 = HR_ADC_MAX, lo1 = HR_ADC_MAX;
+    uint16_t hi0 = 0, hi1 = 0;
+    uint32_t rails = 0;
+    int i = 0;
+
+    // 2 samples per iteration into 2 independent min / max pairs (as arm_absmax_q15 unrolls)
+    for (; i + 1 < n; i += 2) {
+        uint16_t a = x[i], b = x[i + 1];
+        lo0 = a < lo0 ? a : lo0;
+        hi0 = a > hi0 ? a : hi0;
+        lo1 = b < lo1 ? b : lo1;
+        hi1 = b > hi1 ? b : hi1;
+    }
+    if (i < n) {
+        lo0 = x[i] < lo0 ? x[i] : lo0;
+        hi0 = x[i] > hi0 ? x[i] : hi0;
+    }
+    uint16_t lo = lo0 < lo1 ? lo0 : lo1;
+    uint16_t hi = hi0 > hi1 ? hi0 : hi1;
+    if (lo == 0 || hi >= HR_ADC_MAX) {
+        for (int i = 0; i < n; i++)
+            rails += (uint16_t)(x[i] - 1) >= HR_ADC_MAX - 1; // 0 wraps round to 65535
+    }
+
+    // max |x - 2048|, x8 : Q15 scaling of the filters
+    int32_t peak = hi - 2048 > 2048 - lo ? hi - 2048 : 2048 - lo;
+    hr_note(t, HR_ADC, (uint16_t)((peak < 0 ? 0 : peak) << 3), rails);
+}
+
+uint16_t hr_peak_q15(const int16_t *x, int n, uint32_t *clips) {
+    int32_t peak = 0;
+    uint32_t limits = 0;
+
+    for (int i = 0; i < n; i++) {
+        int32_t a = x[i] < 0 ? -(int32_t)x[i] : x[i];
+        peak = a > peak ? a : peak;
+        limits += a >= 32767;
+    }
+    if (clips != NULL)
+        *clips += limits;
+    return (uint16_t)peak;
+}
+
+int hr_block_shift(uint16_t peak, int margin_bits, int max_shift) {
+    int32_t limit = 32767 >> margin_bits;
+    int shift = 0;
+
+    while (shift < max_shift && ((int32_t)peak << (shift + 1)) <= limit)
+        shift++;
+    return shift;
+}
+
+float hr_peak_dbfs(uint16_t peak) {
+    if (peak == 0)
+        return -99.0f;
+    return 20.0f * log10f(peak / 32768.0f);
+}
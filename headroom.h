@@ -0,0 +1,62 @@
+// headroom.h
+// saturation & headroom telemetry of the Q15 chain, block floating point (BFP) shift of the FFT input
+// Each stage keeps the peak magnitude & the number of clipped samples since the last report
+// Portable, the counters & the shift rule can be checked against a float reference on a host
+
+#ifndef HEADROOM_H
+#define HEADROOM_H
+
+#include <stdint.h>
+
+// Stages of the Q15 chain
+#define HR_ADC 0        // raw ADC samples (x8 = Q15 scaling) : clips = samples on the ADC rails (0 / 4095)
+#define HR_FILTER 1     // decimated IIR output : clips = samples on the Q15 limits
+#define HR_WINDOW 2     // windowed FFT input (after the BFP shift) : clips = saturations of the shift
+#define HR_FFT 3        // arm_rfft_q15 output : clips = values on the Q15 limits
+#define HR_STAGES 4
+
+#define HR_ADC_MAX 4095 // 12bit ADC
+
+typedef struct {
+    uint32_t clips;
+    uint16_t peak;      // max |x| [Q15 LSB], 32768 : full scale
+} hr_stage;
+
+typedef struct {
+    hr_stage stage[HR_STAGES];
+    uint32_t blocks;    // FFT blocks since the last reset
+    int shift_min;      // BFP shifts used
+    int shift_max;
+} hr_telemetry;
+
+// Function to clear the counters (start of a report period)
+void hr_reset(hr_telemetry *t);
+
+// Function to merge the peak & clips of one block into a stage
+static inline void hr_note(hr_telemetry *t, int stage, uint16_t peak, uint32_t clips) {
+    hr_stage *s = &t->stage[stage];
+    s->peak = peak > s->peak ? peak : s->peak;
+    s->clips += clips;
+}
+
+// Function to merge the peak & rail samples of raw 12bit ADC samples into HR_ADC, kept out of the filter loop :
+// one min / max pass, the rail samples are only counted in a block that reaches a rail
+void hr_note_adc(hr_telemetry *t, const uint16_t *x, int n);
+
+// Function to note the BFP shift of one FFT block
+void hr_note_shift(hr_telemetry *t, int shift);
+
+// Function to get the peak magnitude of a Q15 block
+// clips: incremented by the number of samples on the Q15 limits (-32768 / 32767), may be NULL
+// Returns: max |x|
+uint16_t hr_peak_q15(const int16_t *x, int n, uint32_t *clips);
+
+// Function to choose the BFP shift of a block : the largest shift keeping peak << shift under full scale
+// with margin_bits of headroom left
+// Returns: 0 .. max_shift
+int hr_block_shift(uint16_t peak, int margin_bits, int max_shift);
+
+// Function to convert a peak to dB full scale (-inf for 0 is returned as -99)
+float hr_peak_dbfs(uint16_t peak);
+
+#endif // HEADROOM_H
@@ -5,6 +5,7 @@
 #include "pico/stdlib.h"
 #include "hardware/spi.h"
 #include "hardware/gpio.h"
+#include "sram_hot.h"
 #include <math.h>
 #include <stdlib.h>
 #include <stdbool.h>
@@ -29,8 +30,27 @@ static void lcd_write_command(uint8_t cmd);
 static void lcd_write_data(uint8_t data);
 static void lcd_set_window(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2);
 
+// ST7789 delays : reset pulse >= 10us, commands 5ms after reset (120ms when the panel was in sleep out),
+// next command 5ms after sleep out
+#define RESET_WAIT_MS 150
+#define SLEEP_OUT_WAIT_MS 120
+#define FAST_RESET_PULSE_US 20
+#define FAST_RESET_WAIT_MS 120   // a warm reboot leaves the panel in sleep out
+#define FAST_SLEEP_OUT_WAIT_MS 5
+
+static void lcd_init_sequence(bool fast);
+
 // Initialize the LCD
 void lcd_init() {
+    lcd_init_sequence(false);
+}
+
+// Initialize the LCD with the datasheet minimum delays
+void lcd_init_fast() {
+    lcd_init_sequence(true);
+}
+
+static void lcd_init_sequence(bool fast) {
     // Initialize SPI
     spi_init(SPI_PORT, SPI_BAUDRATE);
     spi_set_format(SPI_PORT, 8, SPI_CPOL_1, SPI_CPHA_1, SPI_MSB_FIRST);     // to add this line
@@ -49,16 +69,23 @@ void lcd_init() {
     gpio_set_dir(RST_PIN, GPIO_OUT);
 
      // Perform hardware reset
-    gpio_put(RST_PIN, 1);
-    sleep_ms(5);
-    gpio_put(RST_PIN, 0);
-    sleep_ms(20);
-    gpio_put(RST_PIN, 1);
-    sleep_ms(150);
+    if (fast) {
+        gpio_put(RST_PIN, 0);
+        sleep_us(FAST_RESET_PULSE_US);
+        gpio_put(RST_PIN, 1);
+        sleep_ms(FAST_RESET_WAIT_MS);
+    } else {
+        gpio_put(RST_PIN, 1);
+        sleep_ms(5);
+        gpio_put(RST_PIN, 0);
+        sleep_ms(20);
+        gpio_put(RST_PIN, 1);
+        sleep_ms(RESET_WAIT_MS);
+    }
 
     // Send initialization commands
     lcd_write_command(0x11);  // Sleep out
-    sleep_ms(120);
+    sleep_ms(fast ? FAST_SLEEP_OUT_WAIT_MS : SLEEP_OUT_WAIT_MS);
 
     lcd_write_command(0x36);  // Memory Data Access Control
     lcd_write_data(0xA0);     // display rotation
@@ -135,8 +162,13 @@ void lcd_init() {
     lcd_write_command(0x29);  // Display On
 }
 
+// Re-apply the SPI clock (clk_peri follows clk_sys)
+void lcd_spi_clock_update() {
+    spi_set_baudrate(SPI_PORT, SPI_BAUDRATE);
+}
+
 // Write a command to the LCD
-static void lcd_write_command(uint8_t cmd) {
+static void __core1_func(lcd_write_command)(uint8_t cmd) {
     gpio_put(CS_PIN, 0);
     gpio_put(DC_PIN, 0);
     spi_write_blocking(SPI_PORT, &cmd, 1);
@@ -144,7 +176,7 @@ static void lcd_write_command(uint8_t cmd) {
 }
 
 // Write data to the LCD
-static void lcd_write_data(uint8_t data) {
+static void __core1_func(lcd_write_data)(uint8_t data) {
     gpio_put(CS_PIN, 0);
     gpio_put(DC_PIN, 1);
     spi_write_blocking(SPI_PORT, &data, 1);
@@ -152,7 +184,7 @@ static void lcd_write_data(uint8_t data) {
 }
 
 // Set the active window for drawing
-static void lcd_set_window(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2) {
+static void __core1_func(lcd_set_window)(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2) {
     lcd_write_command(0x2A);
     lcd_write_data(x1 >> 8);
     lcd_write_data(x1 & 0xFF);
@@ -175,14 +207,16 @@ void lcd_fill_color(uint16_t color) {
     gpio_put(CS_PIN, 0);
     gpio_put(DC_PIN, 1);
     
-    uint8_t color_high = color >> 8;
-    uint8_t color_low = color & 0xFF;
-    
-    for (int i = 0; i < WIDTH * HEIGHT; i++) {
-        spi_write_blocking(SPI_PORT, &color_high, 1);
-        spi_write_blocking(SPI_PORT, &color_low, 1);
+    // one row per transfer instead of 2 calls per pixel
+    uint8_t row[WIDTH * 2];
+    for (int i = 0; i < WIDTH; i++) {
+        row[2 * i] = color >> 8;
+        row[2 * i + 1] = color & 0xFF;
     }
     
+    for (int y = 0; y < HEIGHT; y++)
+        spi_write_blocking(SPI_PORT, row, sizeof(row));
+    
     gpio_put(CS_PIN, 1);
 }
 
@@ -192,7 +226,7 @@ uint16_t create_color(uint8_t r, uint8_t g, uint8_t b) {
 }
 
 // Draw a single pixel
-void lcd_draw_pixel(int16_t x, int16_t y, uint16_t color) {
+void __core1_func(lcd_draw_pixel)(int16_t x, int16_t y, uint16_t color) {
     if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT) return;
     lcd_set_window(x, y, x, y);
     lcd_write_data(color >> 8);
@@ -200,7 +234,7 @@ void lcd_draw_pixel(int16_t x, int16_t y, uint16_t color) {
 }
 
 // Draw a line using Bresenham's algorithm
-void lcd_draw_line(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) {
+void __hot_func(lcd_draw_line)(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) {
     int16_t steep = abs(y1 - y0) > abs(x1 - x0);
     if (steep) {
         SWAP(x0, y0);
@@ -239,6 +273,50 @@ void lcd_draw_line(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t colo
     }
 }
 
+// Draw a vertical line : one window & one burst instead of a window per pixel
+void __core1_func(lcd_draw_vline)(int16_t x, int16_t y, int16_t h, uint16_t color) {
+    if (x < 0 || x >= WIDTH) return;
+    if (y < 0) { h += y; y = 0; }
+    if (y + h > HEIGHT) h = HEIGHT - y;
+    if (h <= 0) return;
+
+    uint8_t buf[32 * 2];
+    for (int i = 0; i < 32; i++) {
+        buf[2 * i] = color >> 8;
+        buf[2 * i + 1] = color & 0xFF;
+    }
+    lcd_set_window(x, y, x, y + h - 1);
+    gpio_put(CS_PIN, 0);
+    gpio_put(DC_PIN, 1);
+    for (int16_t n = h; n > 0; n -= 32)
+        spi_write_blocking(SPI_PORT, buf, (n < 32 ? n : 32) * 2);
+    gpio_put(CS_PIN, 1);
+}
+
+// Draw a vertical run of pixels with their own colors
+void __core1_func(lcd_draw_column)(int16_t x, int16_t y, int16_t h, const uint16_t *colors) {
+    if (x < 0 || x >= WIDTH) return;
+    if (y < 0) { colors -= y; h += y; y = 0; }
+    if (y + h > HEIGHT) h = HEIGHT - y;
+    if (h <= 0) return;
+
+    uint8_t buf[32 * 2];
+    lcd_set_window(x, y, x, y + h - 1);
+    gpio_put(CS_PIN, 0);
+    gpio_put(DC_PIN, 1);
+    while (h > 0) {
+        int n = h < 32 ? h : 32;
+        for (int i = 0; i < n; i++) {
+            buf[2 * i] = colors[i] >> 8;
+            buf[2 * i + 1] = colors[i] & 0xFF;
+        }
+        spi_write_blocking(SPI_PORT, buf, n * 2);
+        colors += n;
+        h -= n;
+    }
+    gpio_put(CS_PIN, 1);
+}
+
 // Draw an empty rectangle
 void lcd_draw_rect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
     lcd_draw_line(x, y, x+w-1, y, color);
@@ -318,10 +396,29 @@ void lcd_draw_filled_circle(int16_t x0, int16_t y0, int16_t r, uint16_t color) {
 
 
 // Draw a single character
-void lcd_draw_char(int16_t x, int16_t y, char c, uint16_t color, uint16_t bg, uint8_t size) {
+void __hot_func(lcd_draw_char)(int16_t x, int16_t y, char c, uint16_t color, uint16_t bg, uint8_t size) {
     if ((x >= WIDTH) || (y >= HEIGHT) || ((x + 6 * size - 1) < 0) || ((y + 8 * size - 1) < 0))
         return;
 
+    // opaque 1x text fully on screen : one window & one burst instead of 40 pixel writes
+    if (size == 1 && bg != color && x >= 0 && y >= 0 && x + 4 < WIDTH && y + 7 < HEIGHT) {
+        uint8_t buf[5 * 8 * 2];
+        int n = 0;
+        for (int8_t j = 0; j < 8; j++) {
+            for (int8_t i = 0; i < 5; i++) {
+                uint16_t pixel = (font_5x7[c - 0x20][i] >> j) & 0x01 ? color : bg;
+                buf[n++] = pixel >> 8;
+                buf[n++] = pixel & 0xFF;
+            }
+        }
+        lcd_set_window(x, y, x + 4, y + 7);
+        gpio_put(CS_PIN, 0);
+        gpio_put(DC_PIN, 1);
+        spi_write_blocking(SPI_PORT, buf, sizeof(buf));
+        gpio_put(CS_PIN, 1);
+        return;
+    }
+
     for (int8_t i = 0; i < 5; i++) {
         uint8_t line = font_5x7[c - 0x20][i];
         for (int8_t j = 0; j < 8; j++) {
@@ -342,7 +439,7 @@ void lcd_draw_char(int16_t x, int16_t y, char c, uint16_t color, uint16_t bg, ui
 }
 
 // Draw a string of text
-void lcd_draw_text(int16_t x, int16_t y, char *text, uint16_t color, uint16_t bg, uint8_t size) {
+void __hot_func(lcd_draw_text)(int16_t x, int16_t y, char *text, uint16_t color, uint16_t bg, uint8_t size) {
     int16_t cursor_x = x;
     int16_t cursor_y = y;
     
@@ -0,0 +1,180 @@
+// marker.c
+// peak search & markers with sub-bin frequency interpolation
+
+#include "marker.h"
+#include <math.h>
+#include <string.h>
+
+#define MARKER_TRACK_BINS 2 // a tracked peak may move +-2 bins between frames
+
+void marker_init(marker_state *m, int nbins, float bin_hz, int count, int interp, float min_power) {
+    memset(m, 0, sizeof(*m));
+    m->nbins = nbins;
+    m->bin_hz = bin_hz;
+    m->count = count > MARKER_MAX ? MARKER_MAX : count;
+    m->interp = interp;
+    m->min_power = min_power;
+    m->scan_pos = 1;
+    for (int i = 0; i < MARKER_MAX; i++)
+        m->cand_bin[i] = -1;
+}
+
+static bool is_local_max(const float *p, int k, int nbins) {
+    return k > 0 && k < nbins - 1 && p[k] >= p[k - 1] && p[k] > p[k + 1];
+}
+
+// Hann window amplitude response at an offset of d bins (main lobe)
+static float hann_response(float d) {
+    if (fabsf(d) < 1e-4f)
+        return 1.0f;
+    float x = (float)M_PI * d;
+    return sinf(x) / x / (1.0f - d * d);
+}
+
+// interpolated peak around bin k
+static void refine(const marker_state *m, const float *p, int k, marker_peak *out) {
+    float a = p[k - 1];
+    float b = p[k];
+    float c = p[k + 1];
+    float d = 0.0f;
+
+    if (m->interp == MARKER_INTERP_GAUSSIAN && a > 0.0f && b > 0.0f && c > 0.0f) {
+        float la = logf(a), lb = logf(b), lc = logf(c);
+        float den = la - 2.0f * lb + lc;
+        if (den < 0.0f)
+            d = 0.5f * (la - lc) / den;
+    } else if (m->interp == MARKER_INTERP_HANN && b > 0.0f) {
+        // Grandke : alpha = |X(k+-1)| / |X(k)|, d = (2 alpha - 1) / (alpha + 1)
+        if (c > a) {
+            float alpha = sqrtf(c / b);
+            d = (2.0f * alpha - 1.0f) / (alpha + 1.0f);
+        } else {
+            float alpha = sqrtf(a / b);
+            d = -(2.0f * alpha - 1.0f) / (alpha + 1.0f);
+        }
+    } else {
+        float ma = sqrtf(a), mb = sqrtf(b), mc = sqrtf(c);
+        float den = ma - 2.0f * mb + mc;
+        if (den < 0.0f)
+            d = 0.5f * (ma - mc) / den;
+    }
+    if (d > 0.5f)
+        d = 0.5f;
+    if (d < -0.5f)
+        d = -0.5f;
+
+    float gain = hann_response(d);
+    out->active = true;
+    out->bin = k + d;
+    out->freq = out->bin * m->bin_hz;
+    out->power = b / (gain * gain);
+}
+
+// insert a local maximum into a sorted top N list, same peak (within the track range) is merged
+static void insert_top(int *bins, float *powers, int count, int k, float pw) {
+    for (int i = 0; i < count; i++) {
+        if (bins[i] >= 0 && bins[i] >= k - MARKER_TRACK_BINS && bins[i] <= k + MARKER_TRACK_BINS) {
+            if (pw <= powers[i])
+                return;
+            // remove the weaker duplicate
+            for (int j = i; j < count - 1; j++) {
+                bins[j] = bins[j + 1];
+                powers[j] = powers[j + 1];
+            }
+            bins[count - 1] = -1;
+            break;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        if (bins[i] < 0 || pw > powers[i]) {
+            for (int j = count - 1; j > i; j--) {
+                bins[j] = bins[j - 1];
+                powers[j] = powers[j - 1];
+            }
+            bins[i] = k;
+            powers[i] = pw;
+            return;
+        }
+    }
+}
+
+static void sort_peaks(marker_state *m) {
+    for (int i = 1; i < m->count; i++) {
+        marker_peak key = m->peak[i];
+        float kp = key.active ? key.power : -1.0f;
+        int j = i - 1;
+        while (j >= 0 && (m->peak[j].active ? m->peak[j].power : -1.0f) < kp) {
+            m->peak[j + 1] = m->peak[j];
+            j--;
+        }
+        m->peak[j + 1] = key;
+    }
+}
+
+// strongest local maximum within the track range of center, -1 if none passes min_power
+static int track_max(const marker_state *m, const float *power, int center) {
+    int best = -1;
+    for (int k = center - MARKER_TRACK_BINS; k <= center + MARKER_TRACK_BINS; k++) {
+        if (is_local_max(power, k, m->nbins) && (best < 0 || power[k] > power[best]))
+            best = k;
+    }
+    if (best >= 0 && power[best] < m->min_power)
+        best = -1;
+    return best;
+}
+
+void marker_update(marker_state *m, const float *power, int scan_budget) {
+    // tracking : each known peak follows its local maximum
+    for (int i = 0; i < m->count; i++) {
+        marker_peak *pk = &m->peak[i];
+        if (!pk->active)
+            continue;
+        int best = track_max(m, power, (int)(pk->bin + 0.5f));
+        if (best < 0)
+            pk->active = false;
+        else
+            refine(m, power, best, pk);
+    }
+
+    // background search : a part of the spectrum per call
+    int end = m->scan_pos + scan_budget;
+    if (end > m->nbins - 1)
+        end = m->nbins - 1;
+    for (int k = m->scan_pos; k < end; k++) {
+        if (power[k] >= m->min_power && is_local_max(power, k, m->nbins))
+            insert_top(m->cand_bin, m->cand_power, m->count, k, power[k]);
+    }
+    m->scan_pos = end;
+
+    if (m->scan_pos >= m->nbins - 1) {
+        // search done : the top N of this pass become the markers. A candidate found earlier in the pass
+        // may have moved since, it follows its local maximum like a tracked peak
+        int taken[MARKER_MAX];
+        for (int i = 0; i < m->count; i++) {
+            int k = m->cand_bin[i] >= 0 ? track_max(m, power, m->cand_bin[i]) : -1;
+            for (int j = 0; j < i && k >= 0; j++) {
+                if (taken[j] == k)
+                    k = -1; // two candidates moved onto the same peak
+            }
+            taken[i] = k;
+            if (k >= 0)
+                refine(m, power, k, &m->peak[i]);
+            else
+                m->peak[i].active = false;
+            m->cand_bin[i] = -1;
+        }
+        m->scan_pos = 1;
+    }
+    sort_peaks(m);
+}
+
+bool marker_delta(const marker_state *m, int i, float *dfreq, float *ratio) {
+    const marker_peak *ref = &m->peak[0];
+    const marker_peak *pk = &m->peak[i];
+
+    if (!ref->active || !pk->active || ref->power <= 0.0f)
+        return false;
+    *dfreq = pk->freq - ref->freq;
+    *ratio = pk->power / ref->power;
+    return true;
+}
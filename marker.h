@@ -0,0 +1,57 @@
+// marker.h
+// peak search & markers on the power spectrum with sub-bin frequency interpolation
+// Known peaks are tracked every frame (a few bins each), the full search runs in the background
+// a few bins per frame, so a frame costs far less than a full pass
+
+#ifndef MARKER_H
+#define MARKER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MARKER_MAX 4
+
+// Interpolation of the peak position between bins
+#define MARKER_INTERP_PARABOLIC 0  // parabola on the magnitude
+#define MARKER_INTERP_GAUSSIAN 1   // parabola on the log power (Gaussian main lobe)
+#define MARKER_INTERP_HANN 2       // ratio of the two largest bins, exact for the Hann window main lobe
+
+typedef struct {
+    bool active;
+    float bin;          // interpolated position [bins]
+    float freq;         // interpolated frequency [Hz]
+    float power;        // peak power corrected for the scalloping loss (Hann window)
+} marker_peak;
+
+typedef struct {
+    int nbins;
+    float bin_hz;
+    int count;          // number of markers (top N peaks)
+    int interp;
+    float min_power;    // peaks below this power are ignored
+    int scan_pos;       // background search position
+    int cand_bin[MARKER_MAX];   // best local maxima found by the running search
+    float cand_power[MARKER_MAX];
+    marker_peak peak[MARKER_MAX]; // sorted by power, peak[0] is the delta reference
+} marker_state;
+
+// Function to initialize the markers
+// nbins: number of bins of the power spectrum
+// bin_hz: bin width [Hz]
+// count: number of markers (up to MARKER_MAX)
+// interp: MARKER_INTERP_xxx
+// min_power: smallest power accepted as a peak
+void marker_init(marker_state *m, int nbins, float bin_hz, int count, int interp, float min_power);
+
+// Function to update the markers with a new power spectrum
+// power: linear power spectrum
+// scan_budget: bins of the background search done in this call
+void marker_update(marker_state *m, const float *power, int scan_budget);
+
+// Function to get a marker relative to the reference marker (peak[0])
+// dfreq: frequency difference [Hz]
+// ratio: power ratio (linear)
+// Returns: false if either marker is not active
+bool marker_delta(const marker_state *m, int i, float *dfreq, float *ratio);
+
+#endif // MARKER_H
@@ -0,0 +1,138 @@
+// power.c
+// energy aware frame policy
+// The clock goes one level down when the predicted load at the slower clock still fits the budget,
+// one level up when the load passes load_high_pct. Quiet frames lead to the dormant state
+
+#include "power.h"
+#include <math.h>
+
+void power_init(power_policy *p, const uint32_t *clock_khz, int levels, uint32_t budget_us,
+                uint32_t quiet_rms, uint32_t wake_rms, int quiet_frames) {
+    if (levels > POWER_MAX_LEVELS)
+        levels = POWER_MAX_LEVELS;
+    if (levels < 1)
+        levels = 1;
+
+    for (int i = 0; i < levels; i++)
+        p->clock_khz[i] = clock_khz[i];
+    p->levels = levels;
+    p->level = 0;
+    p->state = POWER_RUN;
+    p->budget_us = budget_us;
+    p->load_high_pct = 80;
+    p->load_low_pct = 50;
+    p->quiet_rms = quiet_rms;
+    p->wake_rms = wake_rms < quiet_rms ? quiet_rms : wake_rms;
+    p->quiet_frames = quiet_frames < 1 ? 1 : quiet_frames;
+    p->quiet_count = 0;
+    p->busy_us = 0;
+    p->idle_us = 0;
+    p->dormant_entries = 0;
+}
+
+static int load_pct(const power_policy *p, uint64_t load_us) {
+    if (p->budget_us == 0)
+        return 100;
+    return (int)(load_us * 100 / p->budget_us);
+}
+
+bool power_frame(power_policy *p, uint32_t load_us, uint32_t rms) {
+    if (p->state != POWER_RUN)
+        return false;
+
+    p->quiet_count = rms < p->quiet_rms ? p->quiet_count + 1 : 0;
+    if (p->quiet_count >= p->quiet_frames) {
+        p->state = POWER_DORMANT;
+        p->level = p->levels - 1;
+        p->quiet_count = 0;
+        p->dormant_entries++;
+        return true;
+    }
+
+    int pct = load_pct(p, load_us);
+    if (pct > p->load_high_pct && p->level > 0) {
+        p->level--;
+        return true;
+    }
+    if (pct < p->load_low_pct && p->level < p->levels - 1) {
+        // the load is assumed to scale with the clock (pessimistic for the ADC bound capture)
+        uint64_t slower = (uint64_t)load_us * p->clock_khz[p->level] / p->clock_khz[p->level + 1];
+        if (load_pct(p, slower) < p->load_high_pct) {
+            p->level++;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool power_probe(power_policy *p, uint32_t rms) {
+    if (p->state != POWER_DORMANT || rms <= p->wake_rms)
+        return false;
+    p->state = POWER_RUN;
+    p->level = 0;
+    return true;
+}
+
+void power_account(power_policy *p, uint32_t busy_us, uint32_t idle_us) {
+    p->busy_us += busy_us;
+    p->idle_us += idle_us;
+}
+
+void power_get_report(power_policy *p, power_report *r) {
+    uint32_t total = p->busy_us + p->idle_us;
+    r->duty_x10 = total == 0 ? 1000 : (int)((uint64_t)p->busy_us * 1000 / total);
+    r->clock_khz = p->clock_khz[p->level];
+    r->state = p->state;
+    r->dormant_entries = p->dormant_entries;
+    p->busy_us = 0;
+    p->idle_us = 0;
+}
+
+uint32_t power_rms_q15(const int16_t *x, int n) {
+    if (n <= 0)
+        return 0;
+
+    int64_t sum = 0;
+    for (int i = 0; i < n; i++)
+        sum += x[i];
+    int32_t mean = (int32_t)(sum / n);
+
+    uint64_t sq = 0;
+    for (int i = 0; i < n; i++) {
+        int32_t d = x[i] - mean;
+        sq += (uint64_t)((int64_t)d * d);
+    }
+    return (uint32_t)sqrtf((float)(sq / (uint64_t)n));
+}
+
+uint32_t power_rms_q31(const int32_t *x, int n) {
+    if (n <= 0)
+        return 0;
+
+    int64_t sum = 0;
+    for (int i = 0; i < n; i++)
+        sum += x[i] >> 16;
+    int32_t mean = (int32_t)(sum / n);
+
+    uint64_t sq = 0;
+    for (int i = 0; i < n; i++) {
+        int32_t d = (x[i] >> 16) - mean;
+        sq += (uint64_t)((int64_t)d * d);
+    }
+    return (uint32_t)sqrtf((float)(sq / (uint64_t)n));
+}
+
+uint32_t power_rms_f32(const float *x, int n) {
+    if (n <= 0)
+        return 0;
+
+    float sum = 0.0f;
+    for (int i = 0; i < n; i++)
+        sum += x[i];
+    float mean = sum / n;
+
+    float sq = 0.0f;
+    for (int i = 0; i < n; i++)
+        sq += (x[i] - mean) * (x[i] - mean);
+    return (uint32_t)(sqrtf(sq / n) * 32768.0f);
+}
@@ -0,0 +1,73 @@
+// power.h
+// energy aware frame policy : clock level from the frame load, dormant (low rate probing) while there is no signal
+// Portable, the policy can be driven with simulated loads & signal levels on a host
+
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define POWER_MAX_LEVELS 4
+
+// Policy state
+#define POWER_RUN 0         // frames at the governed rate
+#define POWER_DORMANT 1     // no signal : one probe capture per poll period, lowest clock
+
+typedef struct {
+    uint32_t clock_khz[POWER_MAX_LEVELS]; // clock levels, fastest first
+    int levels;
+    int level;              // current clock level
+    int state;              // POWER_RUN or POWER_DORMANT
+    uint32_t budget_us;     // frame period target
+    int load_high_pct;      // load above this : next faster level, a slower level must stay below it
+    int load_low_pct;       // load below this : next slower level
+    uint32_t quiet_rms;     // signal RMS below this is "no signal"
+    uint32_t wake_rms;      // signal RMS above this leaves the dormant state (hysteresis)
+    int quiet_frames;       // consecutive quiet frames before dormant
+    int quiet_count;
+    uint32_t busy_us;       // accounted since the last report
+    uint32_t idle_us;
+    uint32_t dormant_entries;
+} power_policy;
+
+// Power report
+typedef struct {
+    int duty_x10;           // busy share of the accounted time, percent x10
+    uint32_t clock_khz;
+    int state;
+    uint32_t dormant_entries;
+} power_report;
+
+// Function to initialize the policy, the clock starts at the fastest level
+// clock_khz: clock levels, fastest first (up to POWER_MAX_LEVELS)
+// budget_us: frame period target, the clock is lowered while the frame load leaves slack in it
+// quiet_rms / wake_rms: dormant enter / leave levels (same unit as the rms passed to power_frame())
+// quiet_frames: consecutive quiet frames before dormant
+void power_init(power_policy *p, const uint32_t *clock_khz, int levels, uint32_t budget_us,
+                uint32_t quiet_rms, uint32_t wake_rms, int quiet_frames);
+
+// Function to feed one displayed frame
+// load_us: longest stage time of the frame at the current clock (core0 DSP or core1 render)
+// rms: signal RMS of the frame
+// Returns: true when the clock level or the state changed
+bool power_frame(power_policy *p, uint32_t load_us, uint32_t rms);
+
+// Function to feed one probe capture of the dormant state
+// Returns: true when the signal is back (POWER_RUN at the fastest level)
+bool power_probe(power_policy *p, uint32_t rms);
+
+// Function to account busy & idle (sleep / WFE) time for the duty cycle
+void power_account(power_policy *p, uint32_t busy_us, uint32_t idle_us);
+
+// Function to get the report, the duty cycle accounting restarts
+void power_get_report(power_policy *p, power_report *r);
+
+// Function to compute the AC RMS of Q15 samples (mean removed)
+uint32_t power_rms_q15(const int16_t *x, int n);
+
+// Same as power_rms_q15() for the Q31 and float32 pipelines, the result is in Q15 units
+uint32_t power_rms_q31(const int32_t *x, int n);
+uint32_t power_rms_f32(const float *x, int n);
+
+#endif // POWER_H
@@ -0,0 +1,93 @@
+// readout.c
+// numeric readout widgets for the LCD with per character dirty caching
+
+#include "readout.h"
+#include "lcd_st7789_library.h"
+
+void readout_init(readout *r, int16_t x, int16_t y, uint8_t width, uint16_t color, uint16_t bg, uint8_t size) {
+    r->x = x;
+    r->y = y;
+    r->width = width > READOUT_MAX_CHARS ? READOUT_MAX_CHARS : width;
+    r->size = size;
+    r->color = color;
+    r->bg = bg;
+    readout_invalidate(r);
+}
+
+void readout_invalidate(readout *r) {
+    // 0x01 is never drawn, every cell differs from it
+    for (int i = 0; i < r->width; i++)
+        r->text[i] = 0x01;
+    r->text[r->width] = '\0';
+}
+
+int readout_set(readout *r, const char *text) {
+    int drawn = 0;
+    int end = 0;
+
+    for (int i = 0; i < r->width; i++) {
+        char c = ' ';
+        if (!end && text[i] != '\0')
+            c = text[i];
+        else
+            end = 1;
+
+        if (c != r->text[i]) {
+            lcd_draw_char(r->x + i * 6 * r->size, r->y, c, r->color, r->bg, r->size);
+            r->text[i] = c;
+            drawn++;
+        }
+    }
+    return drawn;
+}
+
+// digits of an unsigned value
+static int fmt_uint(char *buf, uint32_t v) {
+    char tmp[10];
+    int n = 0;
+    int len = 0;
+
+    do {
+        tmp[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v > 0);
+
+    while (n > 0)
+        buf[len++] = tmp[--n];
+    buf[len] = '\0';
+    return len;
+}
+
+// magnitude of a value, INT32_MIN included
+static uint32_t magnitude(int32_t value) {
+    return value < 0 ? (uint32_t)(-(int64_t)value) : (uint32_t)value;
+}
+
+int fmt_int(char *buf, int32_t value) {
+    int len = 0;
+    if (value < 0)
+        buf[len++] = '-';
+    return len + fmt_uint(buf + len, magnitude(value));
+}
+
+int fmt_fixed(char *buf, int32_t value, int decimals) {
+    uint32_t div = 1;
+    for (int i = 0; i < decimals; i++)
+        div *= 10;
+
+    int len = 0;
+    if (value < 0)
+        buf[len++] = '-';
+    uint32_t v = magnitude(value);
+    len += fmt_uint(buf + len, v / div);
+    if (decimals > 0) {
+        uint32_t frac = v % div;
+        buf[len++] = '.';
+        // leading zeros of the fraction
+        for (uint32_t d = div / 10; d > 0; d /= 10) {
+            buf[len++] = (char)('0' + (frac / d) % 10);
+        }
+        buf[len] = '\0';
+    }
+    return len;
+}
@@ -0,0 +1,45 @@
+// readout.h
+// numeric readout widgets for the LCD
+// The last rendered text is kept per field and only the character cells that changed are redrawn
+
+#ifndef READOUT_H
+#define READOUT_H
+
+#include <stdint.h>
+
+#define READOUT_MAX_CHARS 16
+
+typedef struct {
+    int16_t x, y;       // top-left corner of the field
+    uint8_t width;      // field width in characters (text is padded with spaces)
+    uint8_t size;       // font size multiplier
+    uint16_t color;     // foreground color
+    uint16_t bg;        // background color
+    char text[READOUT_MAX_CHARS + 1]; // text on the screen
+} readout;
+
+// Function to initialize a readout field, nothing is drawn until readout_set()
+// width: field width in characters (up to READOUT_MAX_CHARS)
+void readout_init(readout *r, int16_t x, int16_t y, uint8_t width, uint16_t color, uint16_t bg, uint8_t size);
+
+// Function to update the text of a field
+// Only the character cells different from the text on the screen are drawn
+// Returns: number of cells drawn
+int readout_set(readout *r, const char *text);
+
+// Function to force a full redraw on the next readout_set()
+void readout_invalidate(readout *r);
+
+// Function to format an integer without printf
+// buf: output, NUL terminated
+// value: integer value
+// Returns: number of characters written
+int fmt_int(char *buf, int32_t value);
+
+// Function to format a fixed point value without printf / float
+// value: value x 10^decimals (e.g. 123 with decimals 1 → "12.3"), the whole int32 range
+// decimals: 0 .. 9
+// Returns: number of characters written
+int fmt_fixed(char *buf, int32_t value, int decimals);
+
+#endif // READOUT_H
@@ -0,0 +1,169 @@
+// sched.c
+// three stage block scheduler : acquire -> process (DSP) -> render
+// Queue operations are short critical sections under a spin lock, the stage work runs outside of it
+
+#include "sched.h"
+#include <string.h>
+
+static void sched_lock(sched *s) {
+    while (atomic_flag_test_and_set_explicit(&s->lock, memory_order_acquire))
+        ;
+}
+
+static void sched_unlock(sched *s) {
+    atomic_flag_clear_explicit(&s->lock, memory_order_release);
+}
+
+static void queue_init(sched_queue *q) {
+    q->head = 0;
+    q->tail = 0;
+}
+
+static bool queue_push(sched_queue *q, int block) {
+    int next = (q->tail + 1) % (SCHED_MAX_BLOCKS + 1);
+    if (next == q->head)
+        return false;
+    q->item[q->tail] = (uint8_t)block;
+    q->tail = next;
+    return true;
+}
+
+static int queue_pop(sched_queue *q) {
+    if (q->head == q->tail)
+        return -1;
+    int block = q->item[q->head];
+    q->head = (q->head + 1) % (SCHED_MAX_BLOCKS + 1);
+    return block;
+}
+
+void sched_init(sched *s, const sched_config *cfg) {
+    memset(s, 0, sizeof(*s));
+    s->cfg = *cfg;
+    if (s->cfg.blocks > SCHED_MAX_BLOCKS)
+        s->cfg.blocks = SCHED_MAX_BLOCKS;
+
+    atomic_flag_clear(&s->lock);
+    queue_init(&s->free_q);
+    queue_init(&s->dsp_q);
+    queue_init(&s->render_q);
+    for (int i = 0; i < s->cfg.blocks; i++)
+        queue_push(&s->free_q, i);
+
+    s->dsp_block = -1;
+    s->render_block = -1;
+    s->stats_start = s->cfg.now_us();
+}
+
+int sched_acquire_begin(sched *s) {
+    sched_lock(s);
+    int block = queue_pop(&s->free_q);
+    if (block < 0) {
+        // the caller polls until a block is free : one wait, however many polls
+        if (!s->acquire_blocked)
+            s->stats.acquire_waits++;
+        s->acquire_blocked = true;
+    } else {
+        s->acquire_blocked = false;
+        s->acquire_start[block] = s->cfg.now_us();
+    }
+    sched_unlock(s);
+    return block;
+}
+
+void sched_acquire_end(sched *s, int block) {
+    uint32_t now = s->cfg.now_us();
+    sched_lock(s);
+    s->stats.busy_us[SCHED_STAGE_ACQUIRE] += now - s->acquire_start[block];
+    queue_push(&s->dsp_q, block);
+    sched_unlock(s);
+}
+
+bool sched_dsp_poll(sched *s, int core) {
+    sched_lock(s);
+    // chunks of one block are serialized, the other core may be running one
+    if (s->dsp_running) {
+        sched_unlock(s);
+        return false;
+    }
+    if (s->dsp_block < 0) {
+        s->dsp_block = queue_pop(&s->dsp_q);
+        s->dsp_next = 0;
+        if (s->dsp_block < 0) {
+            sched_unlock(s);
+            return false;
+        }
+    }
+    int block = s->dsp_block;
+    int chunk = s->dsp_next++;
+    s->dsp_running = true;
+    sched_unlock(s);
+
+    uint32_t start = s->cfg.now_us();
+    s->cfg.dsp(s->cfg.ctx, block, chunk);
+    uint32_t time = s->cfg.now_us() - start;
+
+    sched_lock(s);
+    s->stats.busy_us[SCHED_STAGE_DSP] += time;
+    s->stats.core_busy_us[core] += time;
+    s->stats.dsp_chunks[core]++;
+    if (chunk == s->cfg.chunks - 1) {
+        queue_push(&s->render_q, block);
+        s->dsp_block = -1;
+    }
+    s->dsp_running = false;
+    sched_unlock(s);
+    return true;
+}
+
+bool sched_render_poll(sched *s, int core) {
+    sched_lock(s);
+    if (s->render_block < 0) {
+        s->render_block = queue_pop(&s->render_q);
+        s->render_step = 0;
+        if (s->render_block < 0) {
+            sched_unlock(s);
+            return false;
+        }
+    }
+    int block = s->render_block;
+    int step = s->render_step++;
+    sched_unlock(s);
+
+    // single renderer : render_block is not taken by another caller
+    uint32_t start = s->cfg.now_us();
+    bool done = s->cfg.render(s->cfg.ctx, block, step);
+    uint32_t time = s->cfg.now_us() - start;
+
+    sched_lock(s);
+    s->stats.busy_us[SCHED_STAGE_RENDER] += time;
+    s->stats.core_busy_us[core] += time;
+    if (done) {
+        s->stats.frames++;
+        queue_push(&s->free_q, block);
+        s->render_block = -1;
+    }
+    sched_unlock(s);
+    return true;
+}
+
+void sched_get_stats(sched *s, sched_stats *out) {
+    uint32_t now = s->cfg.now_us();
+    sched_lock(s);
+    s->stats.elapsed_us = now - s->stats_start;
+    *out = s->stats;
+    sched_unlock(s);
+}
+
+void sched_stats_reset(sched *s) {
+    uint32_t now = s->cfg.now_us();
+    sched_lock(s);
+    memset(&s->stats, 0, sizeof(s->stats));
+    s->stats_start = now;
+    sched_unlock(s);
+}
+
+int sched_utilisation(const sched_stats *st, int stage) {
+    if (st->elapsed_us == 0)
+        return 0;
+    return (int)((uint64_t)st->busy_us[stage] * 1000 / st->elapsed_us);
+}
@@ -0,0 +1,103 @@
+// sched.h
+// three stage block scheduler : acquire -> process (DSP) -> render
+// Blocks flow through bounded queues, DSP work is split into chunks that either core can run
+// Portable (C11 atomics only), the same code runs on the pico cores or on host threads
+
+#ifndef SCHED_H
+#define SCHED_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#define SCHED_MAX_BLOCKS 8
+#define SCHED_MAX_CORES 2
+
+// Stage indexes for the statistics
+#define SCHED_STAGE_ACQUIRE 0
+#define SCHED_STAGE_DSP 1
+#define SCHED_STAGE_RENDER 2
+#define SCHED_STAGES 3
+
+// Run one DSP chunk of a block (chunks of a block run in order, one at a time)
+typedef void (*sched_dsp_fn)(void *ctx, int block, int chunk);
+
+// Run one render step of a block
+// Returns: true when the block is completely rendered
+typedef bool (*sched_render_fn)(void *ctx, int block, int step);
+
+// Time source in micro seconds (time_us_32 on the pico)
+typedef uint32_t (*sched_time_fn)(void);
+
+typedef struct {
+    int blocks;             // number of blocks in the pool (up to SCHED_MAX_BLOCKS)
+    int chunks;             // DSP chunks per block
+    sched_dsp_fn dsp;
+    sched_render_fn render;
+    sched_time_fn now_us;
+    void *ctx;              // passed to dsp / render
+} sched_config;
+
+// Bounded FIFO of block indexes
+typedef struct {
+    uint8_t item[SCHED_MAX_BLOCKS + 1];
+    int head;
+    int tail;
+} sched_queue;
+
+// Statistics, busy times are accumulated since sched_init() or the last sched_stats_reset()
+typedef struct {
+    uint32_t busy_us[SCHED_STAGES];             // stage busy time
+    uint32_t core_busy_us[SCHED_MAX_CORES];     // DSP + render time per core
+    uint32_t elapsed_us;
+    uint32_t frames;        // rendered blocks
+    uint32_t acquire_waits; // acquisitions that had to wait for a free block (once per wait, not per poll)
+    uint32_t dsp_chunks[SCHED_MAX_CORES]; // chunks run on each core
+} sched_stats;
+
+typedef struct {
+    sched_config cfg;
+    atomic_flag lock;
+    sched_queue free_q;     // empty blocks for the acquisition
+    sched_queue dsp_q;      // captured blocks waiting for DSP
+    sched_queue render_q;   // processed blocks waiting for render
+    int dsp_block;          // block in DSP (-1 : none)
+    int dsp_next;           // next chunk of dsp_block
+    bool dsp_running;       // a chunk of dsp_block is running
+    int render_block;       // block in render (-1 : none)
+    int render_step;
+    bool acquire_blocked;   // the last sched_acquire_begin() found no free block
+    uint32_t acquire_start[SCHED_MAX_BLOCKS];
+    uint32_t stats_start;
+    sched_stats stats;
+} sched;
+
+// Function to initialize the scheduler, every block starts in the free queue
+void sched_init(sched *s, const sched_config *cfg);
+
+// Function to take a free block for the acquisition
+// Returns: block index, -1 when every block is in use (the first -1 of a wait is counted in acquire_waits)
+int sched_acquire_begin(sched *s);
+
+// Function to pass a captured block to the DSP stage
+void sched_acquire_end(sched *s, int block);
+
+// Function to run the next DSP chunk if there is one
+// core: caller core number (0 or 1) for the statistics
+// Returns: true if a chunk was run
+bool sched_dsp_poll(sched *s, int core);
+
+// Function to run the next render step if there is one, the block goes back to the free queue when done
+// Returns: true if a step was run
+bool sched_render_poll(sched *s, int core);
+
+// Function to copy the statistics, elapsed_us is updated to the current time
+void sched_get_stats(sched *s, sched_stats *out);
+
+// Function to clear the statistics
+void sched_stats_reset(sched *s);
+
+// Function to get the utilisation of a stage in percent x10 from a statistics copy
+int sched_utilisation(const sched_stats *st, int stage);
+
+#endif // SCHED_H
@@ -0,0 +1,34 @@
+// hardware/adc.h (dsp_sim) : samples come from the simulated source (WAV file or synthetic)
+
+#ifndef SIM_HARDWARE_ADC_H
+#define SIM_HARDWARE_ADC_H
+
+#include "hardware/address_mapped.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+    volatile uint32_t cs;
+    volatile uint32_t result;
+    volatile uint32_t fcs;
+    volatile uint32_t fifo;
+    volatile uint32_t div;
+} adc_hw_t;
+
+#define ADC_FCS_OVER_BITS 0x00000800u // sticky, write 1 to clear (raised by the sim every DSP_SIM_OVERRUN samples)
+
+extern adc_hw_t *const adc_hw;
+
+void adc_init(void);
+void adc_gpio_init(unsigned int gpio);
+void adc_select_input(unsigned int input);
+void adc_set_clkdiv(float clkdiv);
+void adc_fifo_setup(bool en, bool dreq_en, uint16_t dreq_thresh, bool err_in_fifo, bool byte_shift);
+void adc_run(bool run);
+uint16_t adc_fifo_get_blocking(void);
+void adc_fifo_drain(void);
+static inline bool adc_fifo_is_empty(void) { return false; } // a sample is always ready
+static inline uint16_t adc_fifo_get(void) { return adc_fifo_get_blocking(); }
+static inline void adc_irq_set_enabled(bool enabled) { (void)enabled; }
+
+#endif
@@ -0,0 +1,10 @@
+// hardware/address_mapped.h (dsp_sim) : the atomic set alias, write 1 to clear flags are modelled in sim_hal.c
+
+#ifndef SIM_HARDWARE_ADDRESS_MAPPED_H
+#define SIM_HARDWARE_ADDRESS_MAPPED_H
+
+#include <stdint.h>
+
+void hw_set_bits(volatile uint32_t *addr, uint32_t mask);
+
+#endif
@@ -0,0 +1,20 @@
+// hardware/clocks.h (dsp_sim)
+
+#ifndef SIM_HARDWARE_CLOCKS_H
+#define SIM_HARDWARE_CLOCKS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+enum clock_index { clk_sys = 5 };
+
+extern uint32_t sim_sys_clock_hz; // 150MHz (RP2350 default) until set_sys_clock_khz()
+
+static inline uint32_t clock_get_hz(enum clock_index clk) { (void)clk; return sim_sys_clock_hz; }
+static inline bool set_sys_clock_khz(uint32_t freq_khz, bool required) {
+    (void)required;
+    sim_sys_clock_hz = freq_khz * 1000;
+    return true;
+}
+
+#endif
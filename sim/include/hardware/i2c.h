@@ -0,0 +1,6 @@
+// hardware/i2c.h (dsp_sim) : included by dsp.c, nothing is used
+
+#ifndef SIM_HARDWARE_I2C_H
+#define SIM_HARDWARE_I2C_H
+
+#endif
@@ -0,0 +1,10 @@
+// hardware/irq.h (dsp_sim) : interrupts are not simulated
+
+#ifndef SIM_HARDWARE_IRQ_H
+#define SIM_HARDWARE_IRQ_H
+
+#define ADC_IRQ_FIFO 35
+
+static inline void irq_clear(unsigned int num) { (void)num; }
+
+#endif
@@ -0,0 +1,6 @@
+// hardware/pio.h (dsp_sim) : included by dsp.c, nothing is used
+
+#ifndef SIM_HARDWARE_PIO_H
+#define SIM_HARDWARE_PIO_H
+
+#endif
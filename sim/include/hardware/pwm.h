@@ -0,0 +1,26 @@
+// hardware/pwm.h (dsp_sim) : the PWM output is the synthetic source, only its counter is modelled
+
+#ifndef SIM_HARDWARE_PWM_H
+#define SIM_HARDWARE_PWM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+    uint32_t csr;
+    uint32_t div;
+    uint32_t top;
+} pwm_config;
+
+static inline unsigned int pwm_gpio_to_slice_num(unsigned int gpio) { return (gpio >> 1) & 7; }
+static inline pwm_config pwm_get_default_config(void) { pwm_config c = {0, 16, 0xffff}; return c; }
+static inline void pwm_config_set_clkdiv(pwm_config *c, float div) { c->div = (uint32_t)(div * 16); }
+static inline void pwm_config_set_wrap(pwm_config *c, uint16_t wrap) { c->top = wrap; }
+extern uint32_t sim_pwm_top;
+
+static inline void pwm_init(unsigned int slice, pwm_config *c, bool start) { (void)slice; sim_pwm_top = c->top; (void)start; }
+static inline void pwm_set_wrap(unsigned int slice, uint16_t wrap) { (void)slice; sim_pwm_top = wrap; }
+uint16_t pwm_get_counter(unsigned int slice);
+static inline void pwm_set_gpio_level(unsigned int gpio, uint16_t level) { (void)gpio; (void)level; }
+
+#endif
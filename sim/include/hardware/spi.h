@@ -0,0 +1,24 @@
+// hardware/spi.h (dsp_sim) : spi0 bytes go to the ST7789 model
+
+#ifndef SIM_HARDWARE_SPI_H
+#define SIM_HARDWARE_SPI_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct spi_inst spi_inst_t;
+extern spi_inst_t *const sim_spi0;
+extern spi_inst_t *const sim_spi1;
+#define spi0 sim_spi0
+#define spi1 sim_spi1
+
+typedef enum { SPI_CPOL_0 = 0, SPI_CPOL_1 = 1 } spi_cpol_t;
+typedef enum { SPI_CPHA_0 = 0, SPI_CPHA_1 = 1 } spi_cpha_t;
+typedef enum { SPI_LSB_FIRST = 0, SPI_MSB_FIRST = 1 } spi_order_t;
+
+unsigned int spi_init(spi_inst_t *spi, unsigned int baudrate);
+void spi_set_format(spi_inst_t *spi, unsigned int data_bits, spi_cpol_t cpol, spi_cpha_t cpha, spi_order_t order);
+unsigned int spi_set_baudrate(spi_inst_t *spi, unsigned int baudrate);
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len);
+
+#endif
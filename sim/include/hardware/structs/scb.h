@@ -0,0 +1,17 @@
+// hardware/structs/scb.h (dsp_sim) : only SCR, sleep events are not simulated
+
+#ifndef SIM_HARDWARE_STRUCTS_SCB_H
+#define SIM_HARDWARE_STRUCTS_SCB_H
+
+#include "hardware/address_mapped.h"
+#include <stdint.h>
+
+#define M33_SCR_SEVONPEND_BITS 0x00000010
+
+typedef struct {
+    volatile uint32_t scr;
+} armv8m_scb_hw_t;
+
+extern armv8m_scb_hw_t *const scb_hw;
+
+#endif
@@ -0,0 +1,15 @@
+// hardware/structs/xip_ctrl.h (dsp_sim) : only the cache counters, there is no cache (they stay 0)
+
+#ifndef SIM_HARDWARE_STRUCTS_XIP_CTRL_H
+#define SIM_HARDWARE_STRUCTS_XIP_CTRL_H
+
+#include <stdint.h>
+
+typedef struct {
+    volatile uint32_t ctr_hit;
+    volatile uint32_t ctr_acc;
+} xip_ctrl_hw_t;
+
+extern xip_ctrl_hw_t *const xip_ctrl_hw;
+
+#endif
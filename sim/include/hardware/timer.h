@@ -0,0 +1,6 @@
+// hardware/timer.h (dsp_sim) : included by dsp.c, nothing is used
+
+#ifndef SIM_HARDWARE_TIMER_H
+#define SIM_HARDWARE_TIMER_H
+
+#endif
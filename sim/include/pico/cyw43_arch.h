@@ -0,0 +1,13 @@
+// pico/cyw43_arch.h (dsp_sim) : the on board LED is ignored
+
+#ifndef SIM_PICO_CYW43_ARCH_H
+#define SIM_PICO_CYW43_ARCH_H
+
+#include <stdbool.h>
+
+#define CYW43_WL_GPIO_LED_PIN 0
+
+static inline int cyw43_arch_init(void) { return 0; }
+static inline void cyw43_arch_gpio_put(unsigned int pin, bool value) { (void)pin; (void)value; }
+
+#endif
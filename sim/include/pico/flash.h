@@ -0,0 +1,16 @@
+// pico/flash.h (dsp_sim) : nothing runs from the flash, the function is called directly
+
+#ifndef SIM_PICO_FLASH_H
+#define SIM_PICO_FLASH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef PICO_OK
+#define PICO_OK 0
+#endif
+
+int flash_safe_execute(void (*func)(void *), void *param, uint32_t enter_exit_timeout_ms);
+bool flash_safe_execute_core_init(void);
+
+#endif
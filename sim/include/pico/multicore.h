@@ -0,0 +1,15 @@
+// pico/multicore.h (dsp_sim) : core1 is a thread, the inter-core FIFOs are queues
+
+#ifndef SIM_PICO_MULTICORE_H
+#define SIM_PICO_MULTICORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+void multicore_launch_core1(void (*entry)(void));
+void multicore_fifo_push_blocking(uint32_t data);
+uint32_t multicore_fifo_pop_blocking(void);
+bool multicore_fifo_rvalid(void);
+unsigned int get_core_num(void);
+
+#endif
@@ -0,0 +1,11 @@
+// pico/stdio_usb.h (dsp_sim)
+
+#ifndef SIM_PICO_STDIO_USB_H
+#define SIM_PICO_STDIO_USB_H
+
+#include <stdbool.h>
+
+// stdout is always there
+static inline bool stdio_usb_connected(void) { return true; }
+
+#endif
@@ -0,0 +1,26 @@
+// pico/stdlib.h (dsp_sim)
+// host stand-in for the pico-sdk : only what dsp.c & the LCD library use
+
+#ifndef SIM_PICO_STDLIB_H
+#define SIM_PICO_STDLIB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include "pico/time.h"
+#include "hardware/gpio.h"
+
+typedef unsigned int uint;
+
+#define __not_in_flash_func(func_name) func_name
+#define __time_critical_func(func_name) func_name
+
+#define PICO_ERROR_TIMEOUT -1
+
+bool stdio_init_all(void);
+int getchar_timeout_us(uint32_t timeout_us);
+static inline void tight_loop_contents(void) {}
+
+#endif
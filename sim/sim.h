@@ -0,0 +1,86 @@
+// sim.h
+// dsp_sim internals : configuration, ADC source & ST7789 model
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Simulation settings, read from the environment by sim_init()
+//   DSP_SIM_MODE   : spectrum (default) or osc, level of the SELECT pin
+//   DSP_SIM_WAV    : 16bit PCM WAV file fed to the ADC (looped)
+//   DSP_SIM_TONE   : synthetic tone frequency [Hz] when no WAV is given (default 2343.75 = PWM output)
+//   DSP_SIM_SHAPE  : sine (default) or square
+//   DSP_SIM_LEVEL  : synthetic tone amplitude [ADC LSB] (default 1000)
+//   DSP_SIM_NOISE  : synthetic noise amplitude [ADC LSB] (default 0)
+//   DSP_SIM_FRAMES : frames to run before exit (default 20)
+//   DSP_SIM_OUT    : directory for frame_NNNN.ppm dumps (no dump when unset)
+//   DSP_SIM_PRESS  : button presses "pin@frame,...", the pin reads low once from that frame on
+//   DSP_SIM_FLASH  : file holding the 4MB flash image, loaded at start & saved at exit (recorder)
+//   DSP_SIM_INPUT  : USB input text, ';' ends a line, one line is given per input poll (command shell)
+//   DSP_SIM_OVERRUN: the ADC FIFO overflow flag is raised every N samples (default 0 : never)
+//   DSP_SIM_SECONDS: run time limit [s] (default 0 : none), STAGED core1 draws without frame pops
+#define SIM_MAX_PRESSES 8
+
+typedef struct {
+    bool spectrum;
+    const char *wav;
+    float tone_hz;
+    bool square;
+    int level;
+    int noise;
+    int frames;
+    const char *out_dir;
+    const char *flash_file;
+    const char *input;
+    int overrun;
+    int seconds;
+    struct {
+        int pin;
+        int frame;
+        bool seen;
+    } press[SIM_MAX_PRESSES];
+    int presses;
+} sim_config;
+
+extern sim_config sim_cfg;
+
+// Function to read the settings & open the sources, called once from stdio_init_all()
+void sim_init(void);
+
+// Function to get the ADC sample at a sample index (500ksps)
+uint16_t sim_source_sample(uint64_t n);
+
+// Start phase of the ADC samples [samples], an acquisition starts on a random 48MHz ADC clock edge
+extern double sim_adc_offset;
+
+// Function to open the ADC source
+void sim_source_init(void);
+
+// Function to feed SPI bytes to the ST7789 model
+// dc: level of the Data/Command pin
+void sim_lcd_write(const uint8_t *buf, size_t len, bool dc);
+
+// Per frame counters of the LCD model
+typedef struct {
+    uint32_t spi_bytes;     // bytes written to the LCD
+    uint32_t windows;       // column address set (lcd_set_window) commands
+    uint32_t pixels;        // pixels written
+} sim_lcd_counters;
+
+// Function to take the counters since the last call
+void sim_lcd_take_counters(sim_lcd_counters *c);
+
+// Function to write the frame buffer as a binary PPM file
+bool sim_lcd_dump_ppm(const char *path);
+
+// Frame number being drawn by core1 (-1 : screen setup)
+extern volatile int sim_frame;
+
+// Function called by core1 each time it picks up a frame (multicore_fifo_pop_blocking)
+// Reports the previous frame & stops the simulation after sim_cfg.frames frames
+void sim_frame_begin(void);
+
+#endif // SIM_H
@@ -0,0 +1,516 @@
+// sim_hal.c
+// host implementation of the pico-sdk functions used by dsp.c & the LCD library
+// core1 runs as a thread, the ADC reads the simulated source, spi0 drives the ST7789 model
+
+#include "sim.h"
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+#include "hardware/flash.h"
+#include "pico/flash.h"
+#include "hardware/spi.h"
+#include "hardware/sync.h"
+#include "hardware/clocks.h"
+#include "hardware/structs/scb.h"
+#include "hardware/structs/xip_ctrl.h"
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SIM_SELECT_PIN 3   // SELECT_PIN of dsp.c, high : spectrum analyzer
+#define SIM_DC_PIN 20      // DC_PIN of the LCD library
+#define SIM_CS_PIN 17      // CS_PIN of the LCD library
+#define SIM_GPIO_COUNT 48
+#define SIM_FIFO_DEPTH 4   // same as the SIO FIFO
+#define SIM_DMA_CHANNELS 16
+
+sim_config sim_cfg;
+
+static pthread_once_t init_once = PTHREAD_ONCE_INIT;
+static struct timespec start_time;
+
+static void start_time_limit(void);
+
+// ----------------------------------------------------------------------------
+// settings
+
+static int env_int(const char *name, int def) {
+    const char *v = getenv(name);
+    return v != NULL ? atoi(v) : def;
+}
+
+static void sim_init_once(void) {
+    const char *mode = getenv("DSP_SIM_MODE");
+    const char *shape = getenv("DSP_SIM_SHAPE");
+    const char *tone = getenv("DSP_SIM_TONE");
+
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+
+    sim_cfg.spectrum = mode == NULL || strcmp(mode, "osc") != 0;
+    sim_cfg.wav = getenv("DSP_SIM_WAV");
+    sim_cfg.tone_hz = tone != NULL ? (float)atof(tone) : 2343.75f;
+    sim_cfg.square = shape != NULL && strcmp(shape, "square") == 0;
+    sim_cfg.level = env_int("DSP_SIM_LEVEL", 1000);
+    sim_cfg.noise = env_int("DSP_SIM_NOISE", 0);
+    sim_cfg.frames = env_int("DSP_SIM_FRAMES", 20);
+    sim_cfg.out_dir = getenv("DSP_SIM_OUT");
+    sim_cfg.flash_file = getenv("DSP_SIM_FLASH");
+    sim_cfg.input = getenv("DSP_SIM_INPUT");
+    sim_cfg.overrun = env_int("DSP_SIM_OVERRUN", 0);
+    sim_cfg.seconds = env_int("DSP_SIM_SECONDS", 0);
+
+    // "pin@frame,pin@frame..."
+    const char *press = getenv("DSP_SIM_PRESS");
+    while (press != NULL && sim_cfg.presses < SIM_MAX_PRESSES) {
+        int pin, frame;
+        if (sscanf(press, "%d@%d", &pin, &frame) != 2)
+            break;
+        sim_cfg.press[sim_cfg.presses].pin = pin;
+        sim_cfg.press[sim_cfg.presses].frame = frame;
+        sim_cfg.presses++;
+        press = strchr(press, ',');
+        if (press != NULL)
+            press++;
+    }
+
+    memset(sim_flash, 0xFF, sizeof(sim_flash));
+    if (sim_cfg.flash_file != NULL) {
+        FILE *f = fopen(sim_cfg.flash_file, "rb");
+        if (f != NULL) {
+            if (fread(sim_flash, 1, sizeof(sim_flash), f) == 0)
+                fprintf(stderr, "dsp_sim: %s is empty\n", sim_cfg.flash_file);
+            fclose(f);
+        }
+    }
+
+    sim_source_init();
+    start_time_limit();
+    printf("frame,spi_bytes,windows,pixels,capture_us,dsp_us,render_us\n");
+}
+
+void sim_init(void) {
+    pthread_once(&init_once, sim_init_once);
+}
+
+bool stdio_init_all(void) {
+    sim_init();
+    return true;
+}
+
+// DSP_SIM_INPUT : one line per poll, the poll after a line end sees no input
+int getchar_timeout_us(uint32_t timeout_us) {
+    static bool line_end = false;
+    (void)timeout_us;
+    if (line_end || sim_cfg.input == NULL || *sim_cfg.input == '\0') {
+        line_end = false;
+        return PICO_ERROR_TIMEOUT;
+    }
+    char c = *sim_cfg.input++;
+    if (c == ';') {
+        line_end = true;
+        return '\n';
+    }
+    return c;
+}
+
+// ----------------------------------------------------------------------------
+// time
+
+uint64_t time_us_64(void) {
+    struct timespec now;
+    sim_init(); // the time base starts before the first stdio_init_all()
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)(now.tv_sec - start_time.tv_sec) * 1000000u + (now.tv_nsec - start_time.tv_nsec) / 1000;
+}
+
+uint32_t time_us_32(void) {
+    return (uint32_t)time_us_64();
+}
+
+// sleeps are real : the LCD reset delays & the FAST_BOOT 0 start up delays (core1 waits for the SELECT pin) keep their timing
+void sleep_us(uint64_t us) {
+    usleep((useconds_t)us);
+}
+
+void sleep_ms(uint32_t ms) {
+    sleep_us((uint64_t)ms * 1000);
+}
+
+void __wfi(void) {
+    while (1)
+        pause();
+}
+
+// no event register : waiters poll the condition they wait for
+void __wfe(void) {
+    sched_yield();
+}
+
+void __sev(void) {}
+
+// ----------------------------------------------------------------------------
+// GPIO
+
+static volatile bool gpio_level[SIM_GPIO_COUNT];
+
+void gpio_init(unsigned int gpio) { (void)gpio; }
+void gpio_set_dir(unsigned int gpio, bool out) { (void)gpio; (void)out; }
+
+// an open input with pull up reads high, a button press (DSP_SIM_PRESS) reads low once
+void gpio_pull_up(unsigned int gpio) {
+    if (gpio < SIM_GPIO_COUNT)
+        gpio_level[gpio] = true;
+}
+void gpio_set_function(unsigned int gpio, enum gpio_function fn) { (void)gpio; (void)fn; }
+
+void gpio_put(unsigned int gpio, bool value) {
+    if (gpio < SIM_GPIO_COUNT)
+        gpio_level[gpio] = value;
+}
+
+bool gpio_get(unsigned int gpio) {
+    if (gpio == SIM_SELECT_PIN)
+        return sim_cfg.spectrum;
+    for (int i = 0; i < sim_cfg.presses; i++) {
+        if (sim_cfg.press[i].pin == (int)gpio && !sim_cfg.press[i].seen && sim_frame >= sim_cfg.press[i].frame) {
+            sim_cfg.press[i].seen = true;
+            return false;
+        }
+    }
+    return gpio < SIM_GPIO_COUNT && gpio_level[gpio];
+}
+
+// ----------------------------------------------------------------------------
+// SPI, only spi0 (LCD) is connected
+
+struct spi_inst {
+    int index;
+};
+
+static spi_inst_t spi_inst[2] = {{0}, {1}};
+spi_inst_t *const sim_spi0 = &spi_inst[0];
+spi_inst_t *const sim_spi1 = &spi_inst[1];
+
+unsigned int spi_init(spi_inst_t *spi, unsigned int baudrate) {
+    (void)spi;
+    return baudrate;
+}
+
+unsigned int spi_set_baudrate(spi_inst_t *spi, unsigned int baudrate) {
+    (void)spi;
+    return baudrate;
+}
+
+void spi_set_format(spi_inst_t *spi, unsigned int data_bits, spi_cpol_t cpol, spi_cpha_t cpha, spi_order_t order) {
+    (void)spi; (void)data_bits; (void)cpol; (void)cpha; (void)order;
+}
+
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len) {
+    if (spi == sim_spi0 && !gpio_level[SIM_CS_PIN])
+        sim_lcd_write(src, len, gpio_level[SIM_DC_PIN]);
+    return (int)len;
+}
+
+// ----------------------------------------------------------------------------
+// clocks, SCB & XIP, a clock change only shows in clock_get_hz()
+
+uint32_t sim_sys_clock_hz = 150000000;
+static armv8m_scb_hw_t scb_regs;
+armv8m_scb_hw_t *const scb_hw = &scb_regs;
+static xip_ctrl_hw_t xip_ctrl_regs;
+xip_ctrl_hw_t *const xip_ctrl_hw = &xip_ctrl_regs;
+
+// ----------------------------------------------------------------------------
+// ADC, the sample counter is the simulated time base (500ksps)
+
+
+static adc_hw_t adc_regs;
+adc_hw_t *const adc_hw = &adc_regs;
+static uint64_t adc_sample;
+
+void adc_init(void) {}
+void adc_gpio_init(unsigned int gpio) { (void)gpio; }
+void adc_select_input(unsigned int input) { (void)input; }
+void adc_set_clkdiv(float clkdiv) { (void)clkdiv; }
+void adc_fifo_setup(bool en, bool dreq_en, uint16_t dreq_thresh, bool err_in_fifo, bool byte_shift) {
+    (void)en; (void)dreq_en; (void)dreq_thresh; (void)err_in_fifo; (void)byte_shift;
+}
+// the next acquisition starts on another ADC clock edge (96 per sample)
+void adc_run(bool run) {
+    if (!run)
+        sim_adc_offset = (rand() % 96) / 96.0;
+}
+void adc_fifo_drain(void) {}
+
+// atomic set alias : the write 1 to clear flag of the ADC FIFO status is cleared, other bits are set
+void hw_set_bits(volatile uint32_t *addr, uint32_t mask) {
+    if (addr == &adc_regs.fcs) {
+        *addr &= ~(mask & ADC_FCS_OVER_BITS);
+        mask &= ~ADC_FCS_OVER_BITS;
+    }
+    *addr |= mask;
+}
+
+uint16_t adc_fifo_get_blocking(void) {
+    if (sim_cfg.overrun > 0 && adc_sample % sim_cfg.overrun == 0)
+        adc_regs.fcs |= ADC_FCS_OVER_BITS;
+    return sim_source_sample(adc_sample++);
+}
+
+// PWM, the output is the synthetic tone : the counter follows its phase at the next ADC sample, half a
+// period ahead as the inverting front end is not simulated (the PWM high half reads low on the ADC)
+uint32_t sim_pwm_top = 0xffff;
+
+uint16_t pwm_get_counter(unsigned int slice) {
+    double t = (adc_sample + sim_adc_offset) / 500000.0;
+    (void)slice;
+    return (uint16_t)(fmod(t * sim_cfg.tone_hz + 0.5, 1.0) * (sim_pwm_top + 1));
+}
+
+// ----------------------------------------------------------------------------
+// DMA, an ADC transfer completes as soon as it is triggered
+
+typedef struct {
+    volatile void *write_addr;
+    const volatile void *read_addr;
+    uint32_t count;
+} sim_dma_channel;
+
+static sim_dma_channel dma_ch[SIM_DMA_CHANNELS];
+static int dma_claimed;
+
+static void dma_run(unsigned int channel) {
+    sim_dma_channel *ch = &dma_ch[channel];
+    if (ch->read_addr != &adc_hw->fifo)
+        return;
+    volatile uint16_t *dst = ch->write_addr;
+    for (uint32_t i = 0; i < ch->count; i++)
+        dst[i] = adc_fifo_get_blocking();
+}
+
+int dma_claim_unused_channel(bool required) {
+    if (dma_claimed >= SIM_DMA_CHANNELS) {
+        if (required)
+            abort();
+        return -1;
+    }
+    return dma_claimed++;
+}
+
+dma_channel_config dma_channel_get_default_config(unsigned int channel) {
+    (void)channel;
+    dma_channel_config c = {0};
+    return c;
+}
+
+void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size) { (void)c; (void)size; }
+void channel_config_set_read_increment(dma_channel_config *c, bool incr) { (void)c; (void)incr; }
+void channel_config_set_write_increment(dma_channel_config *c, bool incr) { (void)c; (void)incr; }
+void channel_config_set_dreq(dma_channel_config *c, unsigned int dreq) { (void)c; (void)dreq; }
+
+void dma_channel_configure(unsigned int channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, unsigned int transfer_count, bool trigger) {
+    (void)config;
+    dma_ch[channel].write_addr = write_addr;
+    dma_ch[channel].read_addr = read_addr;
+    dma_ch[channel].count = transfer_count;
+    if (trigger)
+        dma_run(channel);
+}
+
+void dma_channel_set_write_addr(unsigned int channel, volatile void *write_addr, bool trigger) {
+    dma_ch[channel].write_addr = write_addr;
+    if (trigger)
+        dma_run(channel);
+}
+
+void dma_channel_set_trans_count(unsigned int channel, uint32_t trans_count, bool trigger) {
+    dma_ch[channel].count = trans_count;
+    if (trigger)
+        dma_run(channel);
+}
+
+bool dma_channel_is_busy(unsigned int channel) {
+    (void)channel;
+    return false;
+}
+
+// ----------------------------------------------------------------------------
+// flash, erase sets the bytes to 0xFF & program can only clear bits like the real device
+
+uint8_t sim_flash[PICO_FLASH_SIZE_BYTES];
+
+void flash_range_erase(uint32_t flash_offs, size_t count) {
+    if (flash_offs % FLASH_SECTOR_SIZE != 0 || count % FLASH_SECTOR_SIZE != 0 || flash_offs + count > sizeof(sim_flash))
+        abort();
+    memset(sim_flash + flash_offs, 0xFF, count);
+}
+
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count) {
+    if (flash_offs % FLASH_PAGE_SIZE != 0 || count % FLASH_PAGE_SIZE != 0 || flash_offs + count > sizeof(sim_flash))
+        abort();
+    for (size_t i = 0; i < count; i++)
+        sim_flash[flash_offs + i] &= data[i];
+}
+
+int flash_safe_execute(void (*func)(void *), void *param, uint32_t enter_exit_timeout_ms) {
+    (void)enter_exit_timeout_ms;
+    func(param);
+    return PICO_OK;
+}
+
+bool flash_safe_execute_core_init(void) {
+    return true;
+}
+
+static void save_flash(void) {
+    if (sim_cfg.flash_file == NULL)
+        return;
+    FILE *f = fopen(sim_cfg.flash_file, "wb");
+    if (f == NULL || fwrite(sim_flash, 1, sizeof(sim_flash), f) != sizeof(sim_flash))
+        fprintf(stderr, "dsp_sim: cannot write %s\n", sim_cfg.flash_file);
+    if (f != NULL)
+        fclose(f);
+}
+
+// ----------------------------------------------------------------------------
+// multicore, one FIFO per direction
+
+typedef struct {
+    uint32_t item[SIM_FIFO_DEPTH];
+    int head;
+    int count;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} sim_fifo;
+
+static sim_fifo fifo[2] = {
+    {.lock = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER},  // to core0
+    {.lock = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER},  // to core1
+};
+static _Thread_local unsigned int core_num;
+static uint32_t render_start;  // core1 took the current frame
+
+static void *core1_thread(void *arg) {
+    core_num = 1;
+    ((void (*)(void))arg)();
+    return NULL;
+}
+
+void multicore_launch_core1(void (*entry)(void)) {
+    pthread_t thread;
+    pthread_create(&thread, NULL, core1_thread, (void *)entry);
+    pthread_detach(thread);
+}
+
+unsigned int get_core_num(void) {
+    return core_num;
+}
+
+void multicore_fifo_push_blocking(uint32_t data) {
+    sim_fifo *f = &fifo[1 - core_num];
+    pthread_mutex_lock(&f->lock);
+    while (f->count == SIM_FIFO_DEPTH)
+        pthread_cond_wait(&f->cond, &f->lock);
+    f->item[(f->head + f->count) % SIM_FIFO_DEPTH] = data;
+    f->count++;
+    pthread_cond_broadcast(&f->cond);
+    pthread_mutex_unlock(&f->lock);
+}
+
+uint32_t multicore_fifo_pop_blocking(void) {
+    if (core_num == 1)
+        sim_frame_begin();
+
+    sim_fifo *f = &fifo[core_num];
+    pthread_mutex_lock(&f->lock);
+    while (f->count == 0)
+        pthread_cond_wait(&f->cond, &f->lock);
+    uint32_t data = f->item[f->head];
+    f->head = (f->head + 1) % SIM_FIFO_DEPTH;
+    f->count--;
+    pthread_cond_broadcast(&f->cond);
+    pthread_mutex_unlock(&f->lock);
+
+    if (core_num == 1)
+        render_start = time_us_32();
+    return data;
+}
+
+bool multicore_fifo_rvalid(void) {
+    sim_fifo *f = &fifo[core_num];
+    pthread_mutex_lock(&f->lock);
+    bool valid = f->count > 0;
+    pthread_mutex_unlock(&f->lock);
+    return valid;
+}
+
+// ----------------------------------------------------------------------------
+// frame report : core1 asks for a new frame once the previous one is drawn
+
+extern uint32_t start_adc_time;
+extern uint32_t start_preprocess_time;
+extern uint32_t end_fft_time;
+
+volatile int sim_frame = -1; // the first pop follows the screen setup
+
+void sim_frame_begin(void) {
+    int frame = sim_frame;
+    static uint32_t last_capture_us;
+    static uint32_t last_dsp_us;
+    uint32_t now = time_us_32();
+
+    sim_lcd_counters c;
+    sim_lcd_take_counters(&c);
+
+    if (frame >= 0) {
+        // the stage times of core0 may already belong to the next capture, good enough for a trend
+        // core0 may be in the middle of the next capture, keep the last complete FFT time
+        int32_t capture_us = (int32_t)(start_preprocess_time - start_adc_time);
+        int32_t dsp_us = (int32_t)(end_fft_time - start_preprocess_time);
+        if (capture_us >= 0)
+            last_capture_us = (uint32_t)capture_us;
+        if (dsp_us >= 0)
+            last_dsp_us = (uint32_t)dsp_us;
+        printf("%d,%u,%u,%u,%u,%u,%u\n", frame, c.spi_bytes, c.windows, c.pixels,
+               last_capture_us, last_dsp_us, now - render_start);
+        if (sim_cfg.out_dir != NULL) {
+            char path[512];
+            snprintf(path, sizeof(path), "%s/frame_%04d.ppm", sim_cfg.out_dir, frame);
+            if (!sim_lcd_dump_ppm(path))
+                fprintf(stderr, "dsp_sim: cannot write %s\n", path);
+        }
+    }
+
+    sim_frame = ++frame;
+    if (frame >= sim_cfg.frames) {
+        // core0 may hold the stdio lock, exit() would wait for it
+        save_flash();
+        fflush(stdout);
+        _exit(0);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// run time limit : the STAGED loop renders without FIFO pops, sim_frame_begin() never stops it
+
+static void *time_limit_thread(void *arg) {
+    (void)arg;
+    sleep((unsigned int)sim_cfg.seconds);
+    save_flash();
+    fflush(stdout);
+    _exit(0);
+    return NULL;
+}
+
+static void start_time_limit(void) {
+    pthread_t thread;
+    if (sim_cfg.seconds <= 0)
+        return;
+    pthread_create(&thread, NULL, time_limit_thread, NULL);
+    pthread_detach(thread);
+}
@@ -0,0 +1,101 @@
+// sim_lcd.c
+// ST7789 model : decodes the command / data stream into a 320 x 240 RGB565 frame buffer
+
+#include "sim.h"
+#include <stdio.h>
+
+#define SIM_LCD_W 320
+#define SIM_LCD_H 240
+
+static uint16_t fb[SIM_LCD_H][SIM_LCD_W];
+static uint8_t cmd;             // last command
+static int param;               // data bytes received since the command
+static uint16_t x1, x2, y1, y2; // window
+static uint16_t px, py;         // write position
+static uint8_t pixel_hi;
+static sim_lcd_counters counters;
+
+static void set_param(uint16_t *lo, uint16_t *hi, int n, uint8_t data) {
+    switch (n) {
+    case 0: *lo = (uint16_t)(data << 8); break;
+    case 1: *lo |= data; break;
+    case 2: *hi = (uint16_t)(data << 8); break;
+    case 3: *hi |= data; break;
+    default: break;
+    }
+}
+
+static void write_pixel(uint16_t color) {
+    if (px < SIM_LCD_W && py < SIM_LCD_H)
+        fb[py][px] = color;
+    counters.pixels++;
+    if (++px > x2) {
+        px = x1;
+        if (++py > y2)
+            py = y1;
+    }
+}
+
+void sim_lcd_write(const uint8_t *buf, size_t len, bool dc) {
+    counters.spi_bytes += (uint32_t)len;
+
+    for (size_t i = 0; i < len; i++) {
+        uint8_t b = buf[i];
+        if (!dc) {
+            cmd = b;
+            param = 0;
+            if (cmd == 0x2A)
+                counters.windows++;
+            if (cmd == 0x2C) {
+                px = x1;
+                py = y1;
+            }
+            continue;
+        }
+        switch (cmd) {
+        case 0x2A: // column address set
+            set_param(&x1, &x2, param, b);
+            break;
+        case 0x2B: // row address set
+            set_param(&y1, &y2, param, b);
+            break;
+        case 0x2C: // memory write, RGB565 big endian
+            if (param & 1)
+                write_pixel((uint16_t)(pixel_hi << 8 | b));
+            else
+                pixel_hi = b;
+            break;
+        default: // init parameters are not modelled
+            break;
+        }
+        param++;
+    }
+}
+
+void sim_lcd_take_counters(sim_lcd_counters *c) {
+    *c = counters;
+    counters.spi_bytes = 0;
+    counters.windows = 0;
+    counters.pixels = 0;
+}
+
+bool sim_lcd_dump_ppm(const char *path) {
+    FILE *f = fopen(path, "wb");
+    if (f == NULL)
+        return false;
+
+    fprintf(f, "P6\n%d %d\n255\n", SIM_LCD_W, SIM_LCD_H);
+    for (int y = 0; y < SIM_LCD_H; y++) {
+        for (int x = 0; x < SIM_LCD_W; x++) {
+            uint16_t c = fb[y][x];
+            uint8_t rgb[3] = {
+                (uint8_t)((c >> 8) & 0xF8),
+                (uint8_t)((c >> 3) & 0xFC),
+                (uint8_t)((c << 3) & 0xF8),
+            };
+            fwrite(rgb, 1, 3, f);
+        }
+    }
+    fclose(f);
+    return true;
+}
@@ -0,0 +1,104 @@
+// sim_source.c
+// simulated ADC input : looped WAV file or synthetic tone + noise, 12bit, 500ksps
+
+#include "sim.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SIM_ADC_RATE 500000.0
+
+static int16_t *wav_data;
+static uint32_t wav_frames;
+static uint32_t wav_rate;
+
+static uint32_t read_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint16_t read_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+// 16bit PCM only, the first channel is used
+static bool load_wav(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (f == NULL)
+        return false;
+
+    uint8_t hdr[12];
+    uint16_t channels = 0;
+    uint16_t bits = 0;
+    bool ok = false;
+
+    if (fread(hdr, 1, 12, f) != 12 || memcmp(hdr, "RIFF", 4) != 0 || memcmp(hdr + 8, "WAVE", 4) != 0) {
+        fclose(f);
+        return false;
+    }
+
+    uint8_t chunk[8];
+    while (fread(chunk, 1, 8, f) == 8) {
+        uint32_t size = read_u32(chunk + 4);
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            uint8_t fmt[16];
+            if (size < 16 || fread(fmt, 1, 16, f) != 16)
+                break;
+            channels = read_u16(fmt + 2);
+            wav_rate = read_u32(fmt + 4);
+            bits = read_u16(fmt + 14);
+            fseek(f, (long)(size - 16 + (size & 1)), SEEK_CUR);
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            if (bits != 16 || channels == 0)
+                break;
+            int16_t *raw = malloc(size);
+            if (raw == NULL || fread(raw, 1, size, f) != size) {
+                free(raw);
+                break;
+            }
+            wav_frames = size / (2u * channels);
+            wav_data = malloc(wav_frames * sizeof(int16_t));
+            for (uint32_t i = 0; i < wav_frames; i++)
+                wav_data[i] = raw[i * channels];
+            free(raw);
+            ok = wav_frames > 0;
+            break;
+        } else {
+            fseek(f, (long)(size + (size & 1)), SEEK_CUR);
+        }
+    }
+    fclose(f);
+    return ok;
+}
+
+void sim_source_init(void) {
+    if (sim_cfg.wav != NULL && !load_wav(sim_cfg.wav)) {
+        fprintf(stderr, "dsp_sim: cannot read %s (16bit PCM WAV), synthetic tone is used\n", sim_cfg.wav);
+        sim_cfg.wav = NULL;
+    }
+}
+
+double sim_adc_offset;
+
+uint16_t sim_source_sample(uint64_t n) {
+    double t = (n + sim_adc_offset) / SIM_ADC_RATE;
+    int32_t v;
+
+    if (wav_data != NULL) {
+        uint32_t i = (uint32_t)((uint64_t)(t * wav_rate) % wav_frames);
+        v = 2048 + (wav_data[i] >> 4);
+    } else {
+        double s = sin(2.0 * M_PI * sim_cfg.tone_hz * t);
+        if (sim_cfg.square)
+            s = s >= 0.0 ? 1.0 : -1.0;
+        v = 2048 + (int32_t)lrint(sim_cfg.level * s);
+        if (sim_cfg.noise > 0)
+            v += rand() % (2 * sim_cfg.noise + 1) - sim_cfg.noise;
+    }
+
+    if (v < 0)
+        v = 0;
+    if (v > 4095)
+        v = 4095;
+    return (uint16_t)v;
+}
@@ -0,0 +1,99 @@
+// bench_goertzel.c
+// Goertzel bank (TONE_TRACK) against the spectrum path it replaces, both on the same filtered capture of dsp.c :
+// fft_exec() on the Q15 pipeline (Hann window, arm_rfft_q15, arm_cmplx_mag_squared_q15) + fft_publish() (dB),
+// against goertzel_bank_process() for 1 .. GOERTZEL_MAX_TONES tones. The harmonic levels of both are checked
+// against each other (differences to the fundamental, the references of the two dB scales are not the same).
+// Linked against dsp.c (its main renamed) & the sim HAL, the times are host times
+
+#undef main // dsp.c is built with main=dsp_main
+#include "arm_math.h"
+#include "goertzel.h"
+#include "test.h"
+#include <stdlib.h>
+
+#define RAW_SAMPLES 5120 // dsp.c
+#define DOWNSAMPLED 512
+#define FS 50000.0f      // ADC_RATE / DECIMATE_N
+#define BIN_HZ (FS / DOWNSAMPLED)
+#define FUNDAMENTAL 2343.75f // PWM output, bin 24
+#define HARMONICS 3
+#define BENCH_NS 2e8
+
+enum { PIPE_Q15, PIPE_Q31, PIPE_F32, PIPE_COUNT };
+
+extern q15_t filtered_downsampled[DOWNSAMPLED];
+extern float fft_power[DOWNSAMPLED / 2];
+extern volatile int fft_pipeline;
+void filter_and_downsample(const uint16_t *src);
+void fft_setup(void);
+void fft_exec(void);
+void fft_publish(void);
+
+static uint16_t raw[RAW_SAMPLES];
+static goertzel_bank bank;
+
+// Returns: time per call [ns]
+static double time_ns(void (*fn)(void)) {
+    int reps = 0;
+    double t0 = test_now_ns(), t1;
+    do {
+        fn();
+        reps++;
+    } while ((t1 = test_now_ns()) - t0 < BENCH_NS / 4);
+    return (t1 - t0) / reps;
+}
+
+static void spectrum(void) {
+    fft_exec();
+    fft_publish();
+}
+
+static void tones(void) {
+    goertzel_bank_process(&bank, filtered_downsampled, DOWNSAMPLED);
+}
+
+int main(void) {
+    // square wave partials 1, 3, 5 (1/k) + noise, 12bit
+    srand(3);
+    for (int i = 0; i < RAW_SAMPLES; i++) {
+        double v = 0.0;
+        for (int h = 0; h < HARMONICS; h++)
+            v += 1200.0 / (2 * h + 1) * sin(2.0 * M_PI * FUNDAMENTAL * (2 * h + 1) * i / 500000.0);
+        raw[i] = (uint16_t)(2048 + lrint(v) + rand() % 9 - 4);
+    }
+    fft_pipeline = PIPE_Q15;
+    filter_and_downsample(raw);
+    fft_setup();
+
+    // levels : the harmonics under the fundamental, FFT bin against Goertzel tone
+    float freq[GOERTZEL_MAX_TONES];
+    for (int t = 0; t < GOERTZEL_MAX_TONES; t++)
+        freq[t] = FUNDAMENTAL * (2 * t + 1) < FS / 2 ? FUNDAMENTAL * (2 * t + 1) : 1000.0f * t;
+    spectrum();
+    goertzel_bank_init(&bank, freq, HARMONICS, FS, DOWNSAMPLED);
+    CHECK(goertzel_bank_process(&bank, filtered_downsampled, DOWNSAMPLED) == 1);
+    int peak = 1;
+    for (int k = 1; k < DOWNSAMPLED / 2; k++)
+        peak = fft_power[k] > fft_power[peak] ? k : peak;
+    CHECK(peak == (int)lrintf(FUNDAMENTAL / BIN_HZ));
+    double fft_fund_db = 10.0 * log10(fft_power[peak]);
+    for (int h = 1; h < HARMONICS; h++) {
+        int bin = (int)lrintf(freq[h] / BIN_HZ);
+        double fft_db = 10.0 * log10(fft_power[bin]) - fft_fund_db;
+        double g_db = bank.tone[h].level_db - bank.tone[0].level_db;
+        printf("harmonic %d (%.0f Hz) : fft %.1f dB, goertzel %.1f dB under the fundamental\n", 2 * h + 1,
+               freq[h], fft_db, g_db);
+        CHECK_NEAR(g_db, fft_db, 1.5); // level_db is truncated to whole dB
+    }
+
+    // cost : one spectrum frame of dsp.c against N tones
+    double fft_ns = time_ns(spectrum);
+    printf("fft_exec q15 + fft_publish : %.0f ns / block (%.0f ns / sample)\n", fft_ns, fft_ns / DOWNSAMPLED);
+    for (int count = 1; count <= GOERTZEL_MAX_TONES; count++) {
+        goertzel_bank_init(&bank, freq, count, FS, DOWNSAMPLED);
+        double g_ns = time_ns(tones);
+        printf("goertzel %d tones : %.0f ns / block (%.3f x fft_exec)\n", count, g_ns, g_ns / fft_ns);
+    }
+
+    return test_result("goertzel_fft");
+}
@@ -0,0 +1,134 @@
+// bench_pipeline.c
+// time per frame against noise floor of the Q15 / Q31 / F32 pipelines of dsp.c : filter_and_downsample() of a
+// raw capture, then fft_exec() (window, RFFT, mag_squared, power scaling) + fft_publish() on a 12bit quantised
+// sine written to the filter output of the pipeline. The times are host times of the CMSIS-DSP build in
+// CMSISDSP_PATH, the on-target table comes from "set pipeline N" + "stats" (fft_exec line).
+// Linked against dsp.c (its main renamed) & the sim HAL
+
+#undef main // dsp.c is built with main=dsp_main
+#include "arm_math.h"
+#include "test.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RAW_SAMPLES 5120 // dsp.c
+#define DECIMATE_N 10
+#define N 512
+#define NBINS (N / 2)
+#define TONE_BIN 20.3 // off bin : the quantisation error is spread as noise
+#define EXCLUDE 8     // bins around DC & the tone left out of the noise floor
+#define BENCH_NS 2e8  // time spent per stage & pipeline (the reference DFT of a stand-in CMSIS-DSP is slow)
+
+enum { PIPE_Q15, PIPE_Q31, PIPE_F32, PIPE_COUNT };
+static const char *pipe_name[PIPE_COUNT] = {"q15", "q31", "f32"};
+
+extern q15_t filtered_downsampled[N];
+extern q31_t filtered_downsampled_q31[N];
+extern float32_t filtered_downsampled_f32[N];
+extern float fft_power[NBINS];
+extern volatile int fft_pipeline;
+void filter_begin(void);
+void filter_and_downsample(const uint16_t *src);
+void fft_setup(void);
+void fft_exec(void);
+void fft_publish(void);
+
+static q15_t in_q15[N];
+static q31_t in_q31[N];
+static float32_t in_f32[N];
+static uint16_t raw[RAW_SAMPLES];
+
+// Returns: time per call [ns]
+static double time_ns(void (*fn)(void)) {
+    int reps = 0;
+    double t0 = test_now_ns(), t1;
+    do {
+        fn();
+        reps++;
+    } while ((t1 = test_now_ns()) - t0 < BENCH_NS);
+    return (t1 - t0) / reps;
+}
+
+static void filter(void) {
+    filter_and_downsample(raw);
+}
+
+// the test block replaces the filter output of the pipeline latched by filter_begin()
+static void load_block(int pipe) {
+    fft_pipeline = pipe;
+    filter_begin();
+    if (pipe == PIPE_Q15)
+        memcpy(filtered_downsampled, in_q15, sizeof(in_q15));
+    else if (pipe == PIPE_Q31)
+        memcpy(filtered_downsampled_q31, in_q31, sizeof(in_q31));
+    else
+        memcpy(filtered_downsampled_f32, in_f32, sizeof(in_f32));
+}
+
+static double db(double p) {
+    return p > 0.0 ? 10.0 * log10(p) : -200.0;
+}
+
+static int cmp_float(const void *a, const void *b) {
+    float x = *(const float *)a, y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+int main(void) {
+    double win_sum2 = 0.0; // Hann window of fft_setup()
+    for (int n = 0; n < N; n++) {
+        double w = 0.5 * (1.0 - cos(2.0 * M_PI * n / (N - 1)));
+        win_sum2 += w * w;
+    }
+    fft_setup();
+
+    // -6dBFS sine in 12bit ADC LSB, scaled as the filters of dsp.c (Q15 : << 3, Q31 : << 19, F32 : / 4096)
+    for (int n = 0; n < N; n++) {
+        int32_t v = (int32_t)lrint(1024.0 * sin(2.0 * M_PI * TONE_BIN * n / N));
+        in_q15[n] = (q15_t)(v << 3);
+        in_q31[n] = v << 19;
+        in_f32[n] = (float)v / 4096.0f;
+    }
+    // quantisation noise of the 12bit input per bin : (LSB^2 / 12) * sum(w^2) / N^2, LSB = 1 / 4096.
+    // The floor is the median noise bin (the window leakage of the tone does not move it), the median of
+    // the power of a noise bin is ln(2) of its mean
+    double floor_ideal = db(1.0 / (4096.0 * 4096.0 * 12.0) * win_sum2 / ((double)N * N) * log(2.0));
+    int tone = (int)lrint(TONE_BIN);
+
+    // raw capture for the filter timing : the same tone at the ADC rate, 12bit around mid scale
+    for (int i = 0; i < RAW_SAMPLES; i++)
+        raw[i] = (uint16_t)(2048 + lrint(1024.0 * sin(2.0 * M_PI * TONE_BIN * i / (N * DECIMATE_N))));
+
+    double tone_db[PIPE_COUNT];
+    for (int pipe = 0; pipe < PIPE_COUNT; pipe++) {
+        fft_pipeline = pipe;
+        double filter_ns = time_ns(filter);
+        load_block(pipe);
+        double ns = time_ns(fft_exec);
+        fft_publish(); // the average of identical blocks
+
+        float noise[NBINS];
+        int bins = 0, zero = 0;
+        for (int k = EXCLUDE; k < NBINS; k++) {
+            if (abs(k - tone) <= EXCLUDE)
+                continue;
+            noise[bins++] = fft_power[k];
+            zero += fft_power[k] == 0.0f;
+        }
+        qsort(noise, bins, sizeof(noise[0]), cmp_float);
+        double floor_db = db(noise[bins / 2]);
+        tone_db[pipe] = db(fft_power[tone]);
+        printf("%s : filter %8.0f ns, fft_exec %8.0f ns / frame, tone %6.1f dB, noise floor %6.1f dB / bin "
+               "(ideal %.1f), %d of %d bins 0\n",
+               pipe_name[pipe], filter_ns, ns, tone_db[pipe], floor_db, floor_ideal, zero, bins);
+        if (pipe == PIPE_F32)
+            CHECK_NEAR(floor_db, floor_ideal, 2.0);
+    }
+
+    // the power scaling of the three pipelines agrees (the F32 1 / N^2)
+    CHECK_NEAR(tone_db[PIPE_Q31], tone_db[PIPE_F32], 0.5);
+    CHECK_NEAR(tone_db[PIPE_Q15], tone_db[PIPE_F32], 0.5);
+
+    return test_result("pipeline");
+}
@@ -0,0 +1,104 @@
+// bench_stream.c
+// streamed capture filter of dsp.c (filter_begin + filter_chunk per STREAM_CHUNK samples, adc_capture_filtered)
+// against the whole block filter_and_downsample() of a raw capture : outputs of the three pipelines bit exact,
+// RAM of the raw block, and the filter work left after the last ADC sample. The per chunk cost is also the
+// margin against the ADC FIFO : a chunk has to be filtered before the next one overflows the FIFO.
+// Linked against dsp.c (its main renamed) & the sim HAL, the times are host times
+
+#undef main // dsp.c is built with main=dsp_main
+#include "arm_math.h"
+#include "test.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define RAW_SAMPLES 5120 // dsp.c
+#define DOWNSAMPLED 512
+#define STREAM_CHUNK 8
+#define SAMPLE_NS 2000.0 // 500ksps
+#define BENCH_NS 2e8
+
+enum { PIPE_Q15, PIPE_Q31, PIPE_F32, PIPE_COUNT };
+static const char *pipe_name[PIPE_COUNT] = {"q15", "q31", "f32"};
+
+extern q15_t filtered_downsampled[DOWNSAMPLED];
+extern q31_t filtered_downsampled_q31[DOWNSAMPLED];
+extern float32_t filtered_downsampled_f32[DOWNSAMPLED];
+extern volatile int fft_pipeline;
+void filter_begin(void);
+void filter_chunk(const uint16_t *src, int n);
+void filter_and_downsample(const uint16_t *src);
+
+static uint16_t raw[RAW_SAMPLES];
+
+// copy of the output of the current pipeline
+static void take_output(int pipe, void *dst) {
+    if (pipe == PIPE_Q31)
+        memcpy(dst, filtered_downsampled_q31, sizeof(filtered_downsampled_q31));
+    else if (pipe == PIPE_F32)
+        memcpy(dst, filtered_downsampled_f32, sizeof(filtered_downsampled_f32));
+    else
+        memcpy(dst, filtered_downsampled, sizeof(filtered_downsampled));
+}
+
+static void stream(int chunk) {
+    filter_begin();
+    for (int i = 0; i < RAW_SAMPLES; i += chunk)
+        filter_chunk(raw + i, RAW_SAMPLES - i < chunk ? RAW_SAMPLES - i : chunk);
+}
+
+// Returns: time per call [ns]
+static double time_ns(void (*fn)(int), int arg) {
+    int reps = 0;
+    double t0 = test_now_ns(), t1;
+    do {
+        fn(arg);
+        reps++;
+    } while ((t1 = test_now_ns()) - t0 < BENCH_NS / 4);
+    return (t1 - t0) / reps;
+}
+
+static void whole(int unused) {
+    (void)unused;
+    filter_and_downsample(raw);
+}
+
+static void one_chunk(int unused) {
+    (void)unused;
+    filter_chunk(raw, STREAM_CHUNK);
+}
+
+int main(void) {
+    static float32_t block[DOWNSAMPLED], streamed[DOWNSAMPLED]; // largest output type
+
+    // 3.1KHz tone + noise, 12bit
+    srand(5);
+    for (int i = 0; i < RAW_SAMPLES; i++)
+        raw[i] = (uint16_t)(2048 + lrint(1500.0 * sin(2.0 * M_PI * 3100.0 * i / 500000.0)) + rand() % 33 - 16);
+
+    printf("RAM : raw block %d bytes, streamed chunk %d bytes (stack)\n", (int)sizeof(raw),
+           STREAM_CHUNK * (int)sizeof(raw[0]));
+    for (int pipe = 0; pipe < PIPE_COUNT; pipe++) {
+        fft_pipeline = pipe;
+        filter_and_downsample(raw);
+        take_output(pipe, block);
+        // STREAM_CHUNK & chunks that do not divide the decimation (state carried across chunks)
+        int chunks[] = {STREAM_CHUNK, 7, 1, 64};
+        for (unsigned c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+            memset(streamed, 0, sizeof(streamed));
+            stream(chunks[c]);
+            take_output(pipe, streamed);
+            CHECK(memcmp(block, streamed, sizeof(block)) == 0);
+        }
+
+        filter_begin();
+        double block_ns = time_ns(whole, 0);
+        double chunk_ns = time_ns(one_chunk, 0);
+        printf("%s : whole block %7.0f ns after the last sample, streamed %5.1f ns (one chunk, %.1f%% of its "
+               "%.0f ns of ADC time)\n",
+               pipe_name[pipe], block_ns, chunk_ns, 100.0 * chunk_ns / (STREAM_CHUNK * SAMPLE_NS),
+               STREAM_CHUNK * SAMPLE_NS);
+        CHECK(chunk_ns * 100 < block_ns);
+    }
+
+    return test_result("stream");
+}
@@ -0,0 +1,53 @@
+// frame_peak.c
+// dsp_sim check : the highest bar of a spectrum frame dump must be at the expected column
+// frame_peak <frame.ppm> <x0> <x1> <expected x> <tolerance>, exit code 0 : the peak is in range
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define GRAPH_TOP 20     // 0dB line (ver_offset)
+#define GRAPH_BOTTOM 220 // -100dB line
+
+int main(int argc, char **argv) {
+    if (argc != 6) {
+        fprintf(stderr, "usage : frame_peak frame.ppm x0 x1 expected_x tolerance\n");
+        return 2;
+    }
+    int x0 = atoi(argv[2]);
+    int x1 = atoi(argv[3]);
+    int expect = atoi(argv[4]);
+    int tol = atoi(argv[5]);
+
+    FILE *f = fopen(argv[1], "rb");
+    int w, h, max;
+    if (f == NULL || fscanf(f, "P6 %d %d %d", &w, &h, &max) != 3 || fgetc(f) == EOF) {
+        fprintf(stderr, "frame_peak : cannot read %s\n", argv[1]);
+        return 2;
+    }
+    unsigned char *rgb = malloc((size_t)w * h * 3);
+    if (rgb == NULL || fread(rgb, 3, (size_t)w * h, f) != (size_t)w * h) {
+        fprintf(stderr, "frame_peak : %s is truncated\n", argv[1]);
+        return 2;
+    }
+    fclose(f);
+
+    // bars are white (COLOR_FG), the reference lines blue : the top white pixel of each column
+    int peak_x = -1;
+    int peak_y = GRAPH_BOTTOM;
+    for (int x = x0; x < x1 && x < w; x++) {
+        for (int y = GRAPH_TOP; y < GRAPH_BOTTOM && y < h; y++) {
+            const unsigned char *p = &rgb[(y * w + x) * 3];
+            if (p[0] > 200 && p[1] > 200 && p[2] > 200) {
+                if (y < peak_y) {
+                    peak_y = y;
+                    peak_x = x;
+                }
+                break;
+            }
+        }
+    }
+    free(rgb);
+
+    printf("frame_peak : highest bar at x %d (y %d), expected %d +- %d\n", peak_x, peak_y, expect, tol);
+    return peak_x >= expect - tol && peak_x <= expect + tol ? 0 : 1;
+}
@@ -0,0 +1,127 @@
+// osc_check.c
+// dsp_sim check of the oscilloscope trace : runs a vector (OSC_VECTOR 1) and a dot (OSC_VECTOR 0) build in osc
+// mode on a sine, a rail to rail square and noise, prints their per frame LCD counters and checks the vector
+// trace costs fewer set windows & SPI bytes. The square frames of the vector build are dumped and checked for
+// stray reference line pixels under the grid (erase_osc_span once restored y = 200, screen row 220)
+// osc_check <dsp_sim vector> <dsp_sim dot> <dump dir>, exit code 0 : pass
+
+#include "test.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FRAMES 8
+#define FIRST_FRAME 2    // frames 0 & 1 draw the screen format
+#define GRID_BOTTOM 180  // last reference line, ver_offset + (GRID_LINES - 1) * GRID_STEP
+#define STRAY_ROW 220    // ver_offset + GRID_LINES * GRID_STEP
+
+typedef struct {
+    const char *name;
+    const char *shape;
+    const char *level;
+    const char *noise;
+} signal;
+
+static const signal signals[] = {
+    {"sine", "sine", "1000", "0"},
+    {"square", "square", "2100", "0"}, // clipped on both rails : the trace reaches the bottom row
+    {"noise", "sine", "0", "1000"},
+};
+
+typedef struct {
+    unsigned long spi_bytes, windows, pixels;
+} totals;
+
+// Function to run dsp_sim & sum the LCD counters of the trace frames
+// Returns: false if the run failed
+static bool run(const char *sim, const char *mode, const signal *s, const char *out_dir, totals *t) {
+    char frames[8];
+    snprintf(frames, sizeof(frames), "%d", FRAMES);
+    setenv("DSP_SIM_MODE", "osc", 1);
+    setenv("DSP_SIM_TONE", "1000", 1);
+    setenv("DSP_SIM_SHAPE", s->shape, 1);
+    setenv("DSP_SIM_LEVEL", s->level, 1);
+    setenv("DSP_SIM_NOISE", s->noise, 1);
+    setenv("DSP_SIM_FRAMES", frames, 1);
+    if (out_dir != NULL)
+        setenv("DSP_SIM_OUT", out_dir, 1);
+    else
+        unsetenv("DSP_SIM_OUT");
+
+    FILE *p = popen(sim, "r");
+    if (p == NULL)
+        return false;
+    char line[256];
+    int frame_count = 0;
+    memset(t, 0, sizeof(*t));
+    while (fgets(line, sizeof(line), p) != NULL) {
+        int frame;
+        unsigned long bytes, windows, pixels;
+        if (sscanf(line, "%d,%lu,%lu,%lu,", &frame, &bytes, &windows, &pixels) != 4 || frame < FIRST_FRAME)
+            continue;
+        printf("%-6s %-6s frame %d : spi_bytes %5lu windows %4lu pixels %5lu\n", s->name, mode, frame, bytes, windows,
+               pixels);
+        t->spi_bytes += bytes;
+        t->windows += windows;
+        t->pixels += pixels;
+        frame_count++;
+    }
+    return pclose(p) == 0 && frame_count == FRAMES - FIRST_FRAME;
+}
+
+// Function to count the reference line (blue) pixels of a screen row in a frame dump
+// Returns: pixel count, -1 if the dump cannot be read
+static int blue_pixels(const char *path, int row) {
+    FILE *f = fopen(path, "rb");
+    int w, h, max;
+    if (f == NULL || fscanf(f, "P6 %d %d %d", &w, &h, &max) != 3 || fgetc(f) == EOF || row >= h) {
+        if (f != NULL)
+            fclose(f);
+        return -1;
+    }
+    unsigned char *rgb = malloc((size_t)w * 3);
+    int count = -1;
+    if (rgb != NULL && fseek(f, (long)row * w * 3, SEEK_CUR) == 0 && fread(rgb, 3, (size_t)w, f) == (size_t)w) {
+        count = 0;
+        for (int x = 0; x < w; x++)
+            count += rgb[x * 3] < 50 && rgb[x * 3 + 1] < 50 && rgb[x * 3 + 2] > 200;
+    }
+    free(rgb);
+    fclose(f);
+    return count;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 4) {
+        fprintf(stderr, "usage : osc_check dsp_sim_vector dsp_sim_dot dump_dir\n");
+        return 2;
+    }
+
+    for (unsigned i = 0; i < sizeof(signals) / sizeof(signals[0]); i++) {
+        const signal *s = &signals[i];
+        bool square = strcmp(s->shape, "square") == 0;
+        totals vec, dot;
+        CHECK(run(argv[1], "vector", s, square ? argv[3] : NULL, &vec));
+        CHECK(run(argv[2], "dot", s, NULL, &dot));
+        printf("%-6s : vector %lu bytes %lu windows, dot %lu bytes %lu windows over %d frames\n", s->name,
+               vec.spi_bytes, vec.windows, dot.spi_bytes, dot.windows, FRAMES - FIRST_FRAME);
+        CHECK(vec.windows < dot.windows);
+        CHECK(vec.spi_bytes < dot.spi_bytes);
+
+        if (square) {
+            // the reference lines stay whole & nothing is restored under them
+            for (int frame = FIRST_FRAME; frame < FRAMES; frame++) {
+                char path[512];
+                snprintf(path, sizeof(path), "%s/frame_%04d.ppm", argv[3], frame);
+                int grid = blue_pixels(path, GRID_BOTTOM);
+                int stray = blue_pixels(path, STRAY_ROW);
+                printf("square vector frame %d : row %d %d blue pixels, row %d %d\n", frame, GRID_BOTTOM, grid,
+                       STRAY_ROW, stray);
+                CHECK(grid >= 256);
+                CHECK(stray == 0);
+            }
+        }
+    }
+
+    return test_result("osc");
+}
@@ -0,0 +1,45 @@
+// test.h
+// host test helpers : CHECK counts the failures & prints the failing line, bench_ns times a loop
+// Each test_<module>.c is one executable, its exit code is the ctest result (0 : pass)
+
+#ifndef TEST_H
+#define TEST_H
+
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+
+static int test_failures;
+
+#define CHECK(cond)                                                                                    \
+    do {                                                                                               \
+        if (!(cond)) {                                                                                 \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond);                            \
+            test_failures++;                                                                           \
+        }                                                                                              \
+    } while (0)
+
+#define CHECK_NEAR(a, b, tol)                                                                          \
+    do {                                                                                               \
+        double a_ = (a), b_ = (b);                                                                     \
+        if (!(fabs(a_ - b_) <= (tol))) {                                                               \
+            printf("%s:%d: %s = %g, expected %g +- %g\n", __FILE__, __LINE__, #a, a_, b_, (double)(tol)); \
+            test_failures++;                                                                           \
+        }                                                                                              \
+    } while (0)
+
+// Function to get a monotonic time [ns]
+static inline double test_now_ns(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+// Function to end a test : prints the result
+// Returns: exit code
+static inline int test_result(const char *name) {
+    printf("%s : %s (%d failures)\n", name, test_failures == 0 ? "pass" : "FAIL", test_failures);
+    return test_failures != 0;
+}
+
+#endif // TEST_H
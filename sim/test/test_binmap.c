@@ -0,0 +1,148 @@
+// test_binmap.c
+// binmap.c on the view axes of dsp.c (50Hz .. 25kHz, 97.65625Hz bins) : band edges against the bin grid,
+// contiguity of neighbouring entries, weights summing to each span, DC left out of the lowest band,
+// power conservation of the 1/1, 1/3 & 1/6 octave maps against an exact integration of the bins, and the
+// cost of one binmap_apply sweep
+
+#include "binmap.h"
+#include "test.h"
+#include <stdlib.h>
+
+#define NBINS 256        // FFT_SIZE / 2
+#define BIN_HZ 97.65625f // 50ksps / 512
+#define F_MIN 50.0f      // VIEW_F_MIN
+#define F_MAX 25000.0f
+
+static float power[NBINS];
+static float out[BINMAP_MAX_ENTRIES];
+
+// span of an entry in bin units : bin k covers [k, k + 1)
+static double span_lo(double f) {
+    double a = f / BIN_HZ + 0.5;
+    return a < 1.0 ? 1.0 : a;
+}
+
+static double span_hi(double f) {
+    double b = f / BIN_HZ + 0.5;
+    return b > NBINS ? NBINS : b;
+}
+
+// exact power of the bins over [a, b), the partial bins by their overlap
+static double integrate(double a, double b) {
+    double sum = 0.0;
+    for (int k = 0; k < NBINS; k++) {
+        double lo = a > k ? a : k;
+        double hi = b < k + 1 ? b : k + 1;
+        if (hi > lo)
+            sum += (hi - lo) * power[k];
+    }
+    return sum;
+}
+
+// weights of an entry [bins]
+static double entry_width(const binmap_entry *e) {
+    if (e->count == 1)
+        return e->w_first / 4096.0;
+    return (e->w_first + e->w_last) / 4096.0 + (e->count - 2);
+}
+
+// edges, contiguity & weights of a map, band i spans [f_lo(i), f_hi(i))
+static void check_map(const char *name, const binmap *m, double ratio) {
+    double max_gap = 0.0;
+    for (int i = 0; i < m->count; i++) {
+        const binmap_entry *e = &m->entry[i];
+        double f_lo = m->freq[i] / sqrt(ratio), f_hi = m->freq[i] * sqrt(ratio);
+        double a = span_lo(f_lo), b = span_hi(f_hi);
+
+        CHECK(e->start >= 1); // DC is never part of a band
+        CHECK(e->count >= 1);
+        CHECK(e->start + e->count <= NBINS);
+        CHECK(e->start == (int)floor(a));
+        CHECK(e->start + e->count == (int)ceil(b));
+        CHECK_NEAR(entry_width(e), b - a, 2.0 / 4096.0);
+
+        // the next entry starts where this one ends : a shared bin is split between both
+        if (i + 1 < m->count) {
+            const binmap_entry *n = &m->entry[i + 1];
+            double gap = fabs(span_lo(m->freq[i + 1] / sqrt(ratio)) - b);
+            max_gap = gap > max_gap ? gap : max_gap;
+            int last = e->start + e->count - 1;
+            CHECK(n->start == last || n->start == last + 1);
+            if (n->start == last && e->count > 1 && n->count > 1)
+                CHECK(abs(e->w_last + n->w_first - 4096) <= 1);
+        }
+    }
+    printf("%-4s : %3d entries, bins %d .. %d, max gap %.1e bins\n", name, m->count, m->entry[0].start,
+           m->entry[m->count - 1].start + m->entry[m->count - 1].count - 1, max_gap);
+    CHECK(max_gap < 1e-3);
+}
+
+int main(void) {
+    static binmap m;
+
+    // log axis : 256 columns, each the average power of its span
+    binmap_log(&m, NBINS, F_MIN, F_MAX, BIN_HZ, NBINS);
+    CHECK(m.count == NBINS);
+    check_map("log", &m, pow(F_MAX / F_MIN, 1.0 / NBINS));
+    CHECK_NEAR(m.freq[0], F_MIN * pow(F_MAX / F_MIN, 0.5 / NBINS), 0.01);
+    for (int k = 0; k < NBINS; k++)
+        power[k] = 1.0f;
+    binmap_apply(&m, power, out);
+    for (int i = 0; i < m.count; i++)
+        CHECK_NEAR(out[i], 1.0, m.gain[i] / 4096.0); // the average of a flat spectrum, to the Q12 weights
+
+    // octave maps : band powers, the bands are contiguous so their sum is the power of the covered bins
+    const int fraction[3] = {1, 3, 6};
+    const int bands[3] = {9, 27, 54}; // 1kHz * 2^(k / fraction) from 62.5Hz (the 50Hz edge) to 16kHz
+    srand(1);
+    for (int f = 0; f < 3; f++) {
+        char name[8];
+        snprintf(name, sizeof(name), "oct%d", fraction[f]);
+        binmap_octave(&m, fraction[f], F_MIN, F_MAX, BIN_HZ, NBINS);
+        double ratio = pow(2.0, 1.0 / fraction[f]);
+        check_map(name, &m, ratio);
+        CHECK(m.count == bands[f]);
+        CHECK(m.freq[0] * sqrt(ratio) > F_MIN);
+        CHECK(m.freq[m.count - 1] <= F_MAX);
+
+        double err = 0.0, total = 0.0, ref = 0.0;
+        for (int run = 0; run < 20; run++) {
+            power[0] = 1e6f; // a DC offset must not leak into the lowest band
+            for (int k = 1; k < NBINS; k++)
+                power[k] = (float)rand() / RAND_MAX;
+            binmap_apply(&m, power, out);
+            for (int i = 0; i < m.count; i++) {
+                double f_lo = m.freq[i] / sqrt(ratio), f_hi = m.freq[i] * sqrt(ratio);
+                double e = integrate(span_lo(f_lo), span_hi(f_hi));
+                err = fmax(err, fabs(out[i] - e));
+            }
+            total = 0.0;
+            for (int i = 0; i < m.count; i++)
+                total += out[i];
+            ref = integrate(span_lo(m.freq[0] / sqrt(ratio)), span_hi(m.freq[m.count - 1] * sqrt(ratio)));
+            CHECK_NEAR(total / ref, 1.0, 1e-3);
+        }
+        printf("%-4s : max band error %.1e, total %.2f against %.2f\n", name, err, total, ref);
+        CHECK(err <= 1.0 / 4096.0); // a Q12 weight rounding on the first & last bins (power <= 1)
+    }
+
+    // cost of one sweep
+    const int views[4] = {0, 1, 3, 6};
+    for (int v = 0; v < 4; v++) {
+        if (views[v] == 0)
+            binmap_log(&m, NBINS, F_MIN, F_MAX, BIN_HZ, NBINS);
+        else
+            binmap_octave(&m, views[v], F_MIN, F_MAX, BIN_HZ, NBINS);
+        int reps = 100000;
+        double t0 = test_now_ns();
+        for (int r = 0; r < reps; r++) {
+            power[r & (NBINS - 1)] += 1e-6f; // a new spectrum each sweep
+            binmap_apply(&m, power, out);
+        }
+        double ns = (test_now_ns() - t0) / reps;
+        printf("binmap_apply %s%d, %3d entries : %.0f ns per sweep (%.2f ns per bin)\n", views[v] ? "oct" : "log",
+               views[v] ? views[v] : NBINS, m.count, ns, ns / NBINS);
+    }
+
+    return test_result("binmap");
+}
@@ -0,0 +1,89 @@
+// test_capcodec.c
+// capcodec.c : lossless round trips (tone + noise, full scale steps, constant, random, odd lengths),
+// CAPCODEC_MAX_BYTES bound, truncated & corrupt input rejected, size and speed per 5120 sample capture
+
+#include "capcodec.h"
+#include "test.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SAMPLES 5120 // RAW_SAMPLES
+
+static uint16_t in[SAMPLES], out[SAMPLES];
+static uint8_t enc[CAPCODEC_MAX_BYTES(SAMPLES)];
+
+// Returns: encoded size, -1 if the round trip differs
+static int round_trip(int count) {
+    int len = capcodec_encode(in, count, enc, sizeof(enc));
+    if (len < 0 || len > CAPCODEC_MAX_BYTES(count))
+        return -1;
+    memset(out, 0xAA, sizeof(out));
+    if (capcodec_decode(enc, len, out, count) != count)
+        return -1;
+    return memcmp(in, out, count * sizeof(in[0])) == 0 ? len : -1;
+}
+
+int main(void) {
+    srand(3);
+
+    // 1kHz tone at 500ksps, -6dBFS, +-4 LSB noise
+    for (int i = 0; i < SAMPLES; i++)
+        in[i] = (uint16_t)(2048 + lrint(1024.0 * sin(2.0 * M_PI * 1000.0 * i / 500000.0)) + rand() % 9 - 4);
+    int tone = round_trip(SAMPLES);
+    CHECK(tone > 0);
+
+    // constant : 4 bits per group
+    for (int i = 0; i < SAMPLES; i++)
+        in[i] = 1234;
+    int flat = round_trip(SAMPLES);
+    CHECK(flat > 0 && flat < SAMPLES / 32 + 8);
+
+    // rail to rail steps : the largest deltas (+-4095, 13 bit zigzag, the negative ones went through the shift)
+    for (int i = 0; i < SAMPLES; i++)
+        in[i] = (i & 1) ? 4095 : 0;
+    int steps = round_trip(SAMPLES);
+    CHECK(steps > 0);
+
+    // random 12bit data : worst case size
+    for (int i = 0; i < SAMPLES; i++)
+        in[i] = (uint16_t)(rand() & 0x0FFF);
+    int noise = round_trip(SAMPLES);
+    CHECK(noise > 0 && noise <= CAPCODEC_MAX_BYTES(SAMPLES));
+
+    // every length around the group size, the upper 4 bits are ignored
+    for (int count = 1; count <= 3 * CAPCODEC_GROUP + 2; count++)
+        CHECK(round_trip(count) > 0);
+    in[0] = 0xF123;
+    int len = capcodec_encode(in, 5, enc, sizeof(enc));
+    CHECK(capcodec_decode(enc, len, out, 5) == 5 && out[0] == 0x123);
+
+    // short output buffer, truncated & corrupt input
+    for (int i = 0; i < SAMPLES; i++)
+        in[i] = (uint16_t)(rand() & 0x0FFF);
+    len = capcodec_encode(in, SAMPLES, enc, sizeof(enc));
+    CHECK(capcodec_encode(in, SAMPLES, enc, len - 1) == -1);
+    CHECK(capcodec_decode(enc, len / 2, out, SAMPLES) == -1);
+    enc[2] = 0x0F; // width 15 > 13
+    CHECK(capcodec_decode(enc, len, out, SAMPLES) == -1);
+
+    printf("5120 samples : tone %d bytes (%.1f bits / sample), constant %d, steps %d, random %d (max %d)\n", tone,
+           tone * 8.0 / SAMPLES, flat, steps, noise, CAPCODEC_MAX_BYTES(SAMPLES));
+
+    // speed on the tone capture
+    for (int i = 0; i < SAMPLES; i++)
+        in[i] = (uint16_t)(2048 + lrint(1024.0 * sin(2.0 * M_PI * 1000.0 * i / 500000.0)) + rand() % 9 - 4);
+    int reps = 2000;
+    double t0 = test_now_ns();
+    for (int r = 0; r < reps; r++)
+        len = capcodec_encode(in, SAMPLES, enc, sizeof(enc));
+    double enc_ns = (test_now_ns() - t0) / reps;
+    t0 = test_now_ns();
+    for (int r = 0; r < reps; r++)
+        capcodec_decode(enc, len, out, SAMPLES);
+    double dec_ns = (test_now_ns() - t0) / reps;
+    printf("encode %.1f us, decode %.1f us per capture (%.1f / %.1f Msamples/s)\n", enc_ns / 1000.0, dec_ns / 1000.0,
+           SAMPLES * 1000.0 / enc_ns, SAMPLES * 1000.0 / dec_ns);
+
+    return test_result("capcodec");
+}
@@ -0,0 +1,124 @@
+// test_capstore.c
+// capstore.c on a RAM flash model (erase sets 0xFF, program only clears bits, as the QSPI flash) :
+// write & read back, rescan, ring wrap, a write interrupted by a reset, flash errors, corrupt payload,
+// and the flash operations per record with their time at the datasheet typicals (45ms erase, 1ms program)
+
+#include "capstore.h"
+#include "test.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define SECTOR 4096
+#define PAGE 256
+#define REGION (16 * SECTOR)
+#define ERASE_US 45000
+#define PROGRAM_US 1000
+
+static uint8_t flash[REGION];
+static int erases, programs;
+static bool fail_erase;
+
+static bool ram_erase(void *ctx, uint32_t offset, uint32_t len) {
+    (void)ctx;
+    if (fail_erase || offset % SECTOR != 0 || offset + len > REGION)
+        return false;
+    memset(flash + offset, 0xFF, len);
+    erases++;
+    return true;
+}
+
+static bool ram_program(void *ctx, uint32_t offset, const uint8_t *data, uint32_t len) {
+    (void)ctx;
+    if (offset % PAGE != 0 || offset + len > REGION)
+        return false;
+    for (uint32_t i = 0; i < len; i++)
+        flash[offset + i] &= data[i];
+    programs++;
+    return true;
+}
+
+static const capstore_flash geometry = {flash, REGION, SECTOR, PAGE, ram_erase, ram_program, NULL};
+
+static uint8_t payload[8][6000];
+
+// Returns: number of capstore_step() calls of the record
+static int write_record(capstore *st, int n, uint32_t length) {
+    for (uint32_t i = 0; i < length; i++)
+        payload[n % 8][i] = (uint8_t)(rand() >> 4);
+    if (!capstore_begin(st, payload[n % 8], length, (uint16_t)n, 0, (uint32_t)n))
+        return -1;
+    int steps = 1;
+    while (!capstore_step(st))
+        steps++;
+    return steps;
+}
+
+static bool record_ok(const capstore *st, int i, int n, uint32_t length) {
+    const uint8_t *data;
+    const capstore_header *h = capstore_get(st, i, &data);
+    return h != NULL && h->samples == n && h->length == length && memcmp(data, payload[n % 8], length) == 0;
+}
+
+int main(void) {
+    capstore st;
+    srand(4);
+    memset(flash, 0xFF, sizeof(flash));
+
+    // empty region, one record of 2 sectors, read back & rescan
+    CHECK(capstore_init(&st, &geometry));
+    CHECK(st.count == 0);
+    erases = programs = 0;
+    int steps = write_record(&st, 0, 5000);
+    int pages = (int)((5000 + sizeof(capstore_header) + PAGE - 1) / PAGE);
+    CHECK(erases == 2 && programs == pages && steps == 2 + pages);
+    CHECK(st.count == 1 && record_ok(&st, 0, 0, 5000));
+    printf("5000 byte record : %d erases + %d programs in %d steps, %.1f ms of flash time, longest step %d ms\n",
+           erases, programs, steps, (erases * ERASE_US + programs * PROGRAM_US) / 1000.0, ERASE_US / 1000);
+    CHECK(capstore_init(&st, &geometry));
+    CHECK(st.count == 1 && record_ok(&st, 0, 0, 5000) && st.next_seq == 1);
+
+    // the ring wraps : 2 sector records, the oldest are overwritten
+    for (int n = 1; n < 20; n++)
+        CHECK(write_record(&st, n, 5000) > 0);
+    CHECK(st.count == 8);
+    for (int i = 0; i < st.count; i++)
+        CHECK(record_ok(&st, i, 12 + i, 5000));
+    capstore ref = st;
+    CHECK(capstore_init(&st, &geometry));
+    CHECK(st.count == ref.count && st.next_seq == ref.next_seq && st.head == ref.head);
+    CHECK(memcmp(st.index, ref.index, st.count * sizeof(st.index[0])) == 0);
+
+    // a reset during a write : the record is not valid, the record it was overwriting is gone
+    CHECK(capstore_begin(&st, payload[0], 5000, 20, 0, 20));
+    for (int s = 0; s < 5; s++)
+        CHECK(!capstore_step(&st)); // 2 erases & 3 of 20 pages
+    CHECK(capstore_init(&st, &geometry));
+    CHECK(st.count == 7);
+    for (int i = 0; i < st.count; i++)
+        CHECK(record_ok(&st, i, 13 + i, 5000));
+    CHECK(write_record(&st, 21, 100) > 0);
+    CHECK(st.count == 8 && record_ok(&st, 7, 21, 100));
+
+    // flash error : the record is dropped & counted
+    fail_erase = true;
+    CHECK(capstore_begin(&st, payload[0], 100, 22, 0, 22));
+    CHECK(capstore_step(&st));
+    CHECK(st.errors == 1 && !capstore_busy(&st));
+    fail_erase = false;
+
+    // a payload corrupted in the flash is not returned
+    const uint8_t *data;
+    const capstore_header *h = capstore_get(&st, 0, &data);
+    CHECK(h != NULL);
+    flash[(data - flash) + 10] ^= 0x01;
+    CHECK(capstore_get(&st, 0, &data) == NULL);
+
+    // host cost of the steps (CRC32 at capstore_begin, page fill), the flash time dominates on the target
+    int reps = 200;
+    double t0 = test_now_ns();
+    for (int r = 0; r < reps; r++)
+        write_record(&st, r, 5000);
+    printf("host cost of a 5000 byte record : %.1f us (RAM flash)\n", (test_now_ns() - t0) / reps / 1000.0);
+
+    return test_result("capstore");
+}
@@ -0,0 +1,143 @@
+// test_cmdshell.c
+// cmdshell.c fed character by character as from the USB CDC link : get / set / list / help / stats,
+// range & read only checks, decimal / hex / out of int range values, backspace, line overflow, CR LF & LF
+// line ends, apply() calls, and the cost of a set line
+
+#include "cmdshell.h"
+#include "test.h"
+#include <string.h>
+
+static char out[4096];
+static int applied;
+static int stats_calls;
+
+static void print(const char *text) {
+    if (strlen(out) + strlen(text) < sizeof(out))
+        strcat(out, text);
+}
+
+static void apply(void) {
+    applied++;
+}
+
+static void stats(void) {
+    stats_calls++;
+    print("stats\n");
+}
+
+static volatile int alpha = 8192;
+static volatile int scale = 40;
+static volatile int fft_size = 512;
+
+static const shell_param params[] = {
+    {"alpha", &alpha, 1, 32767, 0, apply, "IIR coefficient"},
+    {"scale", &scale, 10, 40, 0, NULL, "dots / V"},
+    {"fft_size", &fft_size, 512, 512, SHELL_RO, NULL, "FFT points"},
+};
+
+static shell sh;
+
+// feeds a text, clears the output first
+// Returns: result of the last shell_input() that was not SHELL_NONE (SHELL_NONE if none)
+static int feed(const char *text) {
+    int result = SHELL_NONE;
+    out[0] = '\0';
+    for (; *text; text++) {
+        int r = shell_input(&sh, (unsigned char)*text);
+        if (r != SHELL_NONE)
+            result = r;
+    }
+    return result;
+}
+
+static bool has(const char *text) {
+    return strstr(out, text) != NULL;
+}
+
+int main(void) {
+    shell_init(&sh, params, 3, print, stats);
+
+    // get / set, echo, apply
+    CHECK(feed("get alpha\n") == SHELL_DONE && has("get alpha\n") && has("alpha = 8192\n"));
+    CHECK(feed("set alpha 4096\r") == SHELL_SET && alpha == 4096 && applied == 1 && has("alpha = 4096\n"));
+    CHECK(feed("set scale 20\n") == SHELL_SET && scale == 20 && applied == 1); // no apply()
+    CHECK(feed("  set scale   30 \n") == SHELL_SET && scale == 30);           // extra spaces
+    CHECK(shell_find(&sh, "scale") == &params[1] && shell_find(&sh, "gain") == NULL);
+
+    // range, read only, unknown, missing & bad values : nothing is stored or applied
+    CHECK(feed("set scale 41\n") == SHELL_ERROR && scale == 30 && has("out of range [10..40]"));
+    CHECK(feed("set scale 9\n") == SHELL_ERROR && scale == 30);
+    CHECK(feed("set fft_size 512\n") == SHELL_ERROR && has("read only"));
+    CHECK(feed("set gain 3\n") == SHELL_ERROR && has("unknown parameter"));
+    CHECK(feed("get gain\n") == SHELL_ERROR && has("unknown parameter"));
+    CHECK(feed("set scale\n") == SHELL_ERROR && has("value expected"));
+    CHECK(feed("set scale 2x\n") == SHELL_ERROR && scale == 30);
+    CHECK(feed("set scale 0x\n") == SHELL_ERROR && scale == 30);
+    CHECK(feed("frobnicate\n") == SHELL_ERROR && has("unknown command"));
+    CHECK(applied == 1);
+
+    // values outside the int range are rejected, not truncated (4294967336 = 2^32 + 40)
+    CHECK(feed("set scale 4294967336\n") == SHELL_ERROR && scale == 30 && has("value expected"));
+    CHECK(feed("set scale -4294967256\n") == SHELL_ERROR && scale == 30);
+    CHECK(feed("set scale 99999999999999999999999\n") == SHELL_ERROR && scale == 30);
+    CHECK(feed("set alpha 2147483648\n") == SHELL_ERROR && alpha == 4096);
+    CHECK(feed("set alpha -2147483649\n") == SHELL_ERROR && alpha == 4096);
+
+    // hex & negative decimal
+    CHECK(feed("set alpha 0x7fff\n") == SHELL_SET && alpha == 32767);
+    CHECK(feed("set scale 0x14\n") == SHELL_SET && scale == 20);
+    CHECK(feed("set alpha -1\n") == SHELL_ERROR && has("out of range"));
+
+    // backspace & DEL erase the last character on the terminal & in the line, nothing before the line start
+    CHECK(feed("\bset scale 155\b\x7f" "5\n") == SHELL_SET && scale == 15);
+    CHECK(has("\b \b"));
+    CHECK(feed("get scxx\b\bale\n") == SHELL_DONE && has("scale = 15"));
+    feed("\b\b\b");
+    CHECK(out[0] == '\0'); // empty line : nothing to erase
+
+    // a line longer than SHELL_LINE_MAX - 1 is dropped whole, the next line works
+    char line[SHELL_LINE_MAX + 16];
+    memset(line, 'x', sizeof(line));
+    strcpy(line + SHELL_LINE_MAX + 4, "\n");
+    memcpy(line, "set scale 10 ", 13);
+    CHECK(feed(line) == SHELL_ERROR && has("line too long") && scale == 15);
+    CHECK(feed("set scale 10\n") == SHELL_SET && scale == 10);
+    // exactly SHELL_LINE_MAX - 1 characters still fit
+    memset(line, ' ', sizeof(line));
+    memcpy(line + SHELL_LINE_MAX - 1 - 12, "set scale 11", 12);
+    strcpy(line + SHELL_LINE_MAX - 1, "\n");
+    CHECK(feed(line) == SHELL_SET && scale == 11);
+
+    // CR LF runs the line once, the LF ends an empty line
+    applied = 0;
+    out[0] = '\0';
+    int results[3] = {0};
+    const char *crlf = "set alpha 100\r\n";
+    int n = 0;
+    for (const char *c = crlf; *c; c++) {
+        int r = shell_input(&sh, *c);
+        if (*c == '\r' || *c == '\n')
+            results[n++] = r;
+    }
+    CHECK(results[0] == SHELL_SET && results[1] == SHELL_NONE && applied == 1 && alpha == 100);
+    CHECK(feed("\r\n\n\r") == SHELL_NONE && out[0] == '\0');
+
+    // control characters are ignored, not echoed
+    CHECK(feed("get\x01 scale\x1b\n") == SHELL_DONE && has("scale = 11") && !has("\x01"));
+
+    // help, list, stats
+    CHECK(feed("help\n") == SHELL_DONE && has("set <name> <value>"));
+    CHECK(feed("list\n") == SHELL_DONE && has("alpha") && has("[1..32767]") && has("read only"));
+    CHECK(feed("stats\n") == SHELL_DONE && stats_calls == 1);
+    shell_init(&sh, params, 3, print, NULL);
+    CHECK(feed("stats\n") == SHELL_ERROR);
+
+    // cost of a set line, characters fed one at a time
+    int reps = 100000;
+    double t0 = test_now_ns();
+    for (int r = 0; r < reps; r++)
+        feed("set alpha 8192\n");
+    printf("\"set alpha 8192\" : %.0f ns per line (host)\n", (test_now_ns() - t0) / reps);
+
+    return test_result("cmdshell");
+}
@@ -0,0 +1,147 @@
+// test_distortion.c
+// distortion.c : THD / SNR / SINAD / ENOB of synthetic signals with known harmonics & noise, computed
+// from a float Hann windowed DFT power spectrum, and the same signal through an emulation of the Q15 &
+// Q31 powers (1/N RFFT scaling, mag_squared Q13 / 3.29) showing why the analysis needs the F32 pipeline
+
+#include "distortion.h"
+#include "test.h"
+#include <math.h>
+#include <stdlib.h>
+
+#define N 512
+#define NBINS (N / 2)
+
+static double signal[N];
+static float power[NBINS];
+static int16_t power_q13[NBINS];
+static int32_t power_q29[NBINS];
+
+static double gauss(void) {
+    double u1 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    double u2 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+// amplitude [ADC LSB] of the fundamental at bin k0, harmonic amplitudes relative to it, noise sigma [LSB]
+static void make_signal(int k0, double amp, const double *harm, int nharm, double sigma, int adc_bits) {
+    for (int i = 0; i < N; i++) {
+        double v = amp * sin(2.0 * M_PI * k0 * i / N);
+        for (int h = 0; h < nharm; h++)
+            v += amp * harm[h] * sin(2.0 * M_PI * k0 * (h + 2) * i / N + 0.3 * h);
+        v += sigma * gauss();
+        signal[i] = adc_bits > 0 ? floor(v + 0.5) : v; // ADC quantisation
+    }
+}
+
+static void dft_power(double scale, int fixed) {
+    for (int k = 0; k < NBINS; k++) {
+        double re = 0.0, im = 0.0;
+        for (int i = 0; i < N; i++) {
+            double w = 0.5 - 0.5 * cos(2.0 * M_PI * i / N);
+            double a = 2.0 * M_PI * k * i / N;
+            re += signal[i] * scale * w * cos(a);
+            im -= signal[i] * scale * w * sin(a);
+        }
+        if (fixed) {
+            // Q15 input (<< 3), output scaled by 1/N & rounded, arm_cmplx_mag_squared_q15 : >> 17 (Q13)
+            int32_t r = (int32_t)lrint(re / N);
+            int32_t m = (int32_t)lrint(im / N);
+            power_q13[k] = (int16_t)(((r * r) >> 17) + ((m * m) >> 17));
+            // Q31 input (<< 19), same 1/N scaling, arm_cmplx_mag_squared_q31 : (re^2 + im^2) >> 33 (3.29)
+            int64_t r31 = llrint(re * 65536.0 / N);
+            int64_t m31 = llrint(im * 65536.0 / N);
+            power_q29[k] = (int32_t)(((r31 * r31) >> 33) + ((m31 * m31) >> 33));
+        }
+        power[k] = (float)(re * re + im * im);
+    }
+}
+
+static dist_result analyse(dist_state *st, int budget) {
+    dist_init(st, NBINS, 3, 9);
+    dist_start_f32(st, power);
+    while (!dist_step(st, budget))
+        ;
+    return st->result;
+}
+
+int main(void) {
+    dist_state st;
+    srand(1);
+
+    // harmonics at -40dB & -50dB, no noise : THD -39.6dB
+    double harm[2] = {0.01, 0.00316228};
+    make_signal(20, 1500.0, harm, 2, 0.0, 0);
+    dft_power(1.0, 0);
+    dist_result r = analyse(&st, 1000);
+    CHECK(r.fund_bin == 20);
+    CHECK_NEAR(r.thd_db, 10.0 * log10(1e-4 + 1e-5), 0.2);
+
+    // white noise, 60dB SNR (sigma = amp / sqrt(2) / 1000), no harmonic
+    make_signal(20, 1500.0, NULL, 0, 1500.0 / sqrt(2.0) / 1000.0, 0);
+    dft_power(1.0, 0);
+    r = analyse(&st, 1000);
+    CHECK_NEAR(r.snr_db, 60.0, 1.0);
+    CHECK_NEAR(r.sinad_db, r.snr_db, 0.5);
+    CHECK_NEAR(r.enob, (r.sinad_db - 1.76) / 6.02, 0.01);
+
+    // harmonics & noise together : SINAD = fund / (noise + harmonics)
+    make_signal(20, 1500.0, harm, 2, 1500.0 / sqrt(2.0) / 1000.0, 0);
+    dft_power(1.0, 0);
+    r = analyse(&st, 1000);
+    double expect = -10.0 * log10(1e-6 + 1e-4 + 1e-5);
+    CHECK_NEAR(r.sinad_db, expect, 0.5);
+
+    // the 3rd harmonic of bin 100 folds back to bin 212 (decimated stream aliasing)
+    double h3[2] = {0.0, 0.01};
+    make_signal(100, 1500.0, h3, 2, 0.0, 0);
+    dft_power(1.0, 0);
+    r = analyse(&st, 1000);
+    CHECK(r.fund_bin == 100);
+    CHECK_NEAR(r.thd_db, -40.0, 0.2);
+
+    // a small step budget (DIST_STEP_BINS) gives the same result
+    dist_result r96 = analyse(&st, 96);
+    CHECK(r96.thd_db == r.thd_db && r96.snr_db == r.snr_db);
+
+    // 12bit ADC, -6dBFS sine : the float power gives the quantisation limited SNR (~68dB), the Q13 & 3.29
+    // powers of the fixed point pipelines have their noise bins at 0 and the SNR saturates
+    make_signal(20, 1000.0, NULL, 0, 0.0, 12);
+    dft_power(8.0, 1);
+    r = analyse(&st, 1000);
+    double snr_12bit = 10.0 * log10(1000.0 * 1000.0 / 2.0 / (1.0 / 12.0));
+    CHECK_NEAR(r.snr_db, snr_12bit, 2.0);
+    for (int k = 0; k < NBINS; k++)
+        power[k] = (float)power_q13[k];
+    dist_init(&st, NBINS, 3, 9);
+    dist_start_f32(&st, power);
+    while (!dist_step(&st, 1000))
+        ;
+    int zero_bins = 0;
+    for (int k = 0; k < NBINS; k++)
+        zero_bins += power_q13[k] == 0;
+    printf("12bit sine : float power SNR %.1fdB (ideal %.1fdB), Q13 power SNR %.1fdB (%d of %d bins 0)\n", r.snr_db,
+           snr_12bit, st.result.snr_db, zero_bins, NBINS);
+    CHECK(st.result.snr_db > snr_12bit + 20.0);
+    for (int k = 0; k < NBINS; k++)
+        power[k] = (float)power_q29[k];
+    dist_init(&st, NBINS, 3, 9);
+    dist_start_f32(&st, power);
+    while (!dist_step(&st, 1000))
+        ;
+    zero_bins = 0;
+    for (int k = 0; k < NBINS; k++)
+        zero_bins += power_q29[k] == 0;
+    printf("12bit sine : Q29 power SNR %.1fdB (%d of %d bins 0)\n", st.result.snr_db, zero_bins, NBINS);
+    CHECK(st.result.snr_db > snr_12bit + 20.0);
+
+    // cost of one analysis
+    make_signal(20, 1500.0, harm, 2, 1.0, 0);
+    dft_power(1.0, 0);
+    int reps = 20000;
+    double t0 = test_now_ns();
+    for (int i = 0; i < reps; i++)
+        analyse(&st, 96);
+    printf("analysis of %d bins : %.0f ns\n", NBINS, (test_now_ns() - t0) / reps);
+
+    return test_result("distortion");
+}
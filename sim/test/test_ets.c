@@ -0,0 +1,171 @@
+// test_ets.c
+// ets.c on synthetic captures of the OUTPUT_PIN PWM (2343.75Hz, 50% duty, tanh edges) : fill against the
+// acquisitions with & without the random start phase, error of the reconstruction against the ideal edge,
+// the calibration of the counter to ADC start latency with ets_edge_ns, ets_clear, the level trigger on a
+// slow edge, and the host cost of the binning & of the reconstruction
+
+#include "ets.h"
+#include "test.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define BINS 256        // OSC_SIZE
+#define PRE_BINS 64     // ETS_PRE_BINS
+#define BIN_NS 50.0f    // ETS_BIN_NS
+#define TS_NS 2000.0f   // 500ksps
+#define CAPTURE 2048    // ETS_CAPTURE
+#define WRAP 64000      // PWM_WRAP + 1 at 150MHz
+#define CLK_NS (1e9 / 150e6)
+#define ADC_CLK_NS (1e9 / 48e6) // the ADC starts on its next clock edge
+#define AMP 1000.0
+
+static const double period_ns = WRAP * CLK_NS;
+static uint16_t x[CAPTURE];
+static int16_t trace[BINS];
+
+// PWM output through the front end : rising edge at 0, falling at half the period [0 .. 1]
+static double wave(double t, double tau) {
+    t = fmod(t, period_ns);
+    t = t < 0.0 ? t + period_ns : t;
+    if (t < period_ns / 4.0 || t > 3.0 * period_ns / 4.0)
+        return 0.5 * (1.0 + tanh((t < period_ns / 2.0 ? t : t - period_ns) / tau));
+    return 0.5 * (1.0 - tanh((t - period_ns / 2.0) / tau));
+}
+
+static double level(double t, double tau) {
+    return 2048.0 + AMP * (2.0 * wave(t, tau) - 1.0);
+}
+
+// one acquisition : the counter is read, the ADC starts latency_ns later on its next clock edge
+// tau: edge time constant (10% .. 90% : 2.2 tau), dither: random start phase, latency_set_ns: the
+// compensation (ETS_LATENCY_NS), level_trigger: ets_add_level instead of the counter phase
+static void acquire(ets_state *st, double tau, bool dither, double latency_ns, double latency_set_ns, int noise,
+                    bool level_trigger) {
+    int counter = dither ? rand() % WRAP : 12345;
+    double phase0 = counter * CLK_NS;
+    double t0 = phase0 + latency_ns + (rand() % 1000) / 1000.0 * ADC_CLK_NS;
+    for (int i = 0; i < CAPTURE; i++) {
+        int32_t v = (int32_t)lrint(level(t0 + i * (double)TS_NS, tau));
+        if (noise > 0)
+            v += rand() % (2 * noise + 1) - noise;
+        x[i] = (uint16_t)v;
+    }
+    if (level_trigger)
+        ets_add_level(st, x, CAPTURE, 2048, (uint16_t)(AMP / 4));
+    else
+        ets_add_phase(st, x, CAPTURE, (float)(phase0 + latency_set_ns), (float)period_ns);
+}
+
+// RMS error of the reconstruction against the ideal wave at the bin centres [LSB]
+static double rms_error(const ets_state *st, double tau, double shift_ns) {
+    ets_reconstruct(st, trace);
+    double sum = 0.0;
+    for (int b = 0; b < BINS; b++) {
+        double e = trace[b] - level((b - PRE_BINS + 0.5) * BIN_NS + shift_ns, tau);
+        sum += e * e;
+    }
+    return sqrt(sum / BINS);
+}
+
+int main(void) {
+    static ets_state st;
+    double tau_fast = 300.0 / 2.2; // 300ns edge
+    double tau_slow = 4000.0 / 2.2;
+    float edge;
+    srand(5);
+
+    // fill against the acquisitions : random start phase, then a start locked to the PWM period
+    ets_init(&st, BINS, PRE_BINS, BIN_NS, TS_NS);
+    int fill[4];
+    int at[4] = {1, 8, 16, 64};
+    for (int a = 1, k = 0; a <= 64; a++) {
+        acquire(&st, tau_fast, true, 0.0, 0.0, 2, false);
+        if (a == at[k])
+            fill[k++] = ets_fill_pct(&st);
+    }
+    double err = rms_error(&st, tau_fast, ADC_CLK_NS / 2.0);
+    printf("phase trigger, 300ns edge : fill %d / %d / %d / %d%% after 1 / 8 / 16 / 64 acquisitions, %.1f Msps, "
+           "%.1f LSB RMS error\n",
+           fill[0], fill[1], fill[2], fill[3], ets_rate_msps(&st), err);
+    CHECK(fill[1] >= 40 && fill[3] >= 95);
+    CHECK(err < 8.0);
+    CHECK(st.acquisitions == 64 && st.triggers >= 64 * 9);
+
+    ets_clear(&st);
+    CHECK(st.filled == 0 && st.acquisitions == 0 && st.samples == 0 && ets_fill_pct(&st) == 0);
+    ets_reconstruct(&st, trace);
+    CHECK(trace[0] == 0 && trace[BINS - 1] == 0);
+    CHECK(!ets_edge_ns(&st, trace, &edge));
+    for (int a = 0; a < 64; a++)
+        acquire(&st, tau_fast, false, 0.0, 0.0, 2, false);
+    printf("start locked to the PWM : fill %d%% after 64 acquisitions\n", ets_fill_pct(&st));
+    CHECK(ets_fill_pct(&st) <= 10);
+
+    // latency : the trace is early by the uncompensated latency, the edge time gives the setting
+    double latency = 730.0;
+    ets_clear(&st);
+    for (int a = 0; a < 64; a++)
+        acquire(&st, tau_fast, true, latency, 0.0, 2, false);
+    ets_reconstruct(&st, trace);
+    CHECK(ets_edge_ns(&st, trace, &edge));
+    float before = edge;
+    CHECK_NEAR(edge, -latency - ADC_CLK_NS / 2.0, 25.0);
+    ets_clear(&st);
+    for (int a = 0; a < 64; a++)
+        acquire(&st, tau_fast, true, latency, -before, 2, false);
+    ets_reconstruct(&st, trace);
+    CHECK(ets_edge_ns(&st, trace, &edge));
+    printf("latency %.0f ns : edge %+.0f ns, compensated with %.0f ns : edge %+.0f ns, %.1f LSB RMS error\n", latency,
+           before, -before, edge, rms_error(&st, tau_fast, 0.0));
+    CHECK(fabsf(edge) < 25.0f);
+
+    // a slow ramp (a slice of the sine) has no edge time
+    ets_clear(&st);
+    for (int b = 0; b < BINS; b++) {
+        st.sum[b] = 2000 + 3 * b;
+        st.count[b] = 1;
+    }
+    st.filled = BINS;
+    ets_reconstruct(&st, trace);
+    CHECK(!ets_edge_ns(&st, trace, &edge));
+
+    // level trigger : the crossing interpolated between samples, a 4us edge
+    ets_init(&st, BINS, PRE_BINS, BIN_NS, TS_NS);
+    for (int a = 0; a < 64; a++)
+        acquire(&st, tau_slow, true, 0.0, 0.0, 2, true);
+    err = rms_error(&st, tau_slow, 0.0);
+    ets_reconstruct(&st, trace);
+    CHECK(ets_edge_ns(&st, trace, &edge));
+    printf("level trigger, 4us edge : fill %d%% after 64 acquisitions, %.1f LSB RMS error, edge %+.0f ns\n",
+           ets_fill_pct(&st), err, edge);
+    CHECK(ets_fill_pct(&st) == 100);
+    CHECK(err < 25.0);
+    CHECK(fabsf(edge) < 100.0f);
+
+    // host cost (best of 5) : binning per ADC sample, reconstruction & edge per trace
+    int reps = 1000;
+    double ns[4] = {0.0, 0.0, 0.0, 0.0};
+    acquire(&st, tau_fast, true, 0.0, 0.0, 2, false);
+    for (int round = 0; round < 5; round++) {
+        for (int v = 0; v < 4; v++) {
+            double t0 = test_now_ns();
+            for (int r = 0; r < reps; r++) {
+                if (v == 0)
+                    ets_add_phase(&st, x, CAPTURE, (float)(r * 7.0 * CLK_NS), (float)period_ns);
+                else if (v == 1)
+                    ets_add_level(&st, x, CAPTURE, 2048, (uint16_t)(AMP / 4));
+                else if (v == 2)
+                    ets_reconstruct(&st, trace);
+                else
+                    ets_edge_ns(&st, trace, &edge);
+            }
+            double d = (test_now_ns() - t0) / reps;
+            ns[v] = round == 0 || d < ns[v] ? d : ns[v];
+        }
+    }
+    printf("ets_add_phase %.2f ns, ets_add_level %.2f ns per sample, ets_reconstruct %.2f us, ets_edge_ns %.2f us "
+           "(host)\n",
+           ns[0] / CAPTURE, ns[1] / CAPTURE, ns[2] / 1000.0, ns[3] / 1000.0);
+
+    return test_result("ets");
+}
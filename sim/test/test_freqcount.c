@@ -0,0 +1,142 @@
+// test_freqcount.c
+// freqcount.c on synthetic 500ksps streams in 0.5s gates : frequency error (ppm) of sines from 50Hz to 20KHz
+// with ADC noise, duty of squares, results independent of the chunk size, small signals rejected, a gate
+// with lost samples (fc_lost) dropped and the next one valid, and the kernel cost per sample
+
+#include "freqcount.h"
+#include "test.h"
+#include <math.h>
+#include <stdlib.h>
+
+#define FS 500000.0
+#define GATE 250000 // FC_GATE_SAMPLES
+#define CHUNK 64    // FC_CHUNK
+
+static uint16_t x[GATE];
+
+// sine or square (duty in %) of amplitude amp around 2048, noise +-noise LSB, starting at sample start
+static void make_gate(double freq, double amp, int noise, double duty, long start) {
+    for (int i = 0; i < GATE; i++) {
+        double ph = fmod(freq * (start + i) / FS + 0.123, 1.0);
+        double v = duty > 0.0 ? (ph < duty / 100.0 ? amp : -amp) : amp * sin(2.0 * M_PI * ph);
+        int n = noise > 0 ? rand() % (2 * noise + 1) - noise : 0;
+        x[i] = (uint16_t)(2048 + lrint(v) + n);
+    }
+}
+
+static void feed(fc_state *st, int chunk) {
+    for (int i = 0; i < GATE; i += chunk)
+        fc_process(st, x + i, GATE - i < chunk ? GATE - i : chunk);
+}
+
+// Returns: result of the third gate (the first ones set the level)
+static fc_result run(double freq, double amp, int noise, double duty, int chunk) {
+    fc_state st;
+    fc_result r;
+    fc_init(&st, (float)FS, 2048);
+    for (int g = 0; g < 3; g++) {
+        make_gate(freq, amp, noise, duty, (long)g * GATE);
+        feed(&st, chunk);
+        fc_gate(&st, &r);
+    }
+    return r;
+}
+
+static double ppm(const fc_result *r, double freq) {
+    return fabs(r->freq_hz - freq) / freq * 1e6;
+}
+
+int main(void) {
+    srand(6);
+    double freqs[] = {50.0, 123.4, 1000.123, 2343.75, 9999.0, 20000.0};
+    int nf = sizeof(freqs) / sizeof(freqs[0]);
+
+    // sines, 0.5 LSB & 4 LSB noise
+    int noises[] = {0, 4};
+    double tol[] = {1.0, 20.0};
+    for (int k = 0; k < 2; k++) {
+        double worst = 0.0;
+        for (int i = 0; i < nf; i++) {
+            fc_result r = run(freqs[i], 1500.0, noises[k], 0.0, CHUNK);
+            CHECK(r.valid && !r.lost);
+            CHECK_NEAR(r.period_us, 1e6 / r.freq_hz, 1e-6);
+            CHECK_NEAR(r.duty_pct, 50.0, 0.1);
+            worst = ppm(&r, freqs[i]) > worst ? ppm(&r, freqs[i]) : worst;
+        }
+        printf("sine 50Hz .. 20KHz, quantised, +-%d LSB noise : |err| <= %.2f ppm\n", noises[k], worst);
+        CHECK(worst < tol[k]);
+    }
+
+    // squares : the edges fall on whole samples, +-1 sample per edge
+    double worst = 0.0;
+    for (int i = 0; i < nf; i++) {
+        fc_result r = run(freqs[i], 1500.0, 2, 30.0, CHUNK);
+        CHECK(r.valid);
+        CHECK_NEAR(r.duty_pct, 30.0, 100.0 * freqs[i] / FS + 0.01);
+        worst = ppm(&r, freqs[i]) > worst ? ppm(&r, freqs[i]) : worst;
+    }
+    printf("square 30%% duty : |err| <= %.2f ppm\n", worst);
+    CHECK(worst < 5.0);
+
+    // the chunk size does not change the result
+    fc_result a = run(1000.123, 1500.0, 0, 0.0, CHUNK);
+    int chunks[] = {1, 7, 1000, GATE};
+    for (int c = 0; c < 4; c++) {
+        fc_result b = run(1000.123, 1500.0, 0, 0.0, chunks[c]);
+        CHECK(b.valid && b.freq_hz == a.freq_hz && b.duty_pct == a.duty_pct && b.periods == a.periods);
+    }
+
+    // empty chunks between the samples change nothing (no x[-1] read)
+    fc_state st;
+    fc_result r, ref;
+    fc_init(&st, (float)FS, 2048);
+    make_gate(1000.123, 1500.0, 0, 0.0, 0);
+    feed(&st, CHUNK);
+    fc_gate(&st, &ref);
+    fc_init(&st, (float)FS, 2048);
+    for (int i = 0; i < GATE; i += CHUNK) {
+        fc_process(&st, x + i, 0);
+        fc_process(&st, x + i, GATE - i < CHUNK ? GATE - i : CHUNK);
+    }
+    fc_process(&st, NULL, 0);
+    fc_gate(&st, &r);
+    CHECK(r.valid && r.freq_hz == ref.freq_hz && r.duty_pct == ref.duty_pct && r.periods == ref.periods);
+
+    // under FC_MIN_PP (32 counts) : no result
+    fc_result small = run(1000.0, 10.0, 0, 0.0, CHUNK);
+    CHECK(!small.valid && !small.lost && small.pp < 32);
+
+    // lost samples : the gate is dropped, the next gate is valid again
+    fc_init(&st, (float)FS, 2048);
+    make_gate(1000.123, 1500.0, 0, 0.0, 0);
+    feed(&st, CHUNK);
+    fc_gate(&st, &r);
+    CHECK(r.valid);
+    make_gate(1000.123, 1500.0, 0, 0.0, GATE);
+    fc_process(&st, x, GATE / 2);
+    fc_lost(&st); // the FIFO overflowed : 1000 samples missing
+    fc_process(&st, x + GATE / 2 + 1000, GATE / 2 - 1000);
+    fc_gate(&st, &r);
+    CHECK(!r.valid && r.lost && r.freq_hz == 0.0);
+    make_gate(1000.123, 1500.0, 0, 0.0, 2L * GATE);
+    feed(&st, CHUNK);
+    fc_gate(&st, &r);
+    CHECK(r.valid && !r.lost && ppm(&r, 1000.123) < 1.0);
+
+    // kernel cost, the crossings per sample rise with the frequency
+    double bench_freqs[] = {50.0, 1000.0, 20000.0};
+    for (int i = 0; i < 3; i++) {
+        make_gate(bench_freqs[i], 1500.0, 4, 0.0, 0);
+        fc_init(&st, (float)FS, 2048);
+        int reps = 20;
+        double t0 = test_now_ns();
+        for (int k = 0; k < reps; k++) {
+            feed(&st, CHUNK);
+            fc_gate(&st, &r);
+        }
+        printf("fc_process %5.0f Hz : %.2f ns / sample (host)\n", bench_freqs[i],
+               (test_now_ns() - t0) / reps / GATE);
+    }
+
+    return test_result("freqcount");
+}
@@ -0,0 +1,140 @@
+// test_goertzel.c
+// goertzel.c : tone levels against a float DFT of the same block, chunked feeding, cost against a full
+// FFT of the block for 1 .. GOERTZEL_MAX_TONES tones
+// The FFT is a float radix-2 complex FFT + magnitude so the host tests build without CMSIS-DSP, a stand-in
+// for the cost of the spectrum path, not a measure of it : bench_goertzel (CMSIS-DSP builds) times the Q15
+// path of dsp.c (fft_exec + fft_publish) against the bank on the same capture
+
+#include "goertzel.h"
+#include "test.h"
+#include <math.h>
+#include <stdlib.h>
+
+#define FS 50000.0f
+#define N 512
+
+static int16_t block[N];
+
+static void make_block(const float *freq, const float *amp, int count, int noise) {
+    for (int i = 0; i < N; i++) {
+        float v = 0.0f;
+        for (int t = 0; t < count; t++)
+            v += amp[t] * sinf(2.0f * (float)M_PI * freq[t] * i / FS);
+        if (noise > 0)
+            v += (float)(rand() % (2 * noise + 1) - noise);
+        block[i] = (int16_t)lrintf(v);
+    }
+}
+
+// level of one frequency over the block, same reference as the bank (full scale sine : 0dB)
+static double dft_db(float freq) {
+    double re = 0.0, im = 0.0;
+    for (int i = 0; i < N; i++) {
+        double a = 2.0 * M_PI * freq * i / FS;
+        re += block[i] * cos(a);
+        im -= block[i] * sin(a);
+    }
+    double mag = sqrt(re * re + im * im) / (32768.0 * N * 0.5);
+    return mag > 0.0 ? 20.0 * log10(mag) : -120.0;
+}
+
+static float fft_re[N], fft_im[N], fft_cos[N / 2], fft_sin[N / 2], fft_pow[N / 2];
+
+static void fft_setup(void) {
+    for (int i = 0; i < N / 2; i++) {
+        fft_cos[i] = cosf(2.0f * (float)M_PI * i / N);
+        fft_sin[i] = -sinf(2.0f * (float)M_PI * i / N);
+    }
+}
+
+static void fft_power(const int16_t *x) {
+    for (int i = 0, j = 0; i < N; i++) {
+        fft_re[j] = x[i];
+        fft_im[j] = 0.0f;
+        // bit reversed index
+        int bit = N >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j |= bit;
+    }
+    for (int len = 2; len <= N; len <<= 1) {
+        int step = N / len;
+        for (int i = 0; i < N; i += len) {
+            for (int k = 0; k < len / 2; k++) {
+                float wr = fft_cos[k * step], wi = fft_sin[k * step];
+                float *ar = &fft_re[i + k], *ai = &fft_im[i + k];
+                float *br = &fft_re[i + k + len / 2], *bi = &fft_im[i + k + len / 2];
+                float tr = *br * wr - *bi * wi;
+                float ti = *br * wi + *bi * wr;
+                *br = *ar - tr;
+                *bi = *ai - ti;
+                *ar += tr;
+                *ai += ti;
+            }
+        }
+    }
+    for (int k = 0; k < N / 2; k++)
+        fft_pow[k] = fft_re[k] * fft_re[k] + fft_im[k] * fft_im[k];
+}
+
+int main(void) {
+    // PWM fundamental & odd harmonics, as TONE_TRACK
+    float freq[GOERTZEL_MAX_TONES];
+    for (int t = 0; t < GOERTZEL_MAX_TONES; t++)
+        freq[t] = 2343.75f * (2 * t + 1) > FS / 2 ? 1000.0f * t : 2343.75f * (2 * t + 1);
+    goertzel_bank bank;
+
+    // levels : bin centred & off bin tones, an absent tone, against the float DFT
+    float amp[3] = {16000.0f, 3000.0f, 300.0f};
+    make_block(freq, amp, 3, 0);
+    goertzel_bank_init(&bank, freq, 4, FS, N);
+    CHECK(goertzel_bank_process(&bank, block, N) == 1);
+    for (int t = 0; t < 3; t++)
+        CHECK_NEAR(bank.tone[t].level_db, dft_db(freq[t]), 1.0);
+    CHECK_NEAR(bank.tone[0].level_db, 20.0 * log10(16000.0 / 32768.0), 1.0);
+    CHECK(bank.tone[3].level_db < -60);
+
+    // chunked feeding gives the same result as one call
+    int16_t ref_db[4];
+    for (int t = 0; t < 4; t++)
+        ref_db[t] = bank.tone[t].level_db;
+    goertzel_bank_init(&bank, freq, 4, FS, N);
+    int blocks = 0;
+    for (int i = 0; i < N; i += 37)
+        blocks += goertzel_bank_process(&bank, block + i, i + 37 > N ? N - i : 37);
+    CHECK(blocks == 1);
+    for (int t = 0; t < 4; t++)
+        CHECK(bank.tone[t].level_db == ref_db[t]);
+
+    // low frequency tone at full scale : the resonator state stays in int32
+    float low = 50.0f;
+    float full = 32767.0f;
+    make_block(&low, &full, 1, 0);
+    goertzel_bank_init(&bank, &low, 1, FS, N);
+    goertzel_bank_process(&bank, block, N);
+    CHECK_NEAR(bank.tone[0].level_db, dft_db(low), 1.0);
+
+    // cost : N tones per block against one FFT of the block
+    make_block(freq, amp, 3, 50);
+    fft_setup();
+    int reps = 2000;
+    double t0 = test_now_ns();
+    for (int r = 0; r < reps; r++)
+        fft_power(block);
+    double fft_ns = (test_now_ns() - t0) / reps;
+    printf("fft %d + power : %.0f ns / block (%.0f ns / sample)\n", N, fft_ns, fft_ns / N);
+    int peak = 0;
+    for (int k = 1; k < N / 2; k++)
+        peak = fft_pow[k] > fft_pow[peak] ? k : peak;
+    CHECK(peak == (int)lrintf(freq[0] * N / FS)); // the reference FFT is right
+    for (int count = 1; count <= GOERTZEL_MAX_TONES; count++) {
+        goertzel_bank_init(&bank, freq, count, FS, N);
+        t0 = test_now_ns();
+        for (int r = 0; r < reps; r++)
+            goertzel_bank_process(&bank, block, N);
+        double g_ns = (test_now_ns() - t0) / reps;
+        printf("goertzel %d tones : %.0f ns / block (%.2f x fft)\n", count, g_ns, g_ns / fft_ns);
+    }
+
+    return test_result("goertzel");
+}
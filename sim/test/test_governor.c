@@ -0,0 +1,101 @@
+// test_governor.c
+// governor.c driven with simulated stage costs : captures per frame, GOV_SKIP start delay, cost estimates
+// following a step, and a simulated frame loop (core0 captures, core1 renders in parallel) whose frame
+// rate & capture count are printed for a range of render costs
+
+#include "governor.h"
+#include "test.h"
+
+#define CAPTURE_US 10240 // 5120 samples at 500ksps + filter
+#define FFT_US 1500
+#define MAX_AVG 10
+
+// run the loop of governed_run for frames frames, the frame period is max(render, captures * capture)
+// Returns: simulated time [us]
+static uint32_t run_frames(governor *g, int frames, uint32_t capture_us, uint32_t fft_us, uint32_t render_us,
+                           int *captures) {
+    uint32_t time = 0;
+    for (int f = 0; f < frames; f++) {
+        int n = gov_plan(g);
+        uint32_t delay = gov_start_delay(g);
+        uint32_t busy = delay;
+        for (int k = 0; k < n; k++) {
+            gov_add_dsp(g, capture_us, fft_us);
+            busy += capture_us + fft_us;
+        }
+        // core1 renders the previous frame while core0 captures
+        time += busy > render_us ? busy : render_us;
+        gov_add_render(g, render_us);
+        *captures = n;
+    }
+    return time;
+}
+
+int main(void) {
+    governor g;
+    gov_report r;
+
+    // no estimate yet : one capture, no delay
+    gov_init(&g, GOV_AVERAGE, MAX_AVG);
+    CHECK(gov_plan(&g) == 1);
+    CHECK(gov_start_delay(&g) == 0);
+
+    // the render time holds 4 captures
+    gov_add_dsp(&g, CAPTURE_US, FFT_US);
+    gov_add_render(&g, 4 * (CAPTURE_US + FFT_US) + 100);
+    CHECK(gov_plan(&g) == 4);
+    gov_get_report(&g, &r);
+    CHECK(r.captures == 4);
+    CHECK(r.frame_us == 4 * (CAPTURE_US + FFT_US) + 100);
+    CHECK(r.headroom_pct <= 1); // 100us of 47060us
+
+    // max_avg bounds the average, a render faster than one capture still takes one
+    gov_init(&g, GOV_AVERAGE, 3);
+    gov_add_dsp(&g, CAPTURE_US, FFT_US);
+    gov_add_render(&g, 100 * CAPTURE_US);
+    CHECK(gov_plan(&g) == 3);
+    gov_init(&g, GOV_AVERAGE, MAX_AVG);
+    gov_add_dsp(&g, CAPTURE_US, FFT_US);
+    gov_add_render(&g, 1000);
+    CHECK(gov_plan(&g) == 1);
+    gov_get_report(&g, &r);
+    CHECK(r.frame_us == CAPTURE_US + FFT_US);
+    CHECK(r.fps_x10 == (int)(10000000u / (CAPTURE_US + FFT_US)));
+
+    // GOV_SKIP : one capture started just in time, core0 idles for the rest of the render time
+    gov_init(&g, GOV_SKIP, MAX_AVG);
+    gov_add_dsp(&g, CAPTURE_US, FFT_US);
+    gov_add_render(&g, 40000);
+    CHECK(gov_plan(&g) == 1);
+    CHECK(gov_start_delay(&g) == 40000 - CAPTURE_US - FFT_US);
+    gov_get_report(&g, &r);
+    CHECK(r.headroom_pct == 100 - (CAPTURE_US + FFT_US) * 100 / 40000);
+
+    // the estimates follow a step of the render cost (1/8 moving average) : within 2% after 30 frames
+    gov_init(&g, GOV_AVERAGE, MAX_AVG);
+    int captures;
+    run_frames(&g, 50, CAPTURE_US, FFT_US, 20000, &captures);
+    run_frames(&g, 30, CAPTURE_US, FFT_US, 60000, &captures);
+    CHECK(g.render_us > 58800 && g.render_us <= 60000);
+    CHECK(captures == 5);
+
+    // simulated loop : frame rate & captures per frame against the render cost
+    for (int policy = GOV_AVERAGE; policy <= GOV_SKIP; policy++) {
+        for (uint32_t render = 5000; render <= 80000; render *= 2) {
+            gov_init(&g, policy, MAX_AVG);
+            uint32_t time = run_frames(&g, 100, CAPTURE_US, FFT_US, render, &captures);
+            run_frames(&g, 1, CAPTURE_US, FFT_US, render, &captures);
+            gov_get_report(&g, &r);
+            double fps = 100 * 1e6 / time;
+            printf("%s render %5lu us : %5.1f fps (report %d.%d), %d captures, headroom %d%%\n",
+                   policy == GOV_AVERAGE ? "average" : "skip   ", (unsigned long)render, fps, r.fps_x10 / 10,
+                   r.fps_x10 % 10, captures, r.headroom_pct);
+            // the frame never waits for core0 longer than one capture past the render
+            CHECK(time / 100 <= (render > CAPTURE_US + FFT_US ? render : CAPTURE_US + FFT_US) + CAPTURE_US + FFT_US);
+            if (policy == GOV_SKIP)
+                CHECK(captures == 1);
+        }
+    }
+
+    return test_result("governor");
+}
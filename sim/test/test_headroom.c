@@ -0,0 +1,241 @@
+// test_headroom.c
+// headroom.c : hr_block_shift over every peak, hr_peak_q15 & hr_note_adc against per sample references,
+// the spectrum SNR of a Q15 chain (window multiply + a radix-2 Q15 FFT scaled by 1/2 per stage as
+// arm_cfft_q15) against a double reference with BFP off & on, and the per sample cost of the ADC stage :
+// counters inside the Q15 filter loop against the separate hr_note_adc pass
+
+#include "headroom.h"
+#include "test.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define N 512
+#define LOG2N 9
+#define TONE_BIN 20.3
+#define MARGIN_BITS 1 // BFP_MARGIN_BITS
+#define MAX_SHIFT 8   // BFP_MAX_SHIFT
+#define RAW 5120      // RAW_SAMPLES
+
+static int16_t sat16(int32_t v) {
+    return (int16_t)(v > 32767 ? 32767 : v < -32768 ? -32768 : v);
+}
+
+// in place radix-2 DIT FFT, Q15, each stage halves its outputs (1/N overall)
+static void fft_q15(int16_t *re, int16_t *im) {
+    for (int i = 1, j = 0; i < N; i++) {
+        int bit = N >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j |= bit;
+        if (i < j) {
+            int16_t t = re[i];
+            re[i] = re[j];
+            re[j] = t;
+            t = im[i];
+            im[i] = im[j];
+            im[j] = t;
+        }
+    }
+    for (int len = 2; len <= N; len <<= 1) {
+        for (int k = 0; k < len / 2; k++) {
+            int16_t wr = sat16(lrint(32768.0 * cos(2.0 * M_PI * k / len)));
+            int16_t wi = sat16(lrint(-32768.0 * sin(2.0 * M_PI * k / len)));
+            for (int i = k; i < N; i += len) {
+                int j = i + len / 2;
+                int32_t tr = ((int32_t)re[j] * wr - (int32_t)im[j] * wi) >> 15;
+                int32_t ti = ((int32_t)re[j] * wi + (int32_t)im[j] * wr) >> 15;
+                int32_t ar = re[i], ai = im[i];
+                re[i] = (int16_t)((ar + tr) >> 1);
+                im[i] = (int16_t)((ai + ti) >> 1);
+                re[j] = (int16_t)((ar - tr) >> 1);
+                im[j] = (int16_t)((ai - ti) >> 1);
+            }
+        }
+    }
+}
+
+// spectrum SNR [dB] of a tone of amp ADC LSB through the Q15 chain, against the same window & FFT in double
+static double chain_snr(double amp, int bfp, hr_telemetry *t) {
+    static int16_t q[N], hann[N], re[N], im[N];
+    static double ref_re[N / 2], ref_im[N / 2];
+
+    for (int n = 0; n < N; n++) {
+        hann[n] = (int16_t)(0.5 * (1.0 - cos(2.0 * M_PI * n / (N - 1))) * 32767.0);
+        q[n] = (int16_t)(lrint(amp * sin(2.0 * M_PI * TONE_BIN * n / N + 0.3)) << 3); // filter Q15 scaling
+    }
+    uint32_t clips = 0;
+    uint16_t peak = hr_peak_q15(q, N, &clips);
+    hr_note(t, HR_FILTER, peak, clips);
+    int shift = bfp ? hr_block_shift(peak, MARGIN_BITS, MAX_SHIFT) : 0;
+    hr_note_shift(t, shift);
+    for (int n = 0; n < N; n++) {
+        re[n] = sat16(((int32_t)q[n] * hann[n]) >> (15 - shift));
+        im[n] = 0;
+    }
+    clips = 0;
+    hr_note(t, HR_WINDOW, hr_peak_q15(re, N, &clips), clips);
+
+    // reference : the Q15 window product without rounding, DFT / N
+    for (int k = 0; k < N / 2; k++) {
+        double sr = 0.0, si = 0.0;
+        for (int n = 0; n < N; n++) {
+            double x = (double)q[n] * hann[n] / 32768.0;
+            sr += x * cos(2.0 * M_PI * k * n / N);
+            si -= x * sin(2.0 * M_PI * k * n / N);
+        }
+        ref_re[k] = sr / N;
+        ref_im[k] = si / N;
+    }
+
+    fft_q15(re, im);
+    clips = 0;
+    hr_note(t, HR_FFT, hr_peak_q15(re, N, &clips), clips);
+
+    double sig = 0.0, err = 0.0;
+    double scale = ldexp(1.0, -shift);
+    for (int k = 0; k < N / 2; k++) {
+        double er = re[k] * scale - ref_re[k], ei = im[k] * scale - ref_im[k];
+        sig += ref_re[k] * ref_re[k] + ref_im[k] * ref_im[k];
+        err += er * er + ei * ei;
+    }
+    return 10.0 * log10(sig / err);
+}
+
+// Q15 filter loop of dsp.c (filter_chunk_q15), with or without the per sample ADC counters it used to carry
+static int16_t filtered[N];
+static volatile int32_t sink;
+static __attribute__((noinline)) void filter_q15(const uint16_t *src, int n, int counters, int32_t *adc_peak, uint32_t *rails) {
+    int16_t prev = 0;
+    int phase = 0, out = 0;
+    int32_t pk = 0;
+    uint32_t rl = 0;
+    for (int i = 0; i < n; i++) {
+        int32_t centered = (int32_t)src[i] - 2048;
+        int16_t sample = sat16(centered << 3);
+        if (counters) {
+            int32_t mag = centered < 0 ? -centered : centered;
+            pk = mag > pk ? mag : pk;
+            rl += (uint16_t)(src[i] - 1) >= HR_ADC_MAX - 1;
+        }
+        prev = sat16(((int32_t)sample * 8192 + (int32_t)prev * (32768 - 8192)) >> 15);
+        if (phase == 0 && out < N)
+            filtered[out++] = prev;
+        if (++phase == 10)
+            phase = 0;
+    }
+    *adc_peak = pk;
+    *rails = rl;
+}
+
+int main(void) {
+    hr_telemetry t;
+
+    // the shift is the largest one keeping peak << shift under full scale with the margin, for every peak
+    for (int margin = 0; margin <= 2; margin++) {
+        for (int max_shift = 0; max_shift <= MAX_SHIFT; max_shift++) {
+            int32_t limit = 32767 >> margin;
+            int bad = 0;
+            for (int32_t peak = 0; peak <= 32768; peak++) {
+                int s = hr_block_shift((uint16_t)peak, margin, max_shift);
+                bad += s < 0 || s > max_shift;
+                bad += s > 0 && (peak << s) > limit;
+                bad += s < max_shift && (peak << (s + 1)) <= limit;
+            }
+            CHECK(bad == 0);
+        }
+    }
+    CHECK(hr_block_shift(0, MARGIN_BITS, MAX_SHIFT) == MAX_SHIFT);
+    CHECK(hr_block_shift(16384, 0, MAX_SHIFT) == 0);
+    CHECK(hr_block_shift(16383, 0, MAX_SHIFT) == 1);
+
+    // peak & clips of a Q15 block
+    int16_t q[8] = {0, 100, -200, 32767, -32768, -32767, 5, 7};
+    uint32_t clips = 10;
+    CHECK(hr_peak_q15(q, 8, &clips) == 32768 && clips == 13);
+    CHECK(hr_peak_q15(q, 3, NULL) == 200);
+    CHECK_NEAR(hr_peak_dbfs(16384), -6.02, 0.01);
+    CHECK(hr_peak_dbfs(0) == -99.0f);
+
+    // hr_note_adc against a per sample reference, chunked or whole, with & without the rails
+    static uint16_t raw[RAW];
+    srand(7);
+    for (int trial = 0; trial < 200; trial++) {
+        int amp = 1 + rand() % 2600; // past the rails from 2048
+        for (int i = 0; i < RAW; i++) {
+            int v = 2048 + (int)lrint(amp * sin(2.0 * M_PI * (trial + 3) * i / RAW)) + rand() % 5 - 2;
+            raw[i] = (uint16_t)(v < 0 ? 0 : v > HR_ADC_MAX ? HR_ADC_MAX : v);
+        }
+        int32_t peak = 0;
+        uint32_t rails = 0;
+        for (int i = 0; i < RAW; i++) {
+            int32_t m = abs((int32_t)raw[i] - 2048);
+            peak = m > peak ? m : peak;
+            rails += raw[i] == 0 || raw[i] == HR_ADC_MAX;
+        }
+        hr_reset(&t);
+        hr_note_adc(&t, raw, RAW);
+        CHECK(t.stage[HR_ADC].peak == peak << 3 && t.stage[HR_ADC].clips == rails);
+        hr_reset(&t);
+        for (int i = 0; i < RAW; i += 8)
+            hr_note_adc(&t, raw + i, 8);
+        CHECK(t.stage[HR_ADC].peak == peak << 3 && t.stage[HR_ADC].clips == rails);
+    }
+
+    // shift range of the report
+    hr_reset(&t);
+    hr_note_shift(&t, 3);
+    hr_note_shift(&t, 1);
+    hr_note_shift(&t, 5);
+    CHECK(t.shift_min == 1 && t.shift_max == 5 && t.blocks == 3);
+
+    // Q15 chain against the double reference : BFP keeps the bits of small tones, nothing clips
+    double amps[4] = {2000.0, 300.0, 40.0, 6.0};
+    double snr[2][4];
+    hr_telemetry tel[2];
+    for (int bfp = 0; bfp <= 1; bfp++) {
+        hr_reset(&tel[bfp]);
+        for (int a = 0; a < 4; a++)
+            snr[bfp][a] = chain_snr(amps[a], bfp, &tel[bfp]);
+    }
+    printf("amp (LSB) |");
+    for (int a = 0; a < 4; a++)
+        printf(" %6.0f", amps[a]);
+    printf("\n");
+    for (int bfp = 0; bfp <= 1; bfp++) {
+        printf("BFP %s   |", bfp ? "on " : "off");
+        for (int a = 0; a < 4; a++)
+            printf(" %6.1f", snr[bfp][a]);
+        printf(" dB, shift %d..%d\n", tel[bfp].shift_min, tel[bfp].shift_max);
+        for (int s = HR_FILTER; s <= HR_FFT; s++)
+            CHECK(tel[bfp].stage[s].clips == 0);
+    }
+    CHECK(fabs(snr[1][0] - snr[0][0]) < 1.0); // a large tone gets no shift
+    for (int a = 1; a < 4; a++)
+        CHECK(snr[1][a] > snr[0][a] + 10.0);
+
+    // cost of the ADC stage per sample : inline counters in the filter loop, or a separate pass
+    for (int i = 0; i < RAW; i++)
+        raw[i] = (uint16_t)(2048 + lrint(1500.0 * sin(2.0 * M_PI * 31.0 * i / RAW)));
+    int32_t pk;
+    uint32_t rl;
+    double ns[3] = {0.0, 0.0, 0.0};
+    for (int round = 0; round < 5; round++) {
+        for (int v = 0; v < 3; v++) {
+            int reps = 2000;
+            double t0 = test_now_ns();
+            for (int r = 0; r < reps; r++) {
+                filter_q15(raw, RAW, v == 1, &pk, &rl);
+                if (v == 2)
+                    hr_note_adc(&t, raw, RAW);
+                sink = filtered[r & (N - 1)] + pk + (int32_t)rl;
+            }
+            double d = (test_now_ns() - t0) / reps / RAW;
+            ns[v] = round == 0 || d < ns[v] ? d : ns[v];
+        }
+    }
+    printf("Q15 filter : %.2f ns / sample, inline ADC counters %.2f (+%.0f%%), separate hr_note_adc pass %.2f "
+           "(+%.0f%%) (host, best of 5)\n",
+           ns[0], ns[1], 100.0 * (ns[1] / ns[0] - 1.0), ns[2], 100.0 * (ns[2] / ns[0] - 1.0));
+
+    return test_result("headroom");
+}
@@ -0,0 +1,115 @@
+// test_marker.c
+// marker.c : frequency & level accuracy of the three interpolations on Hann windowed tones between bins,
+// top N order & marker_delta, tracking of a moving tone, and the cost of marker_update per frame with
+// the background search budget of dsp.c against a full search of every frame
+
+#include "marker.h"
+#include "test.h"
+#include <math.h>
+
+#define N 512
+#define NBINS (N / 2)
+#define BIN_HZ 97.65625f // 50ksps / 512
+#define SCAN_BINS 64      // MARKER_SCAN_BINS
+
+static float power[NBINS];
+
+// power spectrum of a sum of tones (amplitudes relative to full scale) with the Hann window of dsp.c,
+// scaled as fft_power (a full scale sine at a bin centre : 1/16 → the window gain 1/2 squared / 4)
+static void make_spectrum(const double *bin, const double *amp, int count) {
+    static double x[N], w[N];
+    for (int n = 0; n < N; n++) {
+        w[n] = 0.5 * (1.0 - cos(2.0 * M_PI * n / (N - 1)));
+        x[n] = 0.0;
+        for (int t = 0; t < count; t++)
+            x[n] += amp[t] * sin(2.0 * M_PI * bin[t] * n / N + 0.7 * t);
+    }
+    for (int k = 0; k < NBINS; k++) {
+        double re = 0.0, im = 0.0;
+        for (int n = 0; n < N; n++) {
+            re += x[n] * w[n] * cos(2.0 * M_PI * k * n / N);
+            im -= x[n] * w[n] * sin(2.0 * M_PI * k * n / N);
+        }
+        power[k] = (float)((re * re + im * im) / ((double)N * N));
+    }
+}
+
+// every frame is searched completely (the markers are set at the end of each search)
+static void full_update(marker_state *m) {
+    marker_update(m, power, NBINS);
+}
+
+int main(void) {
+    marker_state m;
+    const char *name[3] = {"parabolic", "gaussian", "hann"};
+    double tol_bin[3] = {0.1, 0.05, 0.01};
+    double tol_db[3] = {0.5, 0.2, 0.1};
+    double ref_db = 10.0 * log10(0.5 * 0.5 * 0.25 * 0.25); // amplitude 0.5 at a bin centre
+
+    // accuracy : one tone at 20 .. 21 bins, 0.05 bin steps
+    for (int interp = MARKER_INTERP_PARABOLIC; interp <= MARKER_INTERP_HANN; interp++) {
+        double err_bin = 0.0, err_db = 0.0;
+        for (int s = 0; s <= 20; s++) {
+            double bin = 20.0 + 0.05 * s;
+            double amp = 0.5;
+            make_spectrum(&bin, &amp, 1);
+            marker_init(&m, NBINS, BIN_HZ, 1, interp, 1e-9f);
+            full_update(&m);
+            CHECK(m.peak[0].active);
+            double e = fabs(m.peak[0].bin - bin);
+            err_bin = e > err_bin ? e : err_bin;
+            e = fabs(10.0 * log10(m.peak[0].power) - ref_db);
+            err_db = e > err_db ? e : err_db;
+            CHECK_NEAR(m.peak[0].freq, m.peak[0].bin * BIN_HZ, 0.01);
+        }
+        printf("%-9s : max error %.3f bins (%.1f Hz), %.2f dB\n", name[interp], err_bin, err_bin * BIN_HZ, err_db);
+        CHECK(err_bin < tol_bin[interp]);
+        CHECK(err_db < tol_db[interp]);
+    }
+
+    // top 3 sorted by power, deltas against M1
+    double bins[3] = {30.3, 80.6, 150.2};
+    double amps[3] = {0.1, 0.5, 0.01};
+    make_spectrum(bins, amps, 3);
+    marker_init(&m, NBINS, BIN_HZ, 3, MARKER_INTERP_HANN, 1e-9f);
+    full_update(&m);
+    CHECK_NEAR(m.peak[0].bin, 80.6, 0.05);
+    CHECK_NEAR(m.peak[1].bin, 30.3, 0.05);
+    CHECK_NEAR(m.peak[2].bin, 150.2, 0.05);
+    float dfreq, ratio;
+    CHECK(marker_delta(&m, 1, &dfreq, &ratio));
+    CHECK_NEAR(dfreq, (30.3 - 80.6) * BIN_HZ, 0.05 * BIN_HZ);
+    CHECK_NEAR(10.0 * log10(ratio), -14.0, 0.2);
+    CHECK(marker_delta(&m, 2, &dfreq, &ratio));
+    CHECK_NEAR(10.0 * log10(ratio), -34.0, 0.2);
+    m.peak[0].active = false;
+    CHECK(!marker_delta(&m, 1, &dfreq, &ratio));
+
+    // tracking : a tone moving 0.5 bin per frame is followed between the background searches
+    double bin = 40.0, amp = 0.5;
+    make_spectrum(&bin, &amp, 1);
+    marker_init(&m, NBINS, BIN_HZ, 1, MARKER_INTERP_HANN, 1e-9f);
+    for (int f = 0; f < NBINS / SCAN_BINS; f++)
+        marker_update(&m, power, SCAN_BINS);
+    CHECK(m.peak[0].active);
+    for (int f = 0; f < 20; f++) {
+        bin += 0.5;
+        make_spectrum(&bin, &amp, 1);
+        marker_update(&m, power, SCAN_BINS);
+        CHECK(m.peak[0].active);
+        CHECK_NEAR(m.peak[0].bin, bin, 0.05);
+    }
+
+    // cost per frame : tracking + SCAN_BINS of background search, against a full search
+    make_spectrum(bins, amps, 3);
+    int reps = 100000;
+    for (int scan = SCAN_BINS; scan <= NBINS; scan *= 4) {
+        marker_init(&m, NBINS, BIN_HZ, 3, MARKER_INTERP_HANN, 1e-9f);
+        double t0 = test_now_ns();
+        for (int r = 0; r < reps; r++)
+            marker_update(&m, power, scan);
+        printf("marker_update, %3d bins searched per frame : %.0f ns\n", scan, (test_now_ns() - t0) / reps);
+    }
+
+    return test_result("marker");
+}
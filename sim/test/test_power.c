@@ -0,0 +1,118 @@
+// test_power.c
+// power.c driven with simulated frame loads & signal levels : clock stepping (the load scales with the
+// clock), no step down when the predicted load misses the budget, quiet frame counting, dormant entry &
+// the wake hysteresis, duty cycle accounting, and power_rms_* against a float reference
+
+#include "power.h"
+#include "test.h"
+#include <math.h>
+
+#define BUDGET_US 20000
+#define QUIET_RMS 100
+#define WAKE_RMS 200
+#define QUIET_FRAMES 5
+
+static const uint32_t clocks[3] = {150000, 100000, 75000};
+
+// run frames with a load of base_us at the fastest clock, scaled to the current clock
+// Returns: clock level after the frames
+static int run_frames(power_policy *p, int frames, uint32_t base_us, uint32_t rms) {
+    for (int f = 0; f < frames; f++) {
+        uint32_t load = (uint32_t)((uint64_t)base_us * p->clock_khz[0] / p->clock_khz[p->level]);
+        power_frame(p, load, rms);
+    }
+    return p->level;
+}
+
+int main(void) {
+    power_policy p;
+    power_report r;
+
+    // 30% at 150MHz : 45% at 100MHz, 60% at 75MHz, both under load_high_pct → down to 75MHz one level per frame
+    power_init(&p, clocks, 3, BUDGET_US, QUIET_RMS, WAKE_RMS, QUIET_FRAMES);
+    CHECK(p.level == 0);
+    CHECK(power_frame(&p, 6000, 1000) && p.level == 1);
+    CHECK(power_frame(&p, 9000, 1000) && p.level == 2);
+    CHECK(!power_frame(&p, 12000, 1000) && p.level == 2);
+    // the load rises to 55% at 150MHz : 110% at 75MHz, 82% at 100MHz → back to 150MHz, where it stays
+    CHECK(run_frames(&p, 10, 11000, 1000) == 0);
+    CHECK(!power_frame(&p, 11000, 1000));
+    // between load_low_pct & load_high_pct : no change
+    power_init(&p, clocks, 3, BUDGET_US, QUIET_RMS, WAKE_RMS, QUIET_FRAMES);
+    CHECK(run_frames(&p, 10, 12000, 1000) == 0);
+
+    // 35% is under load_low_pct, but 105% predicted at 50MHz : no step down
+    const uint32_t two[2] = {150000, 50000};
+    power_init(&p, two, 2, BUDGET_US, QUIET_RMS, WAKE_RMS, QUIET_FRAMES);
+    CHECK(run_frames(&p, 10, 7000, 1000) == 0);
+    CHECK(run_frames(&p, 1, 5000, 1000) == 1); // 75% predicted
+
+    // levels are clamped to POWER_MAX_LEVELS, wake_rms to quiet_rms
+    const uint32_t many[6] = {150000, 125000, 100000, 75000, 50000, 25000};
+    power_init(&p, many, 6, BUDGET_US, QUIET_RMS, QUIET_RMS / 2, QUIET_FRAMES);
+    CHECK(p.levels == POWER_MAX_LEVELS && p.wake_rms == QUIET_RMS);
+
+    // dormant : QUIET_FRAMES consecutive quiet frames, a loud frame restarts the count
+    power_init(&p, clocks, 3, BUDGET_US, QUIET_RMS, WAKE_RMS, QUIET_FRAMES);
+    for (int f = 0; f < QUIET_FRAMES - 1; f++)
+        CHECK(!power_frame(&p, 12000, QUIET_RMS - 1));
+    CHECK(!power_frame(&p, 12000, QUIET_RMS));
+    CHECK(p.state == POWER_RUN && p.quiet_count == 0);
+    for (int f = 0; f < QUIET_FRAMES - 1; f++)
+        CHECK(!power_frame(&p, 12000, QUIET_RMS - 1));
+    CHECK(power_frame(&p, 12000, QUIET_RMS - 1));
+    CHECK(p.state == POWER_DORMANT && p.level == 2 && p.dormant_entries == 1);
+    // frames are ignored while dormant, only the probes count
+    CHECK(!power_frame(&p, 30000, 5000) && p.state == POWER_DORMANT);
+    // hysteresis : between quiet_rms & wake_rms the policy stays dormant
+    CHECK(!power_probe(&p, QUIET_RMS + 1));
+    CHECK(!power_probe(&p, WAKE_RMS));
+    CHECK(power_probe(&p, WAKE_RMS + 1));
+    CHECK(p.state == POWER_RUN && p.level == 0);
+    CHECK(!power_probe(&p, 5000)); // already running
+    // a second entry is counted
+    run_frames(&p, QUIET_FRAMES, 12000, 0);
+    CHECK(p.state == POWER_DORMANT && p.dormant_entries == 2);
+
+    // duty cycle : busy share of the accounted time, the accounting restarts at each report
+    power_init(&p, clocks, 3, BUDGET_US, QUIET_RMS, WAKE_RMS, QUIET_FRAMES);
+    power_get_report(&p, &r);
+    CHECK(r.duty_x10 == 1000); // nothing accounted : reported busy
+    power_account(&p, 300, 600);
+    power_account(&p, 0, 100);
+    power_get_report(&p, &r);
+    CHECK(r.duty_x10 == 300 && r.clock_khz == 150000 && r.state == POWER_RUN);
+    power_account(&p, 4000000000u, 1000000u); // 1 hour of 32bit us, no overflow in the ratio
+    power_get_report(&p, &r);
+    CHECK(r.duty_x10 == 999);
+
+    // RMS of a -12dBFS sine with a DC offset, the mean is removed : 8192 / sqrt(2)
+    static int16_t q15[512];
+    static int32_t q31[512];
+    static float f32[512];
+    for (int i = 0; i < 512; i++) {
+        double v = 8192.0 * sin(2.0 * M_PI * 16.0 * i / 512.0) + 3000.0;
+        q15[i] = (int16_t)lrint(v);
+        q31[i] = (int32_t)lrint(v * 65536.0);
+        f32[i] = (float)(v / 32768.0);
+    }
+    double ref = 8192.0 / sqrt(2.0);
+    CHECK_NEAR(power_rms_q15(q15, 512), ref, 2.0);
+    CHECK_NEAR(power_rms_q31(q31, 512), ref, 2.0);
+    CHECK_NEAR(power_rms_f32(f32, 512), ref, 2.0);
+    CHECK(power_rms_q15(q15, 0) == 0);
+    printf("rms : q15 %lu, q31 %lu, f32 %lu, reference %.1f\n", (unsigned long)power_rms_q15(q15, 512),
+           (unsigned long)power_rms_q31(q31, 512), (unsigned long)power_rms_f32(f32, 512), ref);
+
+    // settled clock against the frame load at 150MHz
+    for (uint32_t base = 2000; base <= 16000; base += 2000) {
+        power_init(&p, clocks, 3, BUDGET_US, QUIET_RMS, WAKE_RMS, QUIET_FRAMES);
+        int level = run_frames(&p, 20, base, 1000);
+        uint32_t load = (uint32_t)((uint64_t)base * clocks[0] / clocks[level]);
+        printf("load %5lu us at 150MHz : %3lu MHz, %2lu%% of the %d us budget\n", (unsigned long)base,
+               (unsigned long)(clocks[level] / 1000), (unsigned long)(load * 100 / BUDGET_US), BUDGET_US);
+        CHECK(load * 100 <= (uint32_t)p.load_high_pct * BUDGET_US);
+    }
+
+    return test_result("power");
+}
@@ -0,0 +1,140 @@
+// test_readout.c
+// readout.c : fmt_int / fmt_fixed against snprintf (whole int32 range), dirty cell redraw, and the pixels
+// sent per frame by the fps / peak / Vpp readouts of dsp.c against a full redraw of the same fields.
+// lcd_draw_char is a host mock counting cells & pixels (an opaque cell is 5 x 8 x size^2 pixels)
+
+#include "readout.h"
+#include "test.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FRAMES 1000
+#define SPI_HZ 62500000.0 // LCD SPI clock, 16 bits per pixel
+
+static int cells;
+static long pixels;
+static int16_t last_x;
+static char last_c;
+
+void lcd_draw_char(int16_t x, int16_t y, char c, uint16_t color, uint16_t bg, uint8_t size) {
+    (void)y;
+    (void)color;
+    (void)bg;
+    cells++;
+    pixels += 5 * 8 * size * size;
+    last_x = x;
+    last_c = c;
+}
+
+static void check_int(int32_t v) {
+    char buf[16], ref[16];
+    int len = fmt_int(buf, v);
+    snprintf(ref, sizeof(ref), "%ld", (long)v);
+    CHECK(strcmp(buf, ref) == 0);
+    CHECK(len == (int)strlen(ref));
+}
+
+static void check_fixed(int32_t v, int decimals) {
+    char buf[16], ref[32]; // ref : the compiler can't bound m / div & m % div
+    int len = fmt_fixed(buf, v, decimals);
+    int64_t div = 1;
+    for (int i = 0; i < decimals; i++)
+        div *= 10;
+    int64_t m = v < 0 ? -(int64_t)v : v;
+    if (decimals > 0)
+        snprintf(ref, sizeof(ref), "%s%lld.%0*lld", v < 0 ? "-" : "", (long long)(m / div), decimals,
+                 (long long)(m % div));
+    else
+        snprintf(ref, sizeof(ref), "%s%lld", v < 0 ? "-" : "", (long long)m);
+    if (strcmp(buf, ref) != 0)
+        printf("fmt_fixed(%ld, %d) : \"%s\", expected \"%s\"\n", (long)v, decimals, buf, ref);
+    CHECK(strcmp(buf, ref) == 0);
+    CHECK(len == (int)strlen(ref));
+}
+
+// text of the readouts of dsp.c for one frame
+static void frame_text(int f, char *fps, char *peak, char *vpp) {
+    int len = fmt_fixed(fps, 600 + rand() % 5, 1); // 60.0 .. 60.4fps
+    strcpy(fps + len, "fps");
+    int hz = 2343 + (f / 50) * 98;                  // peak moves every 50 frames
+    len = fmt_int(peak, hz);
+    strcpy(peak + len, "Hz ");
+    len += 3;
+    len += fmt_int(peak + len, -6 - rand() % 2);
+    strcpy(peak + len, "db");
+    strcpy(vpp, "Vpp ");
+    len = 4 + fmt_fixed(vpp + 4, 1650 + rand() % 8, 3);
+    strcpy(vpp + len, "V");
+}
+
+// Returns: pixels sent for FRAMES frames
+static long run_frames(int full) {
+    readout fps, peak, vpp;
+    readout_init(&fps, 0, 0, 8, 0xFFFF, 0, 1);
+    readout_init(&peak, 120, 0, 14, 0xFFFF, 0, 1);
+    readout_init(&vpp, 0, 220, 11, 0xFFFF, 0, 1);
+    srand(2);
+    pixels = 0;
+    cells = 0;
+    char t_fps[24], t_peak[24], t_vpp[24];
+    for (int f = 0; f < FRAMES; f++) {
+        frame_text(f, t_fps, t_peak, t_vpp);
+        if (full) {
+            readout_invalidate(&fps);
+            readout_invalidate(&peak);
+            readout_invalidate(&vpp);
+        }
+        readout_set(&fps, t_fps);
+        readout_set(&peak, t_peak);
+        readout_set(&vpp, t_vpp);
+    }
+    return pixels;
+}
+
+int main(void) {
+    // formatting
+    int32_t ints[] = {0, 1, -1, 9, 10, -10, 12345, -98765, INT32_MAX, INT32_MIN, INT32_MIN + 1};
+    for (unsigned i = 0; i < sizeof(ints) / sizeof(ints[0]); i++) {
+        check_int(ints[i]);
+        for (int d = 0; d <= 9; d++)
+            check_fixed(ints[i], d);
+    }
+    srand(1);
+    for (int i = 0; i < 100000; i++) {
+        int32_t v = (int32_t)((uint32_t)rand() << 16 ^ (uint32_t)rand());
+        check_int(v);
+        check_fixed(v, i % 10);
+    }
+
+    // only the changed cells are drawn, a shorter text is padded with spaces
+    readout r;
+    readout_init(&r, 10, 20, 8, 0xFFFF, 0, 2);
+    cells = 0;
+    CHECK(readout_set(&r, "12.3fps") == 8);
+    CHECK(cells == 8 && last_c == ' ' && last_x == 10 + 7 * 12);
+    cells = 0;
+    CHECK(readout_set(&r, "12.4fps") == 1);
+    CHECK(cells == 1 && last_c == '4' && last_x == 10 + 3 * 12);
+    CHECK(readout_set(&r, "12.4fps") == 0);
+    CHECK(readout_set(&r, "9.9fps") == 7); // "12.4fps " → "9.9fps  " : only the last blank stays
+    CHECK(strcmp(r.text, "9.9fps  ") == 0);
+    readout_invalidate(&r);
+    CHECK(readout_set(&r, "9.9fps") == 8);
+
+    // pixels per frame of the three spectrum readouts, cached against a full redraw
+    long cached = run_frames(0);
+    int cached_cells = cells;
+    long full = run_frames(1);
+    int full_cells = cells;
+    printf("readouts : %.1f cells %.0f pixels / frame (%.1f us SPI), full redraw %.1f cells %.0f pixels (%.1f us)\n",
+           (double)cached_cells / FRAMES, (double)cached / FRAMES, cached * 16.0 / SPI_HZ * 1e6 / FRAMES,
+           (double)full_cells / FRAMES, (double)full / FRAMES, full * 16.0 / SPI_HZ * 1e6 / FRAMES);
+    CHECK(cached * 3 < full);
+
+    double t0 = test_now_ns();
+    run_frames(0);
+    printf("format + readout_set : %.0f ns / frame (3 fields, mock LCD)\n", (test_now_ns() - t0) / FRAMES);
+
+    return test_result("readout");
+}
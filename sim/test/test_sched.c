@@ -0,0 +1,146 @@
+// test_sched.c
+// sched.c : acquire_waits counting, then a stress run on two host threads standing in for the cores
+// (core0 : acquisition + DSP chunks, core1 : DSP chunks + render, as stage_run / core1 of dsp.c).
+// Checks the blocks are rendered in capture order with their own data, the chunks of a block run in order
+// and never on both cores at once. The scheduler cost per block (queue & lock operations of the 3 stages)
+// is timed on one thread
+
+#include "sched.h"
+#include "test.h"
+#include <pthread.h>
+
+#define BLOCKS 3
+#define CHUNKS 3
+#define FRAMES 20000
+
+static uint32_t host_us(void) {
+    return (uint32_t)(test_now_ns() / 1000.0);
+}
+
+// __wfe on the target : an idle thread gives the CPU up (the host may have a single CPU). sched_yield()
+// is out of reach, the repo sched.h shadows <sched.h>
+static void idle(void) {
+    struct timespec t = {0, 1000};
+    nanosleep(&t, NULL);
+}
+
+static sched stage;
+static uint32_t block_seq[BLOCKS];   // capture sequence number written by the acquisition
+static int block_chunk[BLOCKS];      // last chunk run on the block
+static atomic_int in_chunk;          // chunks running at the same time
+static atomic_int chunk_errors, render_errors;
+static atomic_uint rendered;         // the main thread waits for the last render
+static atomic_bool done;
+
+static void dsp(void *ctx, int block, int chunk) {
+    (void)ctx;
+    if (atomic_fetch_add(&in_chunk, 1) != 0)
+        chunk_errors++;
+    if (chunk != block_chunk[block] + 1)
+        chunk_errors++;
+    block_chunk[block] = chunk;
+    atomic_fetch_sub(&in_chunk, 1);
+}
+
+static bool render(void *ctx, int block, int step) {
+    (void)ctx;
+    (void)step;
+    if (block_chunk[block] != CHUNKS - 1 || block_seq[block] != rendered)
+        render_errors++;
+    rendered++;
+    return true;
+}
+
+static void *core1(void *arg) {
+    (void)arg;
+    while (!atomic_load(&done)) {
+        bool ran = sched_dsp_poll(&stage, 1);
+        ran |= sched_render_poll(&stage, 1);
+        if (!ran)
+            idle();
+    }
+    return NULL;
+}
+
+static bool render_none(void *ctx, int block, int step) {
+    (void)ctx;
+    (void)block;
+    (void)step;
+    return true;
+}
+
+int main(void) {
+    // a blocked acquisition is one wait however many times it polls
+    sched_config cfg = {2, 1, dsp, render_none, host_us, NULL};
+    sched_init(&stage, &cfg);
+    int a = sched_acquire_begin(&stage);
+    int b = sched_acquire_begin(&stage);
+    CHECK(a >= 0 && b >= 0);
+    for (int i = 0; i < 1000; i++)
+        CHECK(sched_acquire_begin(&stage) < 0);
+    sched_stats st;
+    sched_get_stats(&stage, &st);
+    CHECK(st.acquire_waits == 1);
+    sched_acquire_end(&stage, a);
+    block_chunk[a] = -1;
+    CHECK(sched_dsp_poll(&stage, 0));
+    CHECK(sched_render_poll(&stage, 0));
+    a = sched_acquire_begin(&stage);
+    CHECK(a >= 0);
+    CHECK(sched_acquire_begin(&stage) < 0);
+    CHECK(sched_acquire_begin(&stage) < 0);
+    sched_get_stats(&stage, &st);
+    CHECK(st.acquire_waits == 2);
+
+    // stress : FRAMES blocks through the three stages on two threads
+    sched_config cfg2 = {BLOCKS, CHUNKS, dsp, render, host_us, NULL};
+    sched_init(&stage, &cfg2);
+    chunk_errors = 0;
+    pthread_t thread;
+    pthread_create(&thread, NULL, core1, NULL);
+
+    double t0 = test_now_ns();
+    uint32_t seq = 0;
+    int acq = -1;
+    while (seq < FRAMES || rendered < FRAMES) {
+        if (acq < 0 && seq < FRAMES)
+            acq = sched_acquire_begin(&stage);
+        if (acq >= 0) {
+            block_seq[acq] = seq++;
+            block_chunk[acq] = -1;
+            sched_acquire_end(&stage, acq);
+            acq = -1;
+        }
+        if (!sched_dsp_poll(&stage, 0))
+            idle();
+    }
+    atomic_store(&done, true);
+    pthread_join(thread, NULL);
+
+    sched_get_stats(&stage, &st);
+    CHECK(chunk_errors == 0);
+    CHECK(render_errors == 0);
+    CHECK(st.frames == FRAMES);
+    CHECK(st.dsp_chunks[0] + st.dsp_chunks[1] == (uint32_t)FRAMES * CHUNKS);
+    CHECK(st.acquire_waits <= FRAMES);
+    printf("%d blocks : chunks core0 %lu core1 %lu, acquire waits %lu\n", FRAMES, (unsigned long)st.dsp_chunks[0],
+           (unsigned long)st.dsp_chunks[1], (unsigned long)st.acquire_waits);
+
+    // cost : one block through acquire, CHUNKS DSP chunks & one render step, no work in the stages
+    sched_init(&stage, &cfg2);
+    rendered = 0;
+    t0 = test_now_ns();
+    for (uint32_t i = 0; i < FRAMES; i++) {
+        acq = sched_acquire_begin(&stage);
+        block_seq[acq] = i;
+        block_chunk[acq] = -1;
+        sched_acquire_end(&stage, acq);
+        for (int c = 0; c < CHUNKS; c++)
+            sched_dsp_poll(&stage, 0);
+        sched_render_poll(&stage, 0);
+    }
+    printf("scheduler : %.0f ns / block (%d chunks)\n", (test_now_ns() - t0) / FRAMES, CHUNKS);
+    CHECK(render_errors == 0 && rendered == FRAMES);
+
+    return test_result("sched");
+}
@@ -0,0 +1,24 @@
+// sram_hot.h
+// placement of the hot path out of the XIP flash (cmake -DDSP_SRAM_HOT=ON)
+// __hot_func : striped SRAM (.time_critical, copied by the boot code), flash without the option
+// __core0_func : SCRATCH_Y with the option (the bank of the core0 stack, not touched by core1),
+//                striped SRAM without it (the capture loops never ran from flash)
+// __core1_func : SCRATCH_X with the option (the bank of the core1 stack), flash without it
+// Each scratch bank is 4KB, 2KB of it is the stack of its core
+
+#ifndef SRAM_HOT_H
+#define SRAM_HOT_H
+
+#include "pico/stdlib.h"
+
+#if DSP_SRAM_HOT
+#define __hot_func(func_name) __not_in_flash_func(func_name)
+#define __core0_func(func_name) __scratch_y(__STRING(func_name)) func_name
+#define __core1_func(func_name) __scratch_x(__STRING(func_name)) func_name
+#else
+#define __hot_func(func_name) func_name
+#define __core0_func(func_name) __not_in_flash_func(func_name)
+#define __core1_func(func_name) func_name
+#endif
+
+#endif // SRAM_HOT_H